@@ -35,8 +35,23 @@
 #define CMD_ENENT	(-10000)	/* Command not found */
 
 
+struct cmd_args;
+
+
 /* Parse and run command */
 int cmd_run(char *cmd_str);
 
 
+/* Run command with parsed arguments */
+int cmd_exec(struct cmd_args *args);
+
+
+/* Print invalid argument error */
+void cmd_bad_arg(const char *arg);
+
+
+/* Convert argument to unsigned, print error if it is invalid */
+int cmd_arg2u(const char *arg, unsigned *v);
+
+
 #endif /* _BOOTROM_CMD_H_ */
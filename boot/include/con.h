@@ -84,6 +84,16 @@ char con_getc_b()
 void con_putc(char ch);
 
 
+/* Put char without blocking
+ * Returns 0 on success or -1 if output buffer is full.
+ */
+int con_try_putc(char ch);
+
+
+/* Wait until all output is transmitted */
+void con_flush();
+
+
 /* Put string */
 void con_puts(const char* str);
 
@@ -34,4 +34,39 @@
 #define CONFIG_CONIOBUF_SZ		(80)	/* Size of console I/O buffer */
 
 
+/* Optional commands. Disabled ones are not built to fit 32K ROM. Default
+ * build takes about 31K, each option adds 1.3K-2.2K. Only with
+ * CONFIG_UART_IRQ=0 one of membench, crcbench or xsend fits.
+ */
+#define CONFIG_MEMBENCH			0	/* membench: memory routines benchmark */
+#define CONFIG_RPC			0	/* Binary RPC mode of console */
+#define CONFIG_XSEND			0	/* xsend: send memory over XModem */
+
+
+/* UART driver */
+#define CONFIG_UART_IRQ			1	/* Interrupt-driven UART with ring buffers */
+#define CONFIG_UART_RXBUF_SZ		(512)	/* Receive ring size (power of 2) */
+#define CONFIG_UART_TXBUF_SZ		(512)	/* Transmit ring size (power of 2) */
+
+
+/* ELF loader */
+#define CONFIG_ELF_MAX_SEGS		(16)	/* Maximum number of loadable segments */
+
+
+/* Compressed ELF loader. Host tools build the decoder with CONFIG_ELF_LZ=1. */
+#ifndef CONFIG_ELF_LZ
+#define CONFIG_ELF_LZ			0	/* xelfz and yelfz commands */
+#endif
+#define CONFIG_LZ_WINDOW_SZ		(4096)	/* Decoder window size (power of 2) */
+
+
+/* CRC16 implementations */
+#define CRC16_IMPL_BITWISE		0	/* Bit loop, smallest and slowest */
+#define CRC16_IMPL_NIBBLE		1	/* 16-entry table (32 bytes) */
+#define CRC16_IMPL_TABLE		2	/* 256-entry table (512 bytes) */
+
+#define CONFIG_CRC16_IMPL		CRC16_IMPL_TABLE	/* CRC16 implementation */
+#define CONFIG_CRC16_BENCH		0	/* Build all CRC16 variants and crcbench */
+
+
 #endif /* _BOOTROM_CONFIG_H_ */
@@ -31,6 +31,7 @@
 #define _BOOT_CRC16_CCITT_H_
 
 #include <stddef.h>
+#include <config.h>
 
 
 typedef unsigned short crc16_t;
@@ -44,4 +45,12 @@ crc16_t crc16_ccitt_update(const char *ptr, size_t n, crc16_t crc);
 crc16_t crc16_ccitt(const char *ptr, size_t n);
 
 
+#if CONFIG_CRC16_BENCH
+/* Individual implementations (for benchmarking) */
+crc16_t crc16_ccitt_update_bit(const char *ptr, size_t n, crc16_t crc);
+crc16_t crc16_ccitt_update_nibble(const char *ptr, size_t n, crc16_t crc);
+crc16_t crc16_ccitt_update_table(const char *ptr, size_t n, crc16_t crc);
+#endif
+
+
 #endif /* _BOOT_CRC16_CCITT_H_ */
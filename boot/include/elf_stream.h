@@ -31,6 +31,7 @@
 #define _BOOTROM_ELF_STREAM_H_
 
 #include <stddef.h>
+#include <config.h>
 
 
 /* ELF loader status */
@@ -47,9 +48,11 @@
 
 /* Program segment */
 struct segment {
-	size_t fbegin;		/* Stream offset of segment start */
+	size_t fbegin;		/* Stream offset of data not loaded yet */
 	size_t fend;		/* Stream offset of segment end */
-	unsigned long addr;	/* Base address */
+	unsigned long addr;	/* Destination of data not loaded yet */
+	unsigned long paddr;	/* Base address */
+	size_t memsz;		/* Size in memory */
 };
 
 
@@ -69,7 +72,7 @@ struct elf_stream {
 	/* Segments loading */
 	size_t phcur;			/* Current program header */
 	size_t phnld;			/* Number of loaded program headers */
-	struct segment segs[4];		/* Loaded segments */
+	struct segment segs[CONFIG_ELF_MAX_SEGS];	/* Loaded segments sorted by offset */
 
 	/* Internally used stream parser */
 	int (*parser)(struct elf_stream*);
@@ -82,14 +85,23 @@ struct elf_stream {
 	size_t tmp_sz;
 	char tmp[64];
 
+	/* Scratch buffer for data without destination */
+	size_t scratch_sz;		/* Also maximum size of input buffer */
+	char *scratch;
+
 	/* Callback to change load destination */
 	void (*offset)(void*, unsigned long);
 	void *udata;
 };
 
 
-/* Init ELF stream object */
-void elf_stream_init(struct elf_stream* es, void (*offset)(void*, unsigned long), void *udata);
+/* Init ELF stream object.
+ * If scratch buffer is given, offset callback is used to direct the next
+ * input buffer (up to scratch_sz bytes) to the destination of its data.
+ * Without scratch buffer data is always copied and offset is not called.
+ */
+void elf_stream_init(struct elf_stream* es, void (*offset)(void*, unsigned long), void *udata,
+	void *scratch, size_t scratch_sz);
 
 
 /* Parse ELF data stream */
@@ -46,9 +46,28 @@ struct console_data {
 };
 
 
+#if CONFIG_UART_IRQ
+/* UART driver data. Indices run freely and are masked on access. */
+struct uart_data {
+	int irq;				/* Interrupt-driven mode enabled */
+	unsigned ctrl;				/* Control register value */
+	volatile unsigned rx_head;		/* Next byte to read */
+	volatile unsigned rx_tail;		/* Next byte to store (interrupt handler) */
+	volatile unsigned rx_lost;		/* Bytes dropped on ring overflow */
+	volatile unsigned tx_head;		/* Next byte to send (interrupt handler) */
+	volatile unsigned tx_tail;		/* Next byte to store */
+	char rx_buf[CONFIG_UART_RXBUF_SZ];	/* Receive ring */
+	char tx_buf[CONFIG_UART_TXBUF_SZ];	/* Transmit ring */
+};
+#endif
+
+
 /* BootROM data */
 struct global {
 	struct console_data con;
+#if CONFIG_UART_IRQ
+	struct uart_data uart;
+#endif
 	unsigned long elf_entry;	/* Entry point of loaded ELF */
 };
 
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * CPU interrupts control
+ */
+
+#ifndef _BOOTROM_IRQ_H_
+#define _BOOTROM_IRQ_H_
+
+
+#define IRQ_SR_IE	(1<<0)	/* Status register: interrupts enable */
+
+
+/* Disable interrupts. Returns previous status register value. */
+static inline
+unsigned irq_save()
+{
+	unsigned sr, t;
+	__asm__ __volatile__ (
+		".set push          ;"
+		".set noreorder     ;"
+		"mfc0 %0, $12       ;"	/* SR */
+		"nop                ;"
+		"srl %1, %0, 1      ;"
+		"sll %1, %1, 1      ;"	/* Clear IE */
+		"mtc0 %1, $12       ;"
+		"nop                ;"
+		".set pop           ;"
+		: "=&r" (sr), "=&r" (t)
+		:
+		: "memory"
+	);
+	return sr;
+}
+
+
+/* Restore status register saved by irq_save() */
+static inline
+void irq_restore(unsigned sr)
+{
+	__asm__ __volatile__ (
+		".set push          ;"
+		".set noreorder     ;"
+		"mtc0 %0, $12       ;"	/* SR */
+		"nop                ;"
+		".set pop           ;"
+		:
+		: "r" (sr)
+		: "memory"
+	);
+}
+
+
+/* Enable interrupts */
+static inline
+void irq_enable()
+{
+	irq_restore(irq_save() | IRQ_SR_IE);
+}
+
+
+/* Returns non-zero if interrupts are enabled */
+static inline
+int irq_enabled()
+{
+	unsigned sr;
+	__asm__ __volatile__ (
+		".set push          ;"
+		".set noreorder     ;"
+		"mfc0 %0, $12       ;"	/* SR */
+		"nop                ;"
+		".set pop           ;"
+		: "=r" (sr)
+		:
+		: "memory"
+	);
+	return sr & IRQ_SR_IE;
+}
+
+
+/* Point exception and interrupt vectors to ROM (reset value) */
+static inline
+void irq_rom_vectors()
+{
+	__asm__ __volatile__ (
+		".set push          ;"
+		".set noreorder     ;"
+		"mtc0 $zero, $10    ;"	/* IVTB */
+		"nop                ;"
+		".set pop           ;"
+		:
+		:
+		: "memory"
+	);
+}
+
+
+#endif /* _BOOTROM_IRQ_H_ */
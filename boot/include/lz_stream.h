@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * LZ compressed stream decoder
+ */
+
+#ifndef _BOOTROM_LZ_STREAM_H_
+#define _BOOTROM_LZ_STREAM_H_
+
+#include <stddef.h>
+
+
+/*
+ * Stream format (all values little-endian):
+ *   header:   magic "ULZ1", window size log2, 3 reserved bytes,
+ *             32-bit uncompressed size;
+ *   payload:  LZ4 block sequences. Match offsets do not exceed window size.
+ *             Decoding stops after uncompressed size bytes, so the stream
+ *             may carry arbitrary padding.
+ */
+#define LZS_MAGIC		"ULZ1"	/* Stream magic */
+#define LZS_HDR_SZ		12	/* Header size */
+#define LZS_MIN_MATCH		4	/* Minimum match length */
+
+
+/* Decoder status */
+#define LZS_OK			0	/* No errors */
+#define LZS_ERR_FMT		(-16)	/* Invalid stream */
+#define LZS_ERR_WIN		(-17)	/* Stream window is larger than supported */
+
+
+/* Decoder state */
+struct lz_stream {
+	int state;		/* Parser state */
+	size_t hdr_sz;		/* Received header bytes */
+	unsigned char hdr[LZS_HDR_SZ];
+
+	size_t size;		/* Uncompressed size */
+	size_t lit_len;		/* Literals left to copy */
+	size_t match_len;	/* Match bytes left to copy */
+	size_t offset;		/* Match offset */
+
+	/* History window */
+	char *win;
+	size_t win_mask;
+	size_t wpos;		/* Total bytes decoded */
+	size_t fpos;		/* Total bytes passed to output */
+
+	/* Output callback, nonzero return value stops decoding */
+	int (*out)(void *udata, void *buf, size_t size);
+	void *udata;
+};
+
+
+/* Init decoder. Window size must be a power of 2. */
+void lz_stream_init(struct lz_stream *lz, char *win, size_t win_sz,
+	int (*out)(void*, void*, size_t), void *udata);
+
+
+/* Decode next portion of compressed data.
+ * Returns LZS_OK, decoder error or nonzero output callback status.
+ */
+int lz_stream_feed(struct lz_stream *lz, const void *buf, size_t sz);
+
+
+/* Check if all data is decoded */
+int lz_stream_done(struct lz_stream *lz);
+
+
+#endif /* _BOOTROM_LZ_STREAM_H_ */
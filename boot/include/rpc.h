@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Binary RPC mode
+ */
+
+#ifndef _BOOTROM_RPC_H_
+#define _BOOTROM_RPC_H_
+
+
+/*
+ * Console input sequence that switches the boot ROM to RPC mode. The ROM
+ * answers with RPC_CMD_HELLO response (sequence number 0).
+ *
+ * Frame:  sync, command (status in responses), sequence number,
+ *         16-bit payload length, payload, CRC16.
+ * Multibyte values are little-endian except CRC16 which is sent high byte
+ * first as in XModem. CRC16 covers all bytes after sync.
+ *
+ * Requests are executed in order. Host may send several requests without
+ * waiting for responses as long as they fit the UART receive buffers.
+ */
+#define RPC_MAGIC		"\x10RPC"	/* DLE 'R' 'P' 'C' */
+#define RPC_VERSION		1		/* Protocol version */
+
+#define RPC_SYNC_REQ		0xA5		/* Request frame sync */
+#define RPC_SYNC_RSP		0x5A		/* Response frame sync */
+#define RPC_HDR_SZ		5		/* Frame header size */
+#define RPC_MAX_DATA		1024		/* Maximum read/write data size */
+#define RPC_MAX_LEN		(RPC_MAX_DATA + 8)	/* Maximum payload length */
+#define RPC_IDLE_SEC		60		/* ROM leaves RPC mode after idle time */
+
+
+/* Requests. Payload: request -> response. */
+#define RPC_CMD_HELLO		0x00	/* - -> version, 0, max data size (16-bit) */
+#define RPC_CMD_READ		0x01	/* addr, len -> data */
+#define RPC_CMD_WRITE		0x02	/* addr, data -> - */
+#define RPC_CMD_FILL		0x03	/* addr, len, value (8-bit) -> - */
+#define RPC_CMD_CRC		0x04	/* addr, len -> CRC16 (16-bit) */
+#define RPC_CMD_JUMP		0x05	/* addr -> - (sent before jump, leaves RPC mode) */
+#define RPC_CMD_EXIT		0x06	/* - -> - (leaves RPC mode) */
+
+
+/* Response status */
+#define RPC_OK			0x00	/* Success */
+#define RPC_ERR_CRC		0x01	/* Request CRC error */
+#define RPC_ERR_CMD		0x02	/* Unknown request */
+#define RPC_ERR_ARG		0x03	/* Invalid request payload */
+
+
+/* Run RPC session. Called by console after first magic character. */
+void rpc_enter();
+
+
+#endif /* _BOOTROM_RPC_H_ */
@@ -102,4 +102,31 @@ unsigned soc_version()
 }
 
 
+/* Returns performance counter value */
+static inline
+unsigned long long soc_perf_counter(unsigned n)
+{
+	u32 lo = readl(USOC_CTRL_PERF_LO(n));	/* Latches high word */
+	u32 hi = readl(USOC_CTRL_PERF_HI(n));
+
+	return ((unsigned long long)hi << 32) | lo;
+}
+
+
+/* Returns non-zero if performance counters are stopped */
+static inline
+int soc_perf_frozen()
+{
+	return readl(USOC_CTRL_PERF_CTRL) & USOC_CTRL_PERF_CTRL_FREEZE;
+}
+
+
+/* Stop or resume performance counters */
+static inline
+void soc_perf_freeze(int freeze)
+{
+	writel(freeze ? USOC_CTRL_PERF_CTRL_FREEZE : 0, USOC_CTRL_PERF_CTRL);
+}
+
+
 #endif /* _BOOTROM_SOC_INFO_H_ */
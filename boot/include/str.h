@@ -39,6 +39,8 @@ size_t strlen(const char *s);
 int strcmp(const char *cs, const char *ct);
 void *memset(void *s, int c, size_t n);
 void *memmove(void *dst, const void *src, size_t n);
+void *memcpy(void *dst, const void *src, size_t n);
+int memcmp(const void *s1, const void *s2, size_t n);
 
 
 /* Convert string number to unsigned */
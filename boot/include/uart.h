@@ -30,6 +30,8 @@
 #ifndef _BOOTROM_UART_H_
 #define _BOOTROM_UART_H_
 
+#include <config.h>
+
 
 /*
  * Init UART device
@@ -46,8 +48,84 @@ int uart_get_char();
 
 /*
  * Write char to TX FIFO
+ * Blocks until there is space in transmit buffer
  */
 void uart_put_char(char ch);
 
 
+/*
+ * Write char to TX FIFO without blocking
+ * Returns 0 on success or -1 if transmit buffer is full
+ */
+int uart_try_put_char(char ch);
+
+
+/*
+ * Number of characters that can be written without blocking
+ */
+unsigned uart_tx_free();
+
+
+#if CONFIG_UART_IRQ
+/*
+ * Switch to interrupt-driven mode
+ * Received and transmitted characters are buffered in software rings
+ */
+void uart_irq_enable();
+
+
+/*
+ * Switch back to polled mode
+ * Transmits buffered characters, unread input is dropped.
+ * Interrupts are left disabled (SR.IE=0) as after reset.
+ */
+void uart_irq_disable();
+
+
+/*
+ * UART interrupt handler
+ */
+void uart_isr();
+
+
+/*
+ * Number of received characters dropped because receive ring was full
+ */
+unsigned uart_rx_lost();
+#endif
+
+
+/*
+ * Find divider for baud rate
+ * Returns divider or -1 if the rate cannot be set within both transmitter
+ * and receiver tolerances
+ */
+int uart_baud_divider(unsigned baud);
+
+
+/*
+ * Get baud rate divider
+ */
+unsigned uart_get_divider();
+
+
+/*
+ * Set baud rate divider
+ * Waits for all pending characters to be transmitted at the old rate
+ */
+void uart_set_divider(unsigned div);
+
+
+/*
+ * Get current baud rate
+ */
+unsigned uart_get_baud();
+
+
+/*
+ * Wait until all characters are transmitted
+ */
+void uart_tx_drain();
+
+
 #endif /* _BOOTROM_UART_H_ */
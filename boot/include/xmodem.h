@@ -38,6 +38,8 @@
 #define XM_ERR_CAN	(-1)	/* Transmission canceled */
 #define XM_ERR_OOSEQ	(-2)	/* Out of sequence error */
 #define XM_ERR_RETR	(-3)	/* Max number of retries reached */
+#define XM_ERR_DATA	(-4)	/* Corrupted block (streaming mode) */
+#define XM_ERR_TMO	(-5)	/* Receive timeout (streaming mode) */
 
 
 /* XModem receiver state */
@@ -46,6 +48,7 @@ struct xm_recvr {
 	char	blk_no;		/* Last received block number */
 	char	cblk_no;	/* Current block number (not acknowledged yet) */
 	size_t	rx_size;	/* Received data size */
+	size_t	fsize;		/* File size from YModem header (0 - unknown) */
 	void	*udata;		/* Optional user data */
 
 	/* Out byte function */
@@ -65,6 +68,7 @@ static inline void xm_recvr_init(struct xm_recvr *xmr, void (*outb)(struct xm_re
 	xmr->blk_no = 0;
 	xmr->cblk_no = 0;
 	xmr->rx_size = 0;
+	xmr->fsize = 0;
 	xmr->udata = NULL;
 	xmr->outb = outb;
 	xmr->inb = inb;
@@ -125,4 +129,42 @@ static inline void xm_recvr_setucb(struct xm_recvr *xmr, int (*callback)(struct
 int xm_recvr_start_rx(struct xm_recvr *xmr, void *buf);
 
 
+/* Start YModem-G streaming receive of a single file */
+int xm_recvr_start_rx_g(struct xm_recvr *xmr, void *buf);
+
+
+/* XModem sender state */
+struct xm_sender {
+	size_t	tx_size;	/* Acknowledged data size */
+	void	*udata;		/* Optional user data */
+
+	/* Out byte function */
+	void (*outb)(struct xm_sender *xms, char ch);
+	/* In byte with timeout. Tries to receive a byte within specified time. */
+	int (*inb)(struct xm_sender *xms, unsigned timeout_sec);
+};
+
+
+/* Init XModem sender instance */
+static inline void xm_sender_init(struct xm_sender *xms, void (*outb)(struct xm_sender*, char),
+	int (*inb)(struct xm_sender*, unsigned))
+{
+	xms->tx_size = 0;
+	xms->udata = NULL;
+	xms->outb = outb;
+	xms->inb = inb;
+}
+
+
+/* Get acknowledged data size */
+static inline size_t xm_sender_gettxsize(struct xm_sender *xms)
+{
+	return xms->tx_size;
+}
+
+
+/* Send data using XModem-1K (CRC mode only). Last block is padded. */
+int xm_sender_start_tx(struct xm_sender *xms, const void *buf, size_t size);
+
+
 #endif /* _BOOT_XMODEM_H_ */
@@ -16,12 +16,14 @@ LIBGCC_INCLUDE := $(LIBGCC_PATH)/include
 LIBC_PATH := $(dir $(shell $(GCC_PREFIX)gcc $(ARCH_CFLAGS) -print-file-name=libc.a))
 
 # C flags
-CFLAGS := -O2 $(ARCH_CFLAGS)
+CFLAGS := -Os $(ARCH_CFLAGS)
 CFLAGS += -I$(ULTISOC_HOME)/hw/ultiparc/verif/testsuite/include
 CFLAGS += -I$(ULTISOC_HOME)/hw/soc_top/verif/include
 CFLAGS += -Iinclude
 CFLAGS += -ffreestanding -fno-pic
 CFLAGS += -finline -fno-builtin -fno-strict-aliasing
+# Do not let compiler turn copy loops into calls to memset()/memcpy()
+CFLAGS += -fno-tree-loop-distribute-patterns
 CFLAGS += -ffunction-sections -fdata-sections
 CFLAGS += -I$(LIBGCC_INCLUDE)
 CFLAGS += -Wall
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * UART baud rate control
+ */
+
+#include <stddef.h>
+#include <arch.h>
+#include <soc_info.h>
+#include <uart.h>
+#include <con.h>
+#include <str.h>
+#include <cmd.h>
+#include <cmd_types.h>
+#include <baud.h>
+
+
+/*
+ * Negotiation sequence:
+ *  1. BootROM sends two SYN characters at old rate and switches to new rate;
+ *  2. host switches to new rate and keeps sending sync characters (0x55);
+ *  3. after three sync characters in a row BootROM replies with two SYNs;
+ *  4. host confirms with ACK.
+ * BootROM returns to old rate if any step times out.
+ */
+#define SYN	0x16	/* Rate switch / sync reply */
+#define ACK	0x06	/* Host confirmation */
+#define SYNC_CH	0x55	/* Host sync pattern */
+
+
+/* Returns time stamp ms milliseconds from now */
+static inline
+u32 deadline(unsigned ms)
+{
+	return rdtsc_lo() + ms * (soc_sys_freq() / 1000);
+}
+
+
+/* Returns non-zero if deadline passed */
+static inline
+int expired(u32 t)
+{
+	return (long)rdtsc_lo() - (long)t >= 0;
+}
+
+
+int baud_negotiate(unsigned baud)
+{
+	int div = uart_baud_divider(baud);
+	unsigned old = uart_get_divider();
+	unsigned n = 0;
+	u32 t;
+	int ch;
+
+	if(div < 0) {
+		cprint_str("Unsupported baud rate.\n");
+		return -1;
+	}
+
+	/* Announce and switch */
+	uart_put_char(SYN);
+	uart_put_char(SYN);
+	uart_set_divider(div);
+
+	/* Wait for host sync pattern */
+	t = deadline(2000);
+	while(n < 3 && !expired(t)) {
+		ch = uart_get_char();
+		if(ch >= 0)
+			n = (ch == SYNC_CH ? n + 1 : 0);
+	}
+
+	if(n == 3) {
+		uart_put_char(SYN);
+		uart_put_char(SYN);
+
+		/* Wait for confirmation, host may still be sending sync pattern */
+		t = deadline(1000);
+		while(!expired(t)) {
+			if(uart_get_char() == ACK)
+				return old;
+		}
+	}
+
+	uart_set_divider(old);
+	cprint_str("Baud rate negotiation failed.\n");
+
+	return -1;
+}
+
+
+void baud_restore(unsigned div)
+{
+	u32 t = deadline(100);
+
+	/* Give host time to switch back */
+	while(!expired(t))
+		;
+
+	uart_set_divider(div);
+}
+
+
+/* Set/get baud rate */
+static int cmd_baud(struct cmd_args *args)
+{
+	unsigned baud;
+	int div;
+
+	if(args->n == 1) {
+		cprint_uint(uart_get_baud());
+		cprint_str(" bps (divider ");
+		cprint_uint(uart_get_divider());
+		cprint_str(")\n");
+		return 0;
+	}
+
+	/* Parse baud rate */
+	if(cmd_arg2u(args->args[1], &baud) < 0)
+		return -1;
+
+	div = uart_baud_divider(baud);
+	if(div < 0) {
+		cprint_str("Unsupported baud rate.\n");
+		return -1;
+	}
+
+	cprint_str("Switching to ");
+	cprint_uint(baud);
+	cprint_str(" bps.\n");
+
+	uart_set_divider(div);
+
+	return 0;
+}
+COMMAND(a1baud, "baud", "baud [rate]", "set/get UART baud rate", cmd_baud);
@@ -30,6 +30,7 @@
 #include <stddef.h>
 #include <ctype.h>
 #include <str.h>
+#include <con.h>
 #include <cmd.h>
 #include <cmd_types.h>
 
@@ -82,16 +83,42 @@ int cmd_run(char *cmd_str)
 {
 	struct cmd_args args;
 	unsigned nargs;
-	struct cmd *c;
 	int ret = -1;
 
 	nargs = parse(cmd_str, &args);
 	if(!nargs)
 		return ret;
 
-	c = search_cmd(args.args[0]);
+	return cmd_exec(&args);
+}
+
+
+int cmd_exec(struct cmd_args *args)
+{
+	struct cmd *c;
+
+	c = search_cmd(args->args[0]);
 	if(!c || !c->func)
 		return CMD_ENENT;
 
-	return c->func(&args);
+	return c->func(args);
+}
+
+
+void cmd_bad_arg(const char *arg)
+{
+	cprint_str("Invalid argument: ");
+	cprint_str(arg);
+	cprint_str("\n");
+}
+
+
+int cmd_arg2u(const char *arg, unsigned *v)
+{
+	if(str2u(arg, v) < 0) {
+		cmd_bad_arg(arg);
+		return -1;
+	}
+
+	return 0;
 }
@@ -27,10 +27,12 @@
  * Console
  */
 
+#include <config.h>
 #include <global.h>
 #include <uart.h>
 #include <str.h>
 #include <con.h>
+#include <rpc.h>
 
 
 void con_init()
@@ -82,6 +84,28 @@ void con_putc(char ch)
 }
 
 
+int con_try_putc(char ch)
+{
+	int lfcr = (ch == 0xA) && (con_get_flags() & CON_FLAGS_LFCR);
+
+	/* LF and implicit CR go out together */
+	if(uart_tx_free() < (lfcr ? 2 : 1))
+		return -1;
+
+	uart_try_put_char(ch);
+	if(lfcr)
+		uart_try_put_char(0xD);
+
+	return 0;
+}
+
+
+void con_flush()
+{
+	uart_tx_drain();
+}
+
+
 void con_puts(const char* str)
 {
 	while(*str) {
@@ -236,6 +260,10 @@ char *con_get_iobuf()
 			} else {
 				reset_esc_seq();
 			}
+#if CONFIG_RPC
+		} else if(ch == RPC_MAGIC[0]) {							/* Binary RPC */
+			rpc_enter();
+#endif
 		} else if(ch == 127) {								/* BACKSPACE */
 			ret = buf_bcksp();
 		} else {
@@ -346,18 +374,24 @@ void cprint_int64(long long v)
 
 void cprint_uint64(unsigned long long v)
 {
-	unsigned long long d;
-	unsigned long long o = 10000000000000000000ULL;
-	unsigned long long f = 0;
+	unsigned hi = (unsigned)(v >> 32);
+	unsigned lo = (unsigned)v;
+	char d[20];
+	unsigned n = 0;
 
-	while(o != 1) {
-		d = v / o;
-		v = v % o;
-		o = o / 10;
-		f = f | d;
-		if(f) con_putc('0' + d);
-	}
-	con_putc('0' + v);
+	/* Divide by 10 in 16-bit steps, 64-bit division needs libgcc */
+	do {
+		unsigned r, t, u;
+		r = hi % 10;
+		hi = hi / 10;
+		t = (r << 16) | (lo >> 16);
+		u = ((t % 10) << 16) | (lo & 0xFFFF);
+		lo = ((t / 10) << 16) | (u / 10);
+		d[n++] = '0' + u % 10;
+	} while(hi | lo);
+
+	while(n)
+		con_putc(d[--n]);
 }
 
 
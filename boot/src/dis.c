@@ -31,6 +31,7 @@
 #include <con.h>
 #include <str.h>
 #include <disasm.h>
+#include <cmd.h>
 #include <cmd_types.h>
 
 
@@ -48,32 +49,20 @@ static int cmd_dis(struct cmd_args *args)
 	}
 
 	/* Parse address */
-	if(str2u(args->args[1], &addr) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[1], &addr) < 0)
 		return -1;
-	}
 
 	/* Parse instructions number */
-	if(str2u(args->args[2], &inum) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[2]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[2], &inum) < 0)
 		return -1;
-	}
 
 	if(!inum)
 		return 0;
 
 	/* Parse instructions per page if specified */
 	if(args->n > 3) {
-		if(str2u(args->args[3], &pp) < 0) {
-			cprint_str("Invalid argument: ");
-			cprint_str(args->args[3]);
-			cprint_str("\n");
+		if(cmd_arg2u(args->args[3], &pp) < 0)
 			return -1;
-		}
 		if(!pp)
 			pp = (unsigned)-1;
 	}
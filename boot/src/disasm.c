@@ -65,1300 +65,256 @@ u32 zero_extend16(u32 imm)
 }
 
 
-static int disasm_mfc0(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.func || iw.r.shamt)
-		return -1;
-
-	cprint_strf("mfc0", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_c0rs[iw.r.rd]);
-
-	return 0;
-}
-
-
-static int disasm_mtc0(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.func || iw.r.shamt)
-		return -1;
-
-	cprint_strf("mtc0", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_c0rs[iw.r.rd]);
-
-	return 0;
-}
-
-
-static int disasm_rfe(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.func == 16 && !iw.r.rd && !iw.r.rt && !iw.r.shamt) {
-		cprint_str("rfe");
-		return 0;
-	} else
-		return -1;
-}
-
-
-static int disasm_wait(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.func == 32 && !iw.r.rd && !iw.r.rt && !iw.r.shamt) {
-		cprint_str("wait");
-		return 0;
-	} else
-		return -1;
-}
-
-
-static int disasm_sll(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rs)
-		return -1;
-
-	if(iw.r.rd || iw.r.rt) {
-		cprint_strf("sll", IFLDW);
-		cprint_str(disasm_gprs[iw.r.rd]);
-		cprint_str(", ");
-		cprint_str(disasm_gprs[iw.r.rt]);
-		cprint_str(", ");
-		cprint_int(iw.r.shamt);
-	} else
-		cprint_str("nop");
-
-	return 0;
-}
-
-
-static int disasm_srl(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rs)
-		return -1;
-
-	cprint_strf("srl", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_int(iw.r.shamt);
-
-	return 0;
-}
-
-
-static int disasm_sra(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rs)
-		return -1;
-
-	cprint_strf("sra", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_int(iw.r.shamt);
-
-	return 0;
-}
-
-
-static int disasm_sllv(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("sllv", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_srlv(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("srlv", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_srav(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("srav", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_jr(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rt || iw.r.rd)
-		return -1;
-
-	cprint_strf("jr", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_jalr(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rd)
-		return -1;
-
-	cprint_strf("jalr", IFLDW);
-	if(iw.r.rd != 31) {
-		cprint_str(disasm_gprs[iw.r.rd]);
-		cprint_str(", ");
-	}
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-
-}
-
-
-static int disasm_syscall(u32 instr)
-{
-	cprint_str("syscall");
-	return 0;
-}
-
-
-static int disasm_break(u32 instr)
-{
-	cprint_str("break");
-	return 0;
-}
-
-
-static int disasm_mfhi(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rs || iw.r.rt)
-		return -1;
-
-	cprint_strf("mfhi", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-
-	return 0;
-}
-
-
-static int disasm_mthi(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rd || iw.r.rt)
-		return -1;
-
-	cprint_strf("mthi", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_mflo(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rs || iw.r.rt)
-		return -1;
-
-	cprint_strf("mflo", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-
-	return 0;
-}
-
-
-static int disasm_mtlo(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rd || iw.r.rt)
-		return -1;
-
-	cprint_strf("mtlo", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_mult(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rd)
-		return -1;
-
-	cprint_str("mult");
-
-	return 0;
-}
-
-
-static int disasm_multu(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rd)
-		return -1;
-
-	cprint_str("multu");
-
-	return 0;
-}
-
-
-static int disasm_div(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rd)
-		return -1;
-
-	cprint_str("div");
-
-	return 0;
-}
-
-
-static int disasm_divu(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.r.rd)
-		return -1;
-
-	cprint_str("divu");
-
-	return 0;
-}
-
-
-static int disasm_add(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("add", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_addu(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("addu", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_sub(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("sub", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_subu(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("subu", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_and(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("and", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_or(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("or", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_xor(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("xor", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_nor(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("nor", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_slt(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("slt", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_sltu(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	cprint_strf("sltu", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rd]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-
-	return 0;
-}
-
-
-static int disasm_bltz(u32 instr, u32 addr)
-{
-	u32 target;
-	union instruction iw;
-	iw.word = instr;
-
-	target = sign_extend16(iw.i.imm) << 2;
-
-	cprint_strf("bltz", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_hex32(addr + 4 + target);
-
-	return 0;
-}
-
-
-static int disasm_bgez(u32 instr, u32 addr)
-{
-	u32 target;
-	union instruction iw;
-	iw.word = instr;
-
-	target = sign_extend16(iw.i.imm) << 2;
-
-	cprint_strf("bgez", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_hex32(addr + 4 + target);
-
-	return 0;
-}
-
-
-static int disasm_bltzal(u32 instr, u32 addr)
-{
-	u32 target;
-	union instruction iw;
-	iw.word = instr;
-
-	target = sign_extend16(iw.i.imm) << 2;
-
-	cprint_strf("bltzal", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_hex32(addr + 4 + target);
-
-	return 0;
-}
-
-
-static int disasm_bgezal(u32 instr, u32 addr)
-{
-	u32 target;
-	union instruction iw;
-	iw.word = instr;
-
-	target = sign_extend16(iw.i.imm) << 2;
-
-	cprint_strf("bgezal", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_hex32(addr + 4 + target);
-
-	return 0;
-}
-
-
-static int disasm_j(u32 instr, u32 addr)
-{
-	u32 target;
-	union instruction iw;
-	iw.word = instr;
-
-	target = iw.j.target;
-	target = ((addr + 4) & 0xF0000000) | target << 2;
-
-	cprint_strf("j", IFLDW);
-	cprint_hex32(target);
-
-	return 0;
-}
-
-
-static int disasm_jal(u32 instr, u32 addr)
-{
-	u32 target;
-	union instruction iw;
-	iw.word = instr;
-
-	target = iw.j.target;
-	target = ((addr + 4) & 0xF0000000) | target << 2;
-
-	cprint_strf("jal", IFLDW);
-	cprint_hex32(target);
-
-	return 0;
-}
-
-
-static int disasm_beq(u32 instr, u32 addr)
-{
-	u32 target;
-	union instruction iw;
-	iw.word = instr;
-
-	target = sign_extend16(iw.i.imm) << 2;
-
-	cprint_strf("beq", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_hex32(addr + 4 + target);
-
-	return 0;
-}
-
-
-static int disasm_bne(u32 instr, u32 addr)
-{
-	u32 target;
-	union instruction iw;
-	iw.word = instr;
-
-	target = sign_extend16(iw.i.imm) << 2;
-
-	cprint_strf("bne", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_hex32(addr + 4 + target);
-
-	return 0;
-}
-
-
-static int disasm_blez(u32 instr, u32 addr)
-{
-	u32 target;
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.i.rt)
-		return -1;
-
-	target = sign_extend16(iw.i.imm) << 2;
-
-	cprint_strf("blez", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_hex32(addr + 4 + target);
-
-	return 0;
-}
-
-
-static int disasm_bgtz(u32 instr, u32 addr)
-{
-	u32 target;
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.i.rt)
-		return -1;
-
-	target = sign_extend16(iw.i.imm) << 2;
-
-	cprint_strf("bgtz", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_hex32(addr + 4 + target);
-
-	return 0;
-}
-
-
-static int disasm_addi(u32 instr)
-{
-	s32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("addi", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_int(imm);
-
-	return 0;
-}
-
-
-static int disasm_addiu(u32 instr)
-{
-	u32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("addiu", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_int(imm);
-
-	return 0;
-}
-
-
-static int disasm_slti(u32 instr)
-{
-	u32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("slti", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_int(imm);
-
-	return 0;
-}
-
-
-static int disasm_sltiu(u32 instr)
-{
-	u32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("sltiu", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", ");
-	cprint_uint(imm);
-
-	return 0;
-}
-
-
-static int disasm_andi(u32 instr)
-{
-	u32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = zero_extend16(iw.i.imm);
-
-	cprint_strf("andi", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", 0x");
-	cprint_hex32(imm);
-
-	return 0;
-}
-
-
-static int disasm_ori(u32 instr)
-{
-	u32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = zero_extend16(iw.i.imm);
-
-	cprint_strf("ori", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", 0x");
-	cprint_hex32(imm);
-
-	return 0;
-}
-
-
-static int disasm_xori(u32 instr)
-{
-	u32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = zero_extend16(iw.i.imm);
-
-	cprint_strf("xori", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_str(", 0x");
-	cprint_hex32(imm);
-
-	return 0;
-}
-
-
-static int disasm_lui(u32 instr)
-{
-	union instruction iw;
-	iw.word = instr;
-
-	if(iw.i.rs)
-		return -1;
-
-	cprint_strf("lui", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", 0x");
-	cprint_hex32(iw.i.imm);
-
-	return 0;
-}
-
-
-static int disasm_lb(u32 instr)
-{
-	s32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("lb", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_int(imm);
-	cprint_char('(');
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_char(')');
-
-	return 0;
-}
-
-
-static int disasm_lh(u32 instr)
-{
-	s32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("lh", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_int(imm);
-	cprint_char('(');
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_char(')');
-
-	return 0;
-}
-
-
-static int disasm_lw(u32 instr)
-{
-	s32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("lw", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_int(imm);
-	cprint_char('(');
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_char(')');
-
-	return 0;
-}
-
-
-static int disasm_lbu(u32 instr)
-{
-	s32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("lbu", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_int(imm);
-	cprint_char('(');
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_char(')');
-
-	return 0;
-}
-
-
-static int disasm_lhu(u32 instr)
-{
-	s32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("lhu", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_int(imm);
-	cprint_char('(');
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_char(')');
-
-	return 0;
-}
-
-
-static int disasm_sb(u32 instr)
-{
-	s32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("sb", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_int(imm);
-	cprint_char('(');
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_char(')');
-
-	return 0;
-}
-
-
-static int disasm_sh(u32 instr)
-{
-	s32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
-
-	cprint_strf("sh", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_int(imm);
-	cprint_char('(');
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_char(')');
-
-	return 0;
-}
-
-
-static int disasm_sw(u32 instr)
-{
-	s32 imm;
-	union instruction iw;
-	iw.word = instr;
-
-	imm = sign_extend16(iw.i.imm);
+/* Instruction fields */
+#define FLD_RS		(0x1F << 21)
+#define FLD_RT		(0x1F << 16)
+#define FLD_RD		(0x1F << 11)
+#define FLD_SHAMT	(0x1F << 6)
+#define FLD_FUNC	(0x3F)
+
+
+/* Operand formats */
+#define FMT_NONE	(0)
+#define FMT_SHIFT	(1)
+#define FMT_REG3	(2)
+#define FMT_JR		(3)
+#define FMT_JALR	(4)
+#define FMT_MFHILO	(5)
+#define FMT_MTHILO	(6)
+#define FMT_MULDIV	(7)
+#define FMT_BRANCHZ	(8)
+#define FMT_BRANCH	(9)
+#define FMT_JUMP	(10)
+#define FMT_IMM		(11)
+#define FMT_IMMU	(12)
+#define FMT_IMMX	(13)
+#define FMT_LUI		(14)
+#define FMT_MEM		(15)
+#define FMT_C0		(16)
+#define FMT_C0OP	(17)
+
+
+/* Operand formats description. Operands are printed comma separated:
+ *   d, t, s - rd, rt, rs general purpose registers;
+ *   c       - rd coprocessor 0 register;
+ *   h       - shift amount;
+ *   i, u    - sign extended immediate printed as signed and unsigned;
+ *   x       - zero extended immediate printed as hex;
+ *   m       - memory operand imm(rs);
+ *   b, j    - branch and jump targets.
+ * Instructions without operands are printed unaligned.
+ */
+static const struct {
+	u32 zero;		/* Fields which must be zero */
+	char opnds[4];		/* Operands */
+} disasm_fmts[] = {
+	{ 0, "" },					/* FMT_NONE */
+	{ FLD_RS, "dth" },				/* FMT_SHIFT */
+	{ FLD_SHAMT, "dts" },				/* FMT_REG3 */
+	{ FLD_SHAMT | FLD_RT | FLD_RD, "s" },		/* FMT_JR */
+	{ FLD_SHAMT | FLD_RD, "ds" },			/* FMT_JALR */
+	{ FLD_SHAMT | FLD_RS | FLD_RT, "d" },		/* FMT_MFHILO */
+	{ FLD_SHAMT | FLD_RD | FLD_RT, "s" },		/* FMT_MTHILO */
+	{ FLD_SHAMT | FLD_RD, "" },			/* FMT_MULDIV */
+	{ 0, "sb" },					/* FMT_BRANCHZ */
+	{ 0, "stb" },					/* FMT_BRANCH */
+	{ 0, "j" },					/* FMT_JUMP */
+	{ 0, "tsi" },					/* FMT_IMM */
+	{ 0, "tsu" },					/* FMT_IMMU */
+	{ 0, "tsx" },					/* FMT_IMMX */
+	{ FLD_RS, "tx" },				/* FMT_LUI */
+	{ 0, "tm" },					/* FMT_MEM */
+	{ FLD_FUNC | FLD_SHAMT, "tc" },			/* FMT_C0 */
+	{ FLD_RD | FLD_RT | FLD_SHAMT, "" }		/* FMT_C0OP */
+};
 
-	cprint_strf("sw", IFLDW);
-	cprint_str(disasm_gprs[iw.r.rt]);
-	cprint_str(", ");
-	cprint_int(imm);
-	cprint_char('(');
-	cprint_str(disasm_gprs[iw.r.rs]);
-	cprint_char(')');
 
-	return 0;
-}
+/* Opcodes. Secondary opcode is function field for SPECIAL, rt for REGIMM,
+ * BLEZ and BGTZ, rs for COP0 moves and function field with bit 6 set for
+ * other COP0 operations.
+ */
+static const struct disasm_op {
+	unsigned char op;	/* Opcode */
+	unsigned char sub;	/* Secondary opcode */
+	unsigned char fmt;	/* Operands format */
+	char name[8];		/* Mnemonic */
+} disasm_ops[] = {
+	{ 0, 0, FMT_SHIFT, "sll" },
+	{ 0, 2, FMT_SHIFT, "srl" },
+	{ 0, 3, FMT_SHIFT, "sra" },
+	{ 0, 4, FMT_REG3, "sllv" },
+	{ 0, 6, FMT_REG3, "srlv" },
+	{ 0, 7, FMT_REG3, "srav" },
+	{ 0, 8, FMT_JR, "jr" },
+	{ 0, 9, FMT_JALR, "jalr" },
+	{ 0, 12, FMT_NONE, "syscall" },
+	{ 0, 13, FMT_NONE, "break" },
+	{ 0, 16, FMT_MFHILO, "mfhi" },
+	{ 0, 17, FMT_MTHILO, "mthi" },
+	{ 0, 18, FMT_MFHILO, "mflo" },
+	{ 0, 19, FMT_MTHILO, "mtlo" },
+	{ 0, 24, FMT_MULDIV, "mult" },
+	{ 0, 25, FMT_MULDIV, "multu" },
+	{ 0, 26, FMT_MULDIV, "div" },
+	{ 0, 27, FMT_MULDIV, "divu" },
+	{ 0, 32, FMT_REG3, "add" },
+	{ 0, 33, FMT_REG3, "addu" },
+	{ 0, 34, FMT_REG3, "sub" },
+	{ 0, 35, FMT_REG3, "subu" },
+	{ 0, 36, FMT_REG3, "and" },
+	{ 0, 37, FMT_REG3, "or" },
+	{ 0, 38, FMT_REG3, "xor" },
+	{ 0, 39, FMT_REG3, "nor" },
+	{ 0, 42, FMT_REG3, "slt" },
+	{ 0, 43, FMT_REG3, "sltu" },
+	{ 1, 0, FMT_BRANCHZ, "bltz" },
+	{ 1, 1, FMT_BRANCHZ, "bgez" },
+	{ 1, 16, FMT_BRANCHZ, "bltzal" },
+	{ 1, 17, FMT_BRANCHZ, "bgezal" },
+	{ 2, 0, FMT_JUMP, "j" },
+	{ 3, 0, FMT_JUMP, "jal" },
+	{ 4, 0, FMT_BRANCH, "beq" },
+	{ 5, 0, FMT_BRANCH, "bne" },
+	{ 6, 0, FMT_BRANCHZ, "blez" },
+	{ 7, 0, FMT_BRANCHZ, "bgtz" },
+	{ 8, 0, FMT_IMM, "addi" },
+	{ 9, 0, FMT_IMM, "addiu" },
+	{ 10, 0, FMT_IMM, "slti" },
+	{ 11, 0, FMT_IMMU, "sltiu" },
+	{ 12, 0, FMT_IMMX, "andi" },
+	{ 13, 0, FMT_IMMX, "ori" },
+	{ 14, 0, FMT_IMMX, "xori" },
+	{ 15, 0, FMT_LUI, "lui" },
+	{ 16, 0, FMT_C0, "mfc0" },
+	{ 16, 4, FMT_C0, "mtc0" },
+	{ 16, 64 | 16, FMT_C0OP, "rfe" },
+	{ 16, 64 | 32, FMT_C0OP, "wait" },
+	{ 32, 0, FMT_MEM, "lb" },
+	{ 33, 0, FMT_MEM, "lh" },
+	{ 35, 0, FMT_MEM, "lw" },
+	{ 36, 0, FMT_MEM, "lbu" },
+	{ 37, 0, FMT_MEM, "lhu" },
+	{ 40, 0, FMT_MEM, "sb" },
+	{ 41, 0, FMT_MEM, "sh" },
+	{ 43, 0, FMT_MEM, "sw" }
+};
 
 
-static int disasm_special(u32 instr)
+/* Find opcode table entry for instruction */
+static const struct disasm_op *disasm_lookup(u32 instr)
 {
-	int ret = -1;
 	union instruction iw;
+	unsigned sub;
+	unsigned i;
 	iw.word = instr;
 
-	if(iw.r.shamt &&
-		(iw.r.func != 0 && iw.r.func != 2 && iw.r.func != 3 &&
-		iw.r.func != 12 && iw.r.func != 13)) {
-			return ret;
-	}
-
-	switch(iw.r.func) {
+	switch(iw.r.op) {
 		case 0:
-			ret = disasm_sll(instr);
-			break;
-		case 2:
-			ret = disasm_srl(instr);
-			break;
-		case 3:
-			ret = disasm_sra(instr);
-			break;
-		case 4:
-			ret = disasm_sllv(instr);
+			sub = iw.r.func;
 			break;
+		case 1:
 		case 6:
-			ret = disasm_srlv(instr);
-			break;
 		case 7:
-			ret = disasm_srav(instr);
-			break;
-		case 8:
-			ret = disasm_jr(instr);
-			break;
-		case 9:
-			ret = disasm_jalr(instr);
-			break;
-		case 12:
-			ret = disasm_syscall(instr);
-			break;
-		case 13:
-			ret = disasm_break(instr);
+			sub = iw.r.rt;
 			break;
 		case 16:
-			ret = disasm_mfhi(instr);
-			break;
-		case 17:
-			ret = disasm_mthi(instr);
-			break;
-		case 18:
-			ret = disasm_mflo(instr);
-			break;
-		case 19:
-			ret = disasm_mtlo(instr);
-			break;
-		case 24:
-			ret = disasm_mult(instr);
-			break;
-		case 25:
-			ret = disasm_multu(instr);
-			break;
-		case 26:
-			ret = disasm_div(instr);
-			break;
-		case 27:
-			ret = disasm_divu(instr);
-			break;
-		case 32:
-			ret = disasm_add(instr);
-			break;
-		case 33:
-			ret = disasm_addu(instr);
-			break;
-		case 34:
-			ret = disasm_sub(instr);
-			break;
-		case 35:
-			ret = disasm_subu(instr);
-			break;
-		case 36:
-			ret = disasm_and(instr);
-			break;
-		case 37:
-			ret = disasm_or(instr);
-			break;
-		case 38:
-			ret = disasm_xor(instr);
-			break;
-		case 39:
-			ret = disasm_nor(instr);
-			break;
-		case 42:
-			ret = disasm_slt(instr);
-			break;
-		case 43:
-			ret = disasm_sltu(instr);
+			sub = iw.r.rs == 16 ? 64 | iw.r.func : iw.r.rs;
 			break;
 		default:
-			ret = -1;
+			sub = 0;
 			break;
 	}
 
-	return ret;
-}
-
-
-static int disasm_cop0(u32 instr)
-{
-	int ret;
-	union instruction iw;
-	iw.word = instr;
-
-	switch(iw.r.rs) {
-		case 0:
-			ret = disasm_mfc0(instr);
-			break;
-		case 4:
-			ret = disasm_mtc0(instr);
-			break;
-		case 16:
-			if(iw.r.func == 16)
-				ret = disasm_rfe(instr);
-			else if (iw.r.func == 32)
-				ret = disasm_wait(instr);
-			else
-				ret = -1;
-			break;
-		default:
-			ret = -1;
-			break;
+	for(i = 0; i < sizeof(disasm_ops) / sizeof(disasm_ops[0]); ++i) {
+		if(disasm_ops[i].op == iw.r.op && disasm_ops[i].sub == sub)
+			return &disasm_ops[i];
 	}
 
-	return ret;
+	return NULL;
 }
 
 
-static int disasm_load_store(u32 instr)
+/* Print instruction operand */
+static void disasm_opnd(char opnd, u32 instr, u32 addr)
 {
-	int ret;
 	union instruction iw;
 	iw.word = instr;
 
-	switch(iw.r.op) {
-		case 32:
-			ret = disasm_lb(instr);
-			break;
-		case 33:
-			ret = disasm_lh(instr);
-			break;
-		case 35:
-			ret = disasm_lw(instr);
+	switch(opnd) {
+		case 'd':
+			cprint_str(disasm_gprs[iw.r.rd]);
 			break;
-		case 36:
-			ret = disasm_lbu(instr);
+		case 't':
+			cprint_str(disasm_gprs[iw.r.rt]);
 			break;
-		case 37:
-			ret = disasm_lhu(instr);
+		case 's':
+			cprint_str(disasm_gprs[iw.r.rs]);
 			break;
-		case 40:
-			ret = disasm_sb(instr);
+		case 'c':
+			cprint_str(disasm_c0rs[iw.r.rd]);
 			break;
-		case 41:
-			ret = disasm_sh(instr);
+		case 'h':
+			cprint_int(iw.r.shamt);
 			break;
-		case 43:
-			ret = disasm_sw(instr);
+		case 'i':
+			cprint_int(sign_extend16(iw.i.imm));
 			break;
-		default:
-			ret = -1;
+		case 'u':
+			cprint_uint(sign_extend16(iw.i.imm));
 			break;
-	}
-
-	return ret;
-}
-
-
-static int disasm_regimm(u32 instr, u32 addr)
-{
-	int ret;
-	union instruction iw;
-	iw.word = instr;
-
-	switch(iw.r.rt) {
-		case 0:
-			ret = disasm_bltz(instr, addr);
+		case 'x':
+			cprint_str("0x");
+			cprint_hex32(zero_extend16(iw.i.imm));
 			break;
-		case 1:
-			ret = disasm_bgez(instr, addr);
+		case 'm':
+			cprint_int(sign_extend16(iw.i.imm));
+			cprint_char('(');
+			cprint_str(disasm_gprs[iw.r.rs]);
+			cprint_char(')');
 			break;
-		case 16:
-			ret = disasm_bltzal(instr, addr);
+		case 'b':
+			cprint_hex32(addr + 4 + (sign_extend16(iw.i.imm) << 2));
 			break;
-		case 17:
-			ret = disasm_bgezal(instr, addr);
+		case 'j':
+			cprint_hex32(((addr + 4) & 0xF0000000) | (iw.j.target << 2));
 			break;
 		default:
-			ret = -1;
 			break;
 	}
-
-	return ret;
 }
 
 
-static int disasm_other(u32 instr, u32 addr)
+int disasm_instr(u32 instr, u32 addr)
 {
-	int ret;
-	union instruction iw;
-	iw.word = instr;
+	const struct disasm_op *op = disasm_lookup(instr);
+	const char *opnd;
 
-	switch(iw.r.op) {
-		case 2:
-			ret = disasm_j(instr, addr);
-			break;
-		case 3:
-			ret = disasm_jal(instr, addr);
-			break;
-		case 4:
-			ret = disasm_beq(instr, addr);
-			break;
-		case 5:
-			ret = disasm_bne(instr, addr);
-			break;
-		case 6:
-			ret = disasm_blez(instr, addr);
-			break;
-		case 7:
-			ret = disasm_bgtz(instr, addr);
-			break;
-		case 8:
-			ret = disasm_addi(instr);
-			break;
-		case 9:
-			ret = disasm_addiu(instr);
-			break;
-		case 10:
-			ret = disasm_slti(instr);
-			break;
-		case 11:
-			ret = disasm_sltiu(instr);
-			break;
-		case 12:
-			ret = disasm_andi(instr);
-			break;
-		case 13:
-			ret = disasm_ori(instr);
-			break;
-		case 14:
-			ret = disasm_xori(instr);
-			break;
-		case 15:
-			ret = disasm_lui(instr);
-			break;
-		default:
-			ret = -1;
-			break;
+	if(!op || (instr & disasm_fmts[op->fmt].zero)) {
+		cprint_str("???");
+		return -1;
 	}
 
-	return ret;
-}
-
+	opnd = disasm_fmts[op->fmt].opnds;
 
-int disasm_instr(u32 instr, u32 addr)
-{
-	int ret;
-	union instruction iw;
-	iw.word = instr;
+	/* Shift of zero register to itself */
+	if(!(instr & ~FLD_SHAMT)) {
+		cprint_str("nop");
+		return 0;
+	}
 
-	switch(iw.r.op) {
-		case 0:
-			ret = disasm_special(instr);
-			break;
-		case 1:
-			ret = disasm_regimm(instr, addr);
-			break;
-		case 16:
-			ret = disasm_cop0(instr);
-			break;
-		case 32:
-		case 33:
-		case 35:
-		case 36:
-		case 37:
-		case 40:
-		case 41:
-		case 43:
-			ret = disasm_load_store(instr);
-			break;
-		case 2:
-		case 3:
-		case 4:
-		case 5:
-		case 6:
-		case 7:
-		case 8:
-		case 9:
-		case 10:
-		case 11:
-		case 12:
-		case 13:
-		case 14:
-		case 15:
-			ret = disasm_other(instr, addr);
-			break;
-		default:
-			ret = -1;
-			break;
+	if(!*opnd) {
+		cprint_str(op->name);
+		return 0;
 	}
 
-	if(ret < 0)
-		cprint_str("???");
+	cprint_strf(op->name, IFLDW);
+	for(; *opnd; ++opnd) {
+		if(opnd != disasm_fmts[op->fmt].opnds)
+			cprint_str(", ");
+		disasm_opnd(*opnd, instr, addr);
+	}
 
-	return ret;
+	return 0;
 }
 
 
@@ -32,6 +32,10 @@
 #include <elf_stream.h>
 
 
+/* Largest gap between segments in memory treated as padding */
+#define ELFS_GAP_MAX	64
+
+
 /* Consume stream buffer */
 static inline void consume_buffer(struct elf_stream *es, size_t size)
 {
@@ -42,66 +46,167 @@ static inline void consume_buffer(struct elf_stream *es, size_t size)
 
 
 /* Place program segment in memory */
-static void place_seg(struct elf_stream *es, size_t s)
+static void place_seg(struct elf_stream *es, struct segment *seg)
 {
-	struct segment *seg = &es->segs[s];
-	size_t sbegin = es->s_pos;
+	size_t i = seg->fbegin - es->s_pos;	/* Segment data start in buffer */
+	size_t rem = seg->fend - seg->fbegin;
+	size_t sz = es->buf_sz - i;
 
-	if(seg->addr != (unsigned long)es->buf) {	/* Loaded segment data is not on its place */
-		void *p = (void*)seg->addr;
-		size_t i = seg->fbegin - sbegin;
-		size_t sz = es->buf_sz - i;
-		sz = ((sz + seg->fbegin) > seg->fend ? seg->fend - seg->fbegin : sz);
-		memmove(p, es->buf + i, sz);	/* Move data */
+	sz = (sz > rem ? rem : sz);
+
+	/* Move data if it was not received in place */
+	if(seg->addr != (unsigned long)&es->buf[i])
+		memmove((void*)seg->addr, &es->buf[i], sz);
 
-		consume_buffer(es, sz + i);
+	consume_buffer(es, i + sz);
 
-		seg->addr += sz;
-		seg->fbegin += sz;
-	} else {					/* Segment data placed correctly */
-		size_t rem = seg->fend - seg->fbegin;
-		size_t sz = (es->buf_sz > rem ? rem : es->buf_sz);
+	seg->addr += sz;
+	seg->fbegin += sz;
+}
 
-		consume_buffer(es, sz);
 
-		seg->addr += sz;
-		seg->fbegin += sz;
-	}
+/* Zero-fill memory beyond file data of all segments */
+static void fill_bss(struct elf_stream *es)
+{
+	size_t s;
 
-	/* Update load destination */
-	es->offset(es->udata, seg->addr);
+	for(s = 0; s < es->phnld; ++s) {
+		struct segment *seg = &es->segs[s];
+		size_t filesz = seg->addr - seg->paddr;
+
+		if(seg->memsz > filesz)
+			memset((void*)seg->addr, 0, seg->memsz - filesz);
+	}
 }
 
 
-/* Load program segments */
-static int load_seg(struct elf_stream *es)
+/* Get first segment with data not loaded yet */
+static struct segment *next_seg(struct elf_stream *es)
 {
-	size_t sbegin = es->s_pos;
-	size_t send = sbegin + es->buf_sz;
 	size_t s;
-	unsigned ld = 0;	/* Number of loaded segments */
 
 	for(s = 0; s < es->phnld; ++s) {
-		if(es->segs[s].fbegin == es->segs[s].fend) {
-			++ld;	/* Segment already loaded, count it */
-		} else if(send > es->segs[s].fbegin && sbegin < es->segs[s].fend) {
-			place_seg(es, s);
-			return ELFS_NONE;
-		}
+		if(es->segs[s].fbegin != es->segs[s].fend)
+			return &es->segs[s];
 	}
 
-	if(ld == es->phnld) {
+	return NULL;
+}
+
+
+/* Load program segments */
+static int load_seg(struct elf_stream *es)
+{
+	struct segment *seg = next_seg(es);
+
+	if(!seg) {
+		fill_bss(es);
 		return ELFS_LOADED;	/* All segments loaded. */
-	} else if(s == es->phnld) {
-		/* Data is not related to any loadable segment, keep load address unchanged */
-		es->offset(es->udata, (unsigned long)es->buf);
+	}
+
+	/* Bad, segment data overlaps data of another segment */
+	if(seg->fbegin < es->s_pos)
+		return ELFS_INV_LAYOUT;
+
+	if(seg->fbegin >= es->s_pos + es->buf_sz) {
+		/* Data is not related to any loadable segment, skip it */
 		consume_buffer(es, es->buf_sz);
+		return ELFS_NONE;
+	}
+
+	place_seg(es, seg);
+
+	/* File may end with the last segment */
+	if(!next_seg(es)) {
+		fill_bss(es);
+		return ELFS_LOADED;
 	}
 
 	return ELFS_NONE;
 }
 
 
+/* Check if memory range is owned by segments and holds no loaded data of
+ * other segments. Only such memory may be used to receive input buffer.
+ * Small gaps between segments are alignment padding and also accepted.
+ */
+static int dest_free(struct elf_stream *es, struct segment *seg, unsigned long addr, size_t sz)
+{
+	unsigned long end = addr + sz;
+	size_t s;
+
+	if(end < addr)
+		return 0;
+
+	while(addr < end) {
+		struct segment *o = NULL;
+		unsigned long prev = 0, next = 0;
+
+		for(s = 0; s < es->phnld; ++s) {
+			unsigned long b = es->segs[s].paddr;
+			unsigned long e = b + es->segs[s].memsz;
+
+			if(addr >= b && addr < e)
+				o = &es->segs[s];	/* Segment memory containing the address */
+			else if(e <= addr && e > prev)
+				prev = e;		/* End of the closest segment below */
+			else if(b > addr && (!next || b < next))
+				next = b;		/* Start of the closest segment above */
+		}
+
+		if(o) {
+			if(o != seg && addr < o->addr)
+				return 0;
+			addr = o->paddr + o->memsz;
+		} else if(prev && next && next - prev <= ELFS_GAP_MAX)
+			addr = next;
+		else
+			return 0;
+	}
+
+	return 1;
+}
+
+
+/* Predict destination of the next input buffer so that segment data lands
+ * in place. Scratch buffer is used if there is no segment data in the next
+ * buffer or landing there would damage loaded data.
+ */
+static unsigned long next_dest(struct elf_stream *es)
+{
+	struct segment *seg, *s, *prev;
+	size_t send = es->s_pos + es->scratch_sz;
+	unsigned long addr;
+
+	if(es->parser != load_seg || !(seg = next_seg(es)))
+		return (unsigned long)es->scratch;
+
+	if(seg->fbegin - es->s_pos >= es->scratch_sz)
+		return (unsigned long)es->scratch;	/* Segment starts later in stream */
+
+	/* Data preceding the segment in buffer lands right before it */
+	addr = seg->addr - (seg->fbegin - es->s_pos);
+
+	/* Data of other segments in buffer must also land in place. Moving
+	 * it would overwrite buffer contents not parsed yet. Only the last
+	 * segment in buffer may be moved.
+	 */
+	prev = seg;
+	for(s = seg + 1; s < &es->segs[es->phnld] && s->fbegin < send; ++s) {
+		if(s->fbegin == s->fend)
+			continue;	/* No file data */
+		if(prev->addr != addr + (prev->fbegin - es->s_pos))
+			return (unsigned long)es->scratch;
+		prev = s;
+	}
+
+	if(!dest_free(es, seg, addr, es->scratch_sz))
+		return (unsigned long)es->scratch;
+
+	return addr;
+}
+
+
 /* Program headers parser */
 static int parse_phdr(struct elf_stream *es)
 {
@@ -142,14 +247,25 @@ static int parse_phdr(struct elf_stream *es)
 
 
 	if(phdr->p_type == PT_LOAD) {	/* Loadable segment */
+		size_t s;
+
 		/* Check if there is space to save segment data */
 		if(es->phnld == (sizeof(es->segs) / sizeof(es->segs[0])))
 			return ELFS_INV_LAYOUT;
 
+		if(phdr->p_memsz < phdr->p_filesz)
+			return ELFS_INV_LAYOUT;
+
+		/* Keep segments sorted by stream offset */
+		for(s = es->phnld; s && es->segs[s - 1].fbegin > phdr->p_offset; --s)
+			es->segs[s] = es->segs[s - 1];
+
 		/* Save segment data */
-		es->segs[es->phnld].addr = phdr->p_paddr;
-		es->segs[es->phnld].fbegin = phdr->p_offset;
-		es->segs[es->phnld].fend = es->segs[es->phnld].fbegin + phdr->p_filesz;
+		es->segs[s].addr = phdr->p_paddr;
+		es->segs[s].paddr = phdr->p_paddr;
+		es->segs[s].memsz = phdr->p_memsz;
+		es->segs[s].fbegin = phdr->p_offset;
+		es->segs[s].fend = phdr->p_offset + phdr->p_filesz;
 
 		++es->phnld;
 	}
@@ -227,11 +343,14 @@ static int parse_ehdr(struct elf_stream *es)
 }
 
 
-void elf_stream_init(struct elf_stream* es, void (*offset)(void*, unsigned long), void *udata)
+void elf_stream_init(struct elf_stream* es, void (*offset)(void*, unsigned long), void *udata,
+	void *scratch, size_t scratch_sz)
 {
 	memset(es, 0, sizeof(struct elf_stream));
 	es->offset = offset;
 	es->udata = udata;
+	es->scratch = (char*)scratch;
+	es->scratch_sz = scratch_sz;
 	es->parser = parse_ehdr;
 }
 
@@ -247,5 +366,9 @@ int elf_stream_parse(struct elf_stream* es, void *buf, size_t sz)
 			break;
 	}
 
+	/* Direct the next input buffer */
+	if(!es->status && es->scratch)
+		es->offset(es->udata, next_dest(es));
+
 	return es->status;
 }
@@ -30,7 +30,9 @@
 #include <stddef.h>
 #include <con.h>
 #include <str.h>
+#include <cmd.h>
 #include <cmd_types.h>
+#include <uart.h>
 
 
 /* Trigger exception */
@@ -44,12 +46,12 @@ static int cmd_exc(struct cmd_args *args)
 	}
 
 	/* Parse exception number */
-	if(str2u(args->args[1], &exc_no) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[1], &exc_no) < 0)
 		return -1;
-	}
+
+#if CONFIG_UART_IRQ
+	uart_irq_disable();	/* Exception handler uses polled mode */
+#endif
 
 	switch(exc_no) {
 		case 0:		/* Reset */
@@ -29,6 +29,9 @@
 
 #include <stddef.h>
 #include <arch.h>
+#include <soc_regs.h>
+#include <config.h>
+#include <uart.h>
 #include <con.h>
 #include <disasm.h>
 
@@ -64,6 +67,26 @@ static const char *cause_str(u32 vec)
 }
 
 
+int intr_entry(struct interrupt_frame *p)
+{
+	u32 status = readl(USOC_INTCTL_STATUS);
+
+	/* Nothing pending: vector was reached by a jump (e.g. 'exc 7') */
+	if(!status)
+		return -1;
+
+#if CONFIG_UART_IRQ
+	if(status & USOC_INTCTL_UARTINT) {
+		uart_isr();
+		status &= ~USOC_INTCTL_UARTINT;
+	}
+#endif
+
+	/* Report unexpected interrupt lines */
+	return status ? -1 : 0;
+}
+
+
 void interrupt_entry(struct interrupt_frame *p)
 {
 	char ch;
@@ -30,8 +30,11 @@
 #include <stddef.h>
 #include <con.h>
 #include <str.h>
+#include <cmd.h>
 #include <cmd_types.h>
 #include <global.h>
+#include <uart.h>
+#include <irq.h>
 
 
 /* Jump */
@@ -45,12 +48,12 @@ static int cmd_jmp(struct cmd_args *args)
 	}
 
 	/* Parse address */
-	if(str2u(args->args[1], &addr) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[1], &addr) < 0)
 		return -1;
-	}
+
+#if CONFIG_UART_IRQ
+	uart_irq_disable();	/* Called code owns interrupts */
+#endif
 
 	/* Do jump */
 	__asm__ __volatile__ (
@@ -64,13 +67,19 @@ static int cmd_jmp(struct cmd_args *args)
 		:
 	);
 
+#if CONFIG_UART_IRQ
+	/* Called code returned, resume interrupt-driven console */
+	irq_rom_vectors();
+	uart_irq_enable();
+#endif
+
 	return 0;
 }
 COMMAND(j0jmp, "jmp", "jmp <addr>", "jump to address", cmd_jmp);
 
 
 /* Run */
-static int cmd_run(struct cmd_args *args)
+static int cmd_run_elf(struct cmd_args *args)
 {
 	unsigned long addr = G()->elf_entry;
 
@@ -79,6 +88,10 @@ static int cmd_run(struct cmd_args *args)
 		return -1;
 	}
 
+#if CONFIG_UART_IRQ
+	uart_irq_disable();	/* Called code owns interrupts */
+#endif
+
 	/* Do jump */
 	__asm__ __volatile__ (
 		".set push       ;"
@@ -91,6 +104,12 @@ static int cmd_run(struct cmd_args *args)
 		:
 	);
 
+#if CONFIG_UART_IRQ
+	/* Called code returned, resume interrupt-driven console */
+	irq_rom_vectors();
+	uart_irq_enable();
+#endif
+
 	return 0;
 }
-COMMAND(j0run, "run", "run", "run loaded ELF binary", cmd_run);
+COMMAND(j0run, "run", "run", "run loaded ELF binary", cmd_run_elf);
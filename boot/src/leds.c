@@ -32,6 +32,7 @@
 #include <soc_regs.h>
 #include <con.h>
 #include <str.h>
+#include <cmd.h>
 #include <cmd_types.h>
 
 
@@ -49,12 +50,8 @@ static int cmd_led(struct cmd_args *args)
 	}
 
 	/* Parse mask */
-	if(str2u(args->args[1], &mask) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[1], &mask) < 0)
 		return -1;
-	}
 
 
 	writel(mask, USOC_CTRL_LED);
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * LZ compressed stream decoder
+ */
+
+#include <config.h>
+#include <lz_stream.h>
+
+
+#if CONFIG_ELF_LZ
+
+/* Parser states */
+#define ST_HDR		0	/* Stream header */
+#define ST_TOKEN	1	/* Sequence token */
+#define ST_LITLEN	2	/* Literals length extension */
+#define ST_LIT		3	/* Literals */
+#define ST_OFF_LO	4	/* Match offset, low byte */
+#define ST_OFF_HI	5	/* Match offset, high byte */
+#define ST_MLEN		6	/* Match length extension */
+#define ST_MATCH	7	/* Match copy */
+#define ST_DONE		8	/* All data decoded */
+#define ST_ERR		9	/* Stream error */
+
+
+/* Pass decoded data to output */
+static int flush_win(struct lz_stream *lz)
+{
+	size_t n = lz->wpos - lz->fpos;
+	char *p = &lz->win[lz->fpos & lz->win_mask];
+
+	if(!n)
+		return 0;
+
+	lz->fpos = lz->wpos;
+
+	return lz->out(lz->udata, p, n);
+}
+
+
+/* Store decoded byte. Output is flushed at window end. */
+static inline int put_byte(struct lz_stream *lz, char b)
+{
+	lz->win[lz->wpos & lz->win_mask] = b;
+	++lz->wpos;
+
+	return (lz->wpos & lz->win_mask) ? 0 : flush_win(lz);
+}
+
+
+/* Parse stream header */
+static int parse_hdr(struct lz_stream *lz)
+{
+	const unsigned char *h = lz->hdr;
+	unsigned wlog = h[4];
+
+	if(h[0] != LZS_MAGIC[0] || h[1] != LZS_MAGIC[1] ||
+	  h[2] != LZS_MAGIC[2] || h[3] != LZS_MAGIC[3])
+		return LZS_ERR_FMT;
+
+	if(wlog > 16 || ((size_t)1 << wlog) > lz->win_mask + 1)
+		return LZS_ERR_WIN;
+
+	lz->size = h[8] | (h[9] << 8) | (h[10] << 16) | ((size_t)h[11] << 24);
+
+	return LZS_OK;
+}
+
+
+void lz_stream_init(struct lz_stream *lz, char *win, size_t win_sz,
+	int (*out)(void*, void*, size_t), void *udata)
+{
+	lz->state = ST_HDR;
+	lz->hdr_sz = 0;
+	lz->size = 0;
+	lz->lit_len = 0;
+	lz->match_len = 0;
+	lz->offset = 0;
+	lz->win = win;
+	lz->win_mask = win_sz - 1;
+	lz->wpos = 0;
+	lz->fpos = 0;
+	lz->out = out;
+	lz->udata = udata;
+}
+
+
+int lz_stream_feed(struct lz_stream *lz, const void *buf, size_t sz)
+{
+	const unsigned char *p = (const unsigned char*)buf;
+	const unsigned char *end = p + sz;
+	int r = LZS_OK;
+
+	if(lz->state == ST_ERR)
+		return LZS_ERR_FMT;
+
+	/* Trailing data after the last sequence is ignored */
+	while(p != end && r == LZS_OK && lz->state != ST_DONE) {
+		switch(lz->state) {
+			case ST_HDR:
+				lz->hdr[lz->hdr_sz++] = *p++;
+				if(lz->hdr_sz == LZS_HDR_SZ) {
+					r = parse_hdr(lz);
+					lz->state = (lz->size ? ST_TOKEN : ST_DONE);
+				}
+				break;
+			case ST_TOKEN:
+				lz->lit_len = *p >> 4;
+				lz->match_len = *p & 0xF;
+				++p;
+				lz->state = (lz->lit_len == 0xF ? ST_LITLEN :
+					lz->lit_len ? ST_LIT : ST_OFF_LO);
+				break;
+			case ST_LITLEN:
+				lz->lit_len += *p;
+				if(*p++ != 0xFF)
+					lz->state = ST_LIT;
+				break;
+			case ST_LIT:
+				if(lz->lit_len > lz->size - lz->wpos) {
+					r = LZS_ERR_FMT;
+					break;
+				}
+				while(p != end && lz->lit_len && r == LZS_OK) {
+					r = put_byte(lz, *p++);
+					--lz->lit_len;
+				}
+				if(!lz->lit_len)
+					lz->state = ST_OFF_LO;
+				break;
+			case ST_OFF_LO:
+				lz->offset = *p++;
+				lz->state = ST_OFF_HI;
+				break;
+			case ST_OFF_HI:
+				lz->offset |= *p++ << 8;
+				if(!lz->offset || lz->offset > lz->wpos ||
+				  lz->offset > lz->win_mask + 1) {
+					r = LZS_ERR_FMT;
+					break;
+				}
+				lz->state = (lz->match_len == 0xF ? ST_MLEN : ST_MATCH);
+				lz->match_len += LZS_MIN_MATCH;
+				break;
+			case ST_MLEN:
+				lz->match_len += *p;
+				if(*p++ != 0xFF)
+					lz->state = ST_MATCH;
+				break;
+			default: ;
+		}
+
+		/* Match does not consume input */
+		if(lz->state == ST_MATCH && r == LZS_OK) {
+			if(lz->match_len > lz->size - lz->wpos)
+				r = LZS_ERR_FMT;
+			while(lz->match_len && r == LZS_OK) {
+				r = put_byte(lz, lz->win[(lz->wpos - lz->offset) & lz->win_mask]);
+				--lz->match_len;
+			}
+			lz->state = ST_TOKEN;
+		}
+
+		/* Last sequence ends with literals or match */
+		if(lz->wpos == lz->size && lz->state != ST_HDR)
+			lz->state = ST_DONE;
+	}
+
+	if(r < 0)
+		lz->state = ST_ERR;
+	else if(r == LZS_OK)
+		r = flush_win(lz);
+
+	return r;
+}
+
+
+int lz_stream_done(struct lz_stream *lz)
+{
+	return lz->state == ST_DONE;
+}
+
+#endif /* CONFIG_ELF_LZ */
@@ -57,6 +57,9 @@ void boot_entry()
 	/* Init serial console */
 	uart_init();
 	con_init();
+#if CONFIG_UART_IRQ
+	uart_irq_enable();
+#endif
 
 	con_set_flags(con_get_flags() | CON_FLAGS_ECHO);	/* Enable echo by default */
 	con_set_flags(con_get_flags() | CON_FLAGS_LFCR);	/* Enable CR after LF by default */
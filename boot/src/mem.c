@@ -32,7 +32,9 @@
 #include <con.h>
 #include <str.h>
 #include <ctype.h>
+#include <cmd.h>
 #include <cmd_types.h>
+#include <crc16_ccitt.h>
 
 
 /* Read template */
@@ -59,12 +61,8 @@ static int cmd_read(struct cmd_args *args)
 	}
 
 	/* Parse address */
-	if(str2u(args->args[1], &addr) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[1], &addr) < 0)
 		return -1;
-	}
 
 	if(strcmp(args->args[0], "rdb") == 0) {
 		u8 v = readT(u8, addr);
@@ -96,20 +94,12 @@ static int cmd_write(struct cmd_args *args)
 	}
 
 	/* Parse address */
-	if(str2u(args->args[1], &addr) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[1], &addr) < 0)
 		return -1;
-	}
 
 	/* Parse value */
-	if(str2u(args->args[2], &value) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[2]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[2], &value) < 0)
 		return -1;
-	}
 
 	if(strcmp(args->args[0], "wdb") == 0) {
 		cprint_str("0x"); cprint_hex8(value); cprint_str(" --> ");
@@ -145,28 +135,16 @@ static int cmd_memset(struct cmd_args *args)
 	}
 
 	/* Parse address */
-	if(str2u(args->args[1], &addr) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[1], &addr) < 0)
 		return -1;
-	}
 
 	/* Parse value */
-	if(str2u(args->args[2], &value) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[2]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[2], &value) < 0)
 		return -1;
-	}
 
 	/* Parse length */
-	if(str2u(args->args[3], &len) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[3]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[3], &len) < 0)
 		return -1;
-	}
 
 	if(len == 0) {
 		cprint_str("length is zero\n");
@@ -195,28 +173,16 @@ static int cmd_memmove(struct cmd_args *args)
 	}
 
 	/* Parse destination address */
-	if(str2u(args->args[1], &dst_addr) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[1], &dst_addr) < 0)
 		return -1;
-	}
 
 	/* Parse source address */
-	if(str2u(args->args[2], &src_addr) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[2]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[2], &src_addr) < 0)
 		return -1;
-	}
 
 	/* Parse length */
-	if(str2u(args->args[3], &len) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[3]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[3], &len) < 0)
 		return -1;
-	}
 
 	if(len == 0) {
 		cprint_str("length is zero\n");
@@ -234,6 +200,59 @@ static int cmd_memmove(struct cmd_args *args)
 COMMAND(m0memmv, "memmove", "memmove <dst> <src> <len>", "move block of memory", cmd_memmove);
 
 
+/* Block CRCs per output line */
+#define MEMCRC_PER_LINE		8
+
+
+/* Print CRC16 of each memory block */
+static int cmd_memcrc(struct cmd_args *args)
+{
+	unsigned addr;
+	unsigned len;
+	unsigned blk_sz = 1024;
+	unsigned i;
+
+	if(args->n < 3) {
+		cprint_str("Insufficient arguments.\n");
+		return -1;
+	}
+
+	/* Parse address */
+	if(cmd_arg2u(args->args[1], &addr) < 0)
+		return -1;
+
+	/* Parse length */
+	if(cmd_arg2u(args->args[2], &len) < 0)
+		return -1;
+
+	/* Parse block size */
+	if(args->n > 3 && (str2u(args->args[3], &blk_sz) < 0 || !blk_sz)) {
+		cmd_bad_arg(args->args[3]);
+		return -1;
+	}
+
+	/* Line format: <address>: <crc> <crc> ... Last block may be shorter. */
+	for(i = 0; len; ++i) {
+		unsigned n = (len < blk_sz ? len : blk_sz);
+
+		if(i % MEMCRC_PER_LINE == 0) {
+			if(i) cprint_str("\n");
+			cprint_hex32(addr); cprint_str(":");
+		}
+
+		cprint_str(" "); cprint_hex16(crc16_ccitt((const char*)addr, n));
+
+		addr += n;
+		len -= n;
+	}
+
+	if(i) cprint_str("\n");
+
+	return 0;
+}
+COMMAND(m0memcrc, "memcrc", "memcrc <addr> <len> [blk_size]", "print CRC16 of memory blocks", cmd_memcrc);
+
+
 /* Dump memory contents */
 static int cmd_memdump(struct cmd_args *args)
 {
@@ -249,29 +268,17 @@ static int cmd_memdump(struct cmd_args *args)
 	}
 
 	/* Parse address */
-	if(str2u(args->args[1], &addr) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[1], &addr) < 0)
 		return -1;
-	}
 
 	/* Parse length */
-	if(str2u(args->args[2], &len) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[2]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[2], &len) < 0)
 		return -1;
-	}
 
 	/* Parse lines per page if specified */
 	if(args->n > 3) {
-		if(str2u(args->args[3], &pp) < 0) {
-			cprint_str("Invalid argument: ");
-			cprint_str(args->args[3]);
-			cprint_str("\n");
+		if(cmd_arg2u(args->args[3], &pp) < 0)
 			return -1;
-		}
 		if(!pp)
 			pp = (unsigned)-1;
 	}
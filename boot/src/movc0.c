@@ -32,6 +32,7 @@
 #include <str.h>
 #include <disasm.h>
 #include <compiler.h>
+#include <cmd.h>
 #include <cmd_types.h>
 
 
@@ -128,9 +129,7 @@ static int cmd_mfc0(struct cmd_args *args)
 		}
 
 		if(reg_no > 31) {
-			cprint_str("Invalid argument: ");
-			cprint_str(args->args[1]);
-			cprint_str("\n");
+			cmd_bad_arg(args->args[1]);
 			return -1;
 		}
 	}
@@ -157,12 +156,8 @@ static int cmd_mtc0(struct cmd_args *args)
 	}
 
 	/* Parse value */
-	if(str2u(args->args[1], &v) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	if(cmd_arg2u(args->args[1], &v) < 0)
 		return -1;
-	}
 
 	/* Try to parse register as number */
 	if(str2u(args->args[2], &reg_no) < 0) {
@@ -175,9 +170,7 @@ static int cmd_mtc0(struct cmd_args *args)
 		}
 
 		if(reg_no > 31) {
-			cprint_str("Invalid argument: ");
-			cprint_str(args->args[2]);
-			cprint_str("\n");
+			cmd_bad_arg(args->args[2]);
 			return -1;
 		}
 	}
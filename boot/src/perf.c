@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Performance measurement commands
+ */
+
+#include <stddef.h>
+#include <arch.h>
+#include <soc_info.h>
+#include <soc_regs.h>
+#include <con.h>
+#include <str.h>
+#include <cmd.h>
+#include <cmd_types.h>
+#include <crc16_ccitt.h>
+#include <config.h>
+
+
+/* Commands with throughput reporting */
+static const struct {
+	const char *name;	/* Command name */
+	unsigned len_arg;	/* Index of length argument */
+} tput_cmds[] = {
+	{ "memset", 3 },
+	{ "memmove", 3 }
+};
+
+
+/* Counters printed by perf after cycles and time. Each one is preceded
+ * by its text, line breaks included.
+ */
+static const struct {
+	const char *text;	/* Text before value */
+	unsigned cnt;		/* Counter index */
+} perf_fields[] = {
+	{ "Instructions : ", USOC_PERF_IFETCH },
+	{ "I-Bus stalls : ", USOC_PERF_ISTALL },
+	{ " cycles\nD-Bus stalls : ", USOC_PERF_DSTALL },
+	{ " cycles\nBus transact.: mem ", USOC_PERF_BUS_MEM },
+	{ ", uart ", USOC_PERF_BUS_UART },
+	{ ", ctrl ", USOC_PERF_BUS_CTRL },
+	{ ", intctl ", USOC_PERF_BUS_INTCTL },
+	{ ", timer ", USOC_PERF_BUS_ITIMER },
+	{ "\nUART bytes   : tx ", USOC_PERF_UART_TX },
+	{ ", rx ", USOC_PERF_UART_RX },
+	{ "\nInterrupts   : ", USOC_PERF_INTR }
+};
+
+
+/* 64-bit division by shift and subtract. Results are only printed, so
+ * speed does not matter and libgcc is not needed. Kept out of line as it
+ * has several callers.
+ */
+static __attribute__((noinline))
+unsigned long long udiv64(unsigned long long n, unsigned long long d)
+{
+	unsigned long long q = 0, r = 0;
+	unsigned i;
+
+	if(!d)
+		return 0;
+
+	for(i = 0; i < 64; ++i) {
+		r = (r << 1) | (n >> 63);
+		n <<= 1;
+		q <<= 1;
+		if(r >= d) {
+			r -= d;
+			q |= 1;
+		}
+	}
+
+	return q;
+}
+
+
+/* Take snapshot of all performance counters */
+static void perf_snapshot(unsigned long long *cnt)
+{
+	int frozen = soc_perf_frozen();
+	unsigned i;
+
+	soc_perf_freeze(1);	/* Stop counting while reading */
+	for(i = 0; i < USOC_PERF_COUNT; ++i)
+		cnt[i] = soc_perf_counter(i);
+	soc_perf_freeze(frozen);	/* Keep counters stopped by user */
+}
+
+
+/* Print num/den with two decimal places */
+static void print_frac(unsigned long long num, unsigned long long den)
+{
+	unsigned long long v = udiv64(num * 100, den);
+	unsigned long long i = udiv64(v, 100);
+	unsigned f = (unsigned)(v - i * 100);
+
+	cprint_uint64(i);
+	cprint_str(f < 10 ? ".0" : ".");
+	cprint_uint(f);
+}
+
+
+/* Returns number of bytes processed by command or 0 */
+static unsigned tput_bytes(struct cmd_args *args)
+{
+	unsigned i;
+	unsigned len;
+
+	for(i = 0; i < sizeof(tput_cmds) / sizeof(tput_cmds[0]); ++i) {
+		if(!strcmp(args->args[0], tput_cmds[i].name) &&
+			args->n > tput_cmds[i].len_arg &&
+			str2u(args->args[tput_cmds[i].len_arg], &len) == 0)
+			return len;
+	}
+
+	return 0;
+}
+
+
+/* Run command and report performance counters */
+static int cmd_perf(struct cmd_args *args)
+{
+	unsigned long long before[USOC_PERF_COUNT];
+	unsigned long long after[USOC_PERF_COUNT];
+	unsigned long long cycles;
+	struct cmd_args sub;
+	unsigned freq = soc_sys_freq();
+	unsigned bytes;
+	unsigned i;
+	int full = strcmp(args->args[0], "time");
+	int ret;
+
+	if(args->n < 2) {
+		cprint_str("Insufficient arguments.\n");
+		return -1;
+	}
+
+	/* Strip own name */
+	sub.n = args->n - 1;
+	for(i = 0; i < sub.n; ++i)
+		sub.args[i] = args->args[i + 1];
+
+	if(!strcmp(sub.args[0], "perf") || !strcmp(sub.args[0], "time")) {
+		cprint_str("Nested measurement is not supported.\n");
+		return -1;
+	}
+
+	perf_snapshot(before);
+	ret = cmd_exec(&sub);
+	perf_snapshot(after);
+
+	if(ret == CMD_ENENT)
+		return ret;
+
+	for(i = 0; i < USOC_PERF_COUNT; ++i)
+		after[i] -= before[i];
+	cycles = after[USOC_PERF_CYCLES];
+	bytes = tput_bytes(&sub);
+
+	cprint_str("\nCycles       : "); cprint_uint64(cycles);
+	cprint_str("\nTime         : "); cprint_uint64(udiv64(cycles * 1000000, freq));
+	cprint_str(" us\n");
+	if(full) {
+		for(i = 0; i < sizeof(perf_fields) / sizeof(perf_fields[0]); ++i) {
+			cprint_str(perf_fields[i].text);
+			cprint_uint64(after[perf_fields[i].cnt]);
+			if(perf_fields[i].cnt == USOC_PERF_IFETCH) {
+				cprint_str(" fetched, IPC ");
+				print_frac(after[USOC_PERF_IFETCH], cycles);
+				cprint_str("\n");
+			}
+		}
+		cprint_str("\n");
+	}
+	if(bytes && cycles) {
+		cprint_str("Throughput   : ");
+		cprint_uint64(udiv64((unsigned long long)bytes * freq, cycles) >> 10);
+		cprint_str(" KB/s, ");
+		print_frac((unsigned long long)bytes, cycles);
+		cprint_str(" bytes/cycle\n");
+	}
+
+	return ret;
+}
+COMMAND(p0perf, "perf", "perf <cmd> [args]", "run command and print performance counters", cmd_perf);
+COMMAND(p0time, "time", "time <cmd> [args]", "run command and print elapsed time", cmd_perf);
+
+
+/* Returns current cycle count */
+static inline
+unsigned long long cycles_now()
+{
+	return soc_perf_counter(USOC_PERF_CYCLES);
+}
+
+
+#if CONFIG_MEMBENCH
+/* Print benchmark result line */
+static void bench_result(const char *name, unsigned len, unsigned long long cycles)
+{
+	cprint_strf(name, 24);
+	cprint_uint64(cycles);
+	cprint_str(" cycles, ");
+	print_frac(len, cycles);
+	cprint_str(" bytes/cycle\n");
+}
+
+
+/* Memory routines microbenchmark */
+static int cmd_membench(struct cmd_args *args)
+{
+	unsigned addr;
+	unsigned len = 4096;
+	unsigned long long t;
+	unsigned char *a, *b;
+
+	/* Benchmark overwrites memory, address must be given */
+	if(args->n < 2) {
+		cprint_str("Insufficient arguments.\n");
+		return -1;
+	}
+
+	/* Parse address */
+	if(cmd_arg2u(args->args[1], &addr) < 0)
+		return -1;
+
+	/* Parse length */
+	if(args->n > 2 && cmd_arg2u(args->args[2], &len) < 0)
+		return -1;
+
+	if(len < 16) {
+		cprint_str("Length is too small.\n");
+		return -1;
+	}
+
+	/* Two buffers with a gap for misaligned and overlapping cases */
+	addr = (addr + 3) & ~3;
+	a = (unsigned char *)addr;
+	b = a + len + 16;
+
+	cprint_str("Buffers: [0x"); cprint_hex32((unsigned)a); cprint_str("-0x");
+		cprint_hex32((unsigned)b + len - 1); cprint_str("], ");
+		cprint_uint(len); cprint_str(" bytes\n");
+
+	t = cycles_now();
+	memset(a, 0x5A, len);
+	bench_result("memset", len, cycles_now() - t);
+
+	t = cycles_now();
+	memcpy(b, a, len);
+	bench_result("memcpy aligned", len, cycles_now() - t);
+
+	t = cycles_now();
+	memcpy(b, a + 1, len);
+	bench_result("memcpy misaligned", len, cycles_now() - t);
+
+	t = cycles_now();
+	memmove(a + 4, a, len);
+	bench_result("memmove backward", len, cycles_now() - t);
+
+	t = cycles_now();
+	memmove(a, a + 4, len);
+	bench_result("memmove forward", len, cycles_now() - t);
+
+	memcpy(b, a, len);
+	t = cycles_now();
+	memcmp(a, b, len);
+	bench_result("memcmp equal", len, cycles_now() - t);
+
+	return 0;
+}
+COMMAND(p1membch, "membench", "membench <addr> [len]", "benchmark memory routines", cmd_membench);
+#endif
+
+
+#if CONFIG_CRC16_BENCH
+/* CRC16 implementations */
+static const struct {
+	const char *name;
+	crc16_t (*update)(const char *ptr, size_t n, crc16_t crc);
+} crc_impls[] = {
+	{ "bitwise", crc16_ccitt_update_bit },
+	{ "nibble table", crc16_ccitt_update_nibble },
+	{ "byte table", crc16_ccitt_update_table }
+};
+
+
+/* CRC16 implementations benchmark */
+static int cmd_crcbench(struct cmd_args *args)
+{
+	unsigned addr = soc_ram_base();
+	unsigned len = 1024;
+	unsigned long long t;
+	crc16_t crc, ref = 0;
+	unsigned i;
+
+	/* Parse address */
+	if(args->n > 1 && cmd_arg2u(args->args[1], &addr) < 0)
+		return -1;
+
+	/* Parse length */
+	if(args->n > 2 && cmd_arg2u(args->args[2], &len) < 0)
+		return -1;
+
+	if(!len) {
+		cprint_str("Length is too small.\n");
+		return -1;
+	}
+
+	cprint_str("Buffer: [0x"); cprint_hex32(addr); cprint_str("-0x");
+		cprint_hex32(addr + len - 1); cprint_str("], ");
+		cprint_uint(len); cprint_str(" bytes\n");
+
+	for(i = 0; i < sizeof(crc_impls) / sizeof(crc_impls[0]); ++i) {
+		t = cycles_now();
+		crc = crc_impls[i].update((const char *)addr, len, 0);
+		t = cycles_now() - t;
+
+		cprint_strf(crc_impls[i].name, 16);
+		cprint_uint64(t);
+		cprint_str(" cycles, ");
+		print_frac(t, len);
+		cprint_str(" cycles/byte, crc 0x");
+		cprint_hex16(crc);
+		if(i && crc != ref)
+			cprint_str(" MISMATCH");
+		cprint_str("\n");
+
+		if(!i)
+			ref = crc;
+	}
+
+	return 0;
+}
+COMMAND(p1crcbch, "crcbench", "crcbench [addr] [len]", "benchmark CRC16 implementations", cmd_crcbench);
+#endif
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Binary RPC mode
+ */
+
+#include <stddef.h>
+#include <arch.h>
+#include <soc_info.h>
+#include <config.h>
+#include <uart.h>
+#include <irq.h>
+#include <str.h>
+#include <crc16_ccitt.h>
+#include <rpc.h>
+
+
+#if CONFIG_RPC
+
+#define BYTE_TMO_MS	100	/* Inter-byte timeout within frame */
+
+/* rx_frame() results */
+#define RX_OK		0	/* Frame received */
+#define RX_BAD		1	/* Broken frame, skipped */
+#define RX_IDLE		2	/* No requests within idle time */
+
+
+/* Request frame */
+struct rpc_frame {
+	unsigned char cmd;
+	unsigned char seq;
+	size_t len;
+	unsigned char data[RPC_MAX_LEN];
+};
+
+
+/* Receive byte within timeout */
+static int rx_byte(unsigned timeout_ms)
+{
+	u32 end = rdtsc_lo() + timeout_ms * (soc_sys_freq() / 1000);
+	int ch;
+
+	do {
+		ch = uart_get_char();
+	} while(ch < 0 && (long)rdtsc_lo() - (long)end < 0);
+
+	return ch;
+}
+
+
+/* Send byte and update CRC */
+static inline crc16_t tx_byte(unsigned char b, crc16_t crc)
+{
+	uart_put_char(b);
+	return crc16_ccitt_update((const char*)&b, 1, crc);
+}
+
+
+/* Send response frame */
+static void tx_frame(unsigned status, unsigned seq, const void *data, size_t len)
+{
+	const unsigned char *p = (const unsigned char*)data;
+	crc16_t crc = 0;
+	size_t i;
+
+	uart_put_char(RPC_SYNC_RSP);
+	crc = tx_byte(status, crc);
+	crc = tx_byte(seq, crc);
+	crc = tx_byte(len & 0xFF, crc);
+	crc = tx_byte(len >> 8, crc);
+
+	for(i = 0; i < len; ++i)
+		crc = tx_byte(p[i], crc);
+
+	uart_put_char(crc >> 8);
+	uart_put_char(crc & 0xFF);
+}
+
+
+/* Receive request frame */
+static int rx_frame(struct rpc_frame *f)
+{
+	unsigned char hdr[RPC_HDR_SZ - 1];
+	crc16_t crc;
+	unsigned i;
+	int ch, idle = RPC_IDLE_SEC;
+
+	/* Wait for frame start */
+	while((ch = rx_byte(1000)) != RPC_SYNC_REQ) {
+		if(ch < 0 && !--idle)
+			return RX_IDLE;
+	}
+
+	for(i = 0; i < sizeof(hdr); ++i) {
+		if((ch = rx_byte(BYTE_TMO_MS)) < 0)
+			return RX_BAD;
+		hdr[i] = ch;
+	}
+
+	f->cmd = hdr[0];
+	f->seq = hdr[1];
+	f->len = hdr[2] | (hdr[3] << 8);
+
+	/* Can not be a request, resync */
+	if(f->len > RPC_MAX_LEN)
+		return RX_BAD;
+
+	for(i = 0; i < f->len; ++i) {
+		if((ch = rx_byte(BYTE_TMO_MS)) < 0)
+			return RX_BAD;
+		f->data[i] = ch;
+	}
+
+	if((ch = rx_byte(BYTE_TMO_MS)) < 0)
+		return RX_BAD;
+	crc = ch << 8;
+	if((ch = rx_byte(BYTE_TMO_MS)) < 0)
+		return RX_BAD;
+	crc |= ch;
+
+	/* Host repeats request on error */
+	if(crc16_ccitt_update((const char*)f->data, f->len,
+		crc16_ccitt((const char*)hdr, sizeof(hdr))) != crc) {
+		tx_frame(RPC_ERR_CRC, f->seq, NULL, 0);
+		return RX_BAD;
+	}
+
+	return RX_OK;
+}
+
+
+/* Get 32-bit value from payload */
+static inline u32 get32(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+}
+
+
+/* Jump to address */
+static void do_jump(u32 addr)
+{
+	uart_tx_drain();
+#if CONFIG_UART_IRQ
+	uart_irq_disable();	/* Called code owns interrupts */
+#endif
+
+	__asm__ __volatile__ (
+		".set push       ;"
+		".set noreorder  ;"
+		"jalr %0         ;"
+		"nop             ;"
+		".set pop        ;"
+		:
+		: "r" (addr)
+		:
+	);
+
+#if CONFIG_UART_IRQ
+	/* Called code returned, resume interrupt-driven console */
+	irq_rom_vectors();
+	uart_irq_enable();
+#endif
+}
+
+
+/* Execute request. Returns nonzero to leave RPC mode. */
+static int exec_frame(struct rpc_frame *f)
+{
+	unsigned char rsp[4];
+	u32 addr = (f->len >= 4 ? get32(f->data) : 0);
+	u32 len = (f->len >= 8 ? get32(&f->data[4]) : 0);
+	unsigned status = RPC_OK;
+	int leave = 0;
+	crc16_t crc;
+
+	switch(f->cmd) {
+		case RPC_CMD_HELLO:
+			rsp[0] = RPC_VERSION;
+			rsp[1] = 0;
+			rsp[2] = RPC_MAX_DATA & 0xFF;
+			rsp[3] = RPC_MAX_DATA >> 8;
+			tx_frame(RPC_OK, f->seq, rsp, 4);
+			return 0;
+		case RPC_CMD_READ:
+			if(f->len != 8 || len > RPC_MAX_DATA) {
+				status = RPC_ERR_ARG;
+				break;
+			}
+			tx_frame(RPC_OK, f->seq, (const void*)addr, len);
+			return 0;
+		case RPC_CMD_WRITE:
+			if(f->len < 4) {
+				status = RPC_ERR_ARG;
+				break;
+			}
+			memcpy((void*)addr, &f->data[4], f->len - 4);
+			break;
+		case RPC_CMD_FILL:
+			if(f->len != 9) {
+				status = RPC_ERR_ARG;
+				break;
+			}
+			memset((void*)addr, f->data[8], len);
+			break;
+		case RPC_CMD_CRC:
+			if(f->len != 8) {
+				status = RPC_ERR_ARG;
+				break;
+			}
+			crc = crc16_ccitt((const char*)addr, len);
+			rsp[0] = crc & 0xFF;
+			rsp[1] = crc >> 8;
+			tx_frame(RPC_OK, f->seq, rsp, 2);
+			return 0;
+		case RPC_CMD_JUMP:
+			if(f->len != 4) {
+				status = RPC_ERR_ARG;
+				break;
+			}
+			tx_frame(RPC_OK, f->seq, NULL, 0);
+			do_jump(addr);
+			return 1;
+		case RPC_CMD_EXIT:
+			leave = 1;
+			break;
+		default:
+			status = RPC_ERR_CMD;
+			break;
+	}
+
+	tx_frame(status, f->seq, NULL, 0);
+
+	return leave;
+}
+
+
+void rpc_enter()
+{
+	struct rpc_frame f;
+	unsigned i;
+
+	/* Rest of magic sequence */
+	for(i = 1; i < sizeof(RPC_MAGIC) - 1; ++i) {
+		if(rx_byte(BYTE_TMO_MS) != RPC_MAGIC[i])
+			return;
+	}
+
+	/* Announce RPC mode */
+	f.cmd = RPC_CMD_HELLO;
+	f.seq = 0;
+	f.len = 0;
+	exec_frame(&f);
+
+	while(1) {
+		int r = rx_frame(&f);
+
+		if(r == RX_IDLE)
+			break;
+		else if(r == RX_OK && exec_frame(&f))
+			break;
+	}
+}
+
+#endif /* CONFIG_RPC */
@@ -55,40 +55,193 @@ int strcmp(const char *cs, const char *ct)
 }
 
 
+/*
+ * Memory routines below move aligned words instead of bytes where possible
+ * to cut number of bus transactions by four. Main loops are unrolled to
+ * handle four words per iteration.
+ */
+
+#define WSZ		(sizeof(unsigned))		/* Word size */
+#define WMASK		(WSZ - 1)			/* Word alignment mask */
+#define ALIGNED(p)	(!((unsigned long)(p) & WMASK))	/* Pointer is aligned */
+
+
 void *memset(void *s, int c, size_t n)
 {
-	char *xs = (char *)s;
+	unsigned char *xs = (unsigned char *)s;
+	unsigned *ws;
+	unsigned w;
+
+	/* Head bytes up to word boundary */
+	for( ; n > 0 && !ALIGNED(xs); --n)
+		*xs++ = (unsigned char)c;
+
+	/* Words */
+	w = (unsigned char)c;
+	w |= w << 8;
+	w |= w << 16;
+	ws = (unsigned *)xs;
+	for( ; n >= 4*WSZ; n -= 4*WSZ) {
+		ws[0] = w;
+		ws[1] = w;
+		ws[2] = w;
+		ws[3] = w;
+		ws += 4;
+	}
+	for( ; n >= WSZ; n -= WSZ)
+		*ws++ = w;
 
+	/* Tail bytes */
+	xs = (unsigned char *)ws;
 	for( ; n > 0; --n)
-		*xs++ = (char)c;
+		*xs++ = (unsigned char)c;
 
 	return s;
 }
 
 
-void *memmove(void *dst, const void *src, size_t n)
+/* Forward copy. Safe for overlapping blocks if dst is below src. */
+static void copy_fwd(unsigned char *d, const unsigned char *s, size_t n)
 {
-	const char *s = (const char*)src;
-	char *d = (char*)dst;
-	size_t i;
+	unsigned *wd;
+	const unsigned *ws;
+
+	/* Head bytes up to destination word boundary */
+	for( ; n > 0 && !ALIGNED(d); --n)
+		*d++ = *s++;
+
+	wd = (unsigned *)d;
+
+	if(ALIGNED(s)) {
+		/* Both aligned: copy words */
+		ws = (const unsigned *)s;
+		for( ; n >= 4*WSZ; n -= 4*WSZ) {
+			unsigned w0 = ws[0], w1 = ws[1], w2 = ws[2], w3 = ws[3];
+			wd[0] = w0;
+			wd[1] = w1;
+			wd[2] = w2;
+			wd[3] = w3;
+			wd += 4;
+			ws += 4;
+		}
+		for( ; n >= WSZ; n -= WSZ)
+			*wd++ = *ws++;
+		s = (const unsigned char *)ws;
+	} else if(n >= 2*WSZ) {
+		/*
+		 * Source misaligned: read aligned source words and merge
+		 * adjacent ones (little-endian). Reads never leave the words
+		 * which contain source bytes.
+		 */
+		unsigned sh = ((unsigned long)s & WMASK) * 8;
+		unsigned w0, w1;
+
+		ws = (const unsigned *)((unsigned long)s & ~WMASK);
+		w0 = *ws++;
+		for( ; n >= 2*WSZ; n -= WSZ) {
+			w1 = *ws++;
+			*wd++ = (w0 >> sh) | (w1 << (32 - sh));
+			w0 = w1;
+			s += WSZ;
+		}
+	}
+
+	/* Tail bytes */
+	d = (unsigned char *)wd;
+	for( ; n > 0; --n)
+		*d++ = *s++;
+}
+
+
+/* Backward copy. Safe for overlapping blocks if dst is above src. */
+static void copy_bwd(unsigned char *d, const unsigned char *s, size_t n)
+{
+	unsigned *wd;
+	const unsigned *ws;
+
+	d += n;
+	s += n;
+
+	/* Tail bytes down to destination word boundary */
+	for( ; n > 0 && !ALIGNED(d); --n)
+		*--d = *--s;
+
+	if(ALIGNED(s)) {
+		/* Both aligned: copy words */
+		wd = (unsigned *)d;
+		ws = (const unsigned *)s;
+		for( ; n >= 4*WSZ; n -= 4*WSZ) {
+			unsigned w0, w1, w2, w3;
+			wd -= 4;
+			ws -= 4;
+			w3 = ws[3]; w2 = ws[2]; w1 = ws[1]; w0 = ws[0];
+			wd[3] = w3;
+			wd[2] = w2;
+			wd[1] = w1;
+			wd[0] = w0;
+		}
+		for( ; n >= WSZ; n -= WSZ)
+			*--wd = *--ws;
+		d = (unsigned char *)wd;
+		s = (const unsigned char *)ws;
+	}
+
+	/* Head bytes */
+	for( ; n > 0; --n)
+		*--d = *--s;
+}
+
 
+void *memcpy(void *dst, const void *src, size_t n)
+{
+	copy_fwd((unsigned char *)dst, (const unsigned char *)src, n);
+
+	return dst;
+}
+
+
+void *memmove(void *dst, const void *src, size_t n)
+{
 	if(dst == src || !n)
 		return dst;
 
-	if(dst > src) {
-		do {
-			--n;
-			d[n] = s[n];
-		} while(n);
-	} else {
-		for(i = 0; i < n; ++i)
-			d[i] = s[i];
-	}
+	if(dst > src && (const char *)dst < (const char *)src + n)
+		copy_bwd((unsigned char *)dst, (const unsigned char *)src, n);
+	else
+		copy_fwd((unsigned char *)dst, (const unsigned char *)src, n);
 
 	return dst;
 }
 
 
+int memcmp(const void *s1, const void *s2, size_t n)
+{
+	const unsigned char *a = (const unsigned char *)s1;
+	const unsigned char *b = (const unsigned char *)s2;
+
+	/* Skip equal words if both blocks are equally aligned */
+	if(!(((unsigned long)a ^ (unsigned long)b) & WMASK)) {
+		for( ; n > 0 && !ALIGNED(a); --n, ++a, ++b) {
+			if(*a != *b)
+				return *a - *b;
+		}
+		for( ; n >= WSZ && *(const unsigned *)a == *(const unsigned *)b;
+				n -= WSZ) {
+			a += WSZ;
+			b += WSZ;
+		}
+	}
+
+	/* Find first difference */
+	for( ; n > 0; --n, ++a, ++b) {
+		if(*a != *b)
+			return *a - *b;
+	}
+
+	return 0;
+}
+
+
 /* Returns 1 if a string represents binary number */
 static inline
 int is_bin(const char *str, size_t l)
@@ -29,9 +29,25 @@
 
 #include <arch.h>
 #include <soc_regs.h>
+#include <config.h>
+#include <global.h>
+#include <irq.h>
 #include <uart.h>
 
 
+/* Transmitter bit time in cycles. Baud rate generator toggles its output
+ * every 8*div+1 cycles (upuart_brgen).
+ */
+#define TX_BIT_CYCLES(div)	(16 * (div) + 2)
+
+/* Receiver sampling period in cycles (upuart_brgen in oversampling mode) */
+#define RX_SAMPLE_CYCLES(div)	(2 * ((div) / 2 + 1))
+
+/* Ring index masks */
+#define RX_MASK		(CONFIG_UART_RXBUF_SZ - 1)
+#define TX_MASK		(CONFIG_UART_TXBUF_SZ - 1)
+
+
 void uart_init()
 {
 	u32 sys_freq = readl(USOC_CTRL_SYSFREQ);	/* UART frequency */
@@ -50,7 +66,9 @@ void uart_init()
 }
 
 
-int uart_get_char()
+/* Read char from RX FIFO */
+static inline
+int hw_get_char()
 {
 	int ret = -1;
 	if(!(readl(USOC_UART_CTRL) & USOC_UART_CTRL_RX_FE))
@@ -59,9 +77,313 @@ int uart_get_char()
 }
 
 
-void uart_put_char(char ch)
+/* Write char to TX FIFO */
+static inline
+void hw_put_char(char ch)
 {
 	while(readl(USOC_UART_CTRL) & USOC_UART_CTRL_TX_FF)
 		;
 	writel(ch, USOC_UART_DATA);
 }
+
+
+/* Lower bound of free space in TX FIFO */
+static inline
+unsigned hw_tx_free()
+{
+	u32 ctrl = readl(USOC_UART_CTRL);
+	if(ctrl & USOC_UART_CTRL_TX_FE)
+		return 2;
+	return (ctrl & USOC_UART_CTRL_TX_FF) ? 0 : 1;
+}
+
+
+#if CONFIG_UART_IRQ
+
+/* Move bytes from transmit ring to TX FIFO. TX interrupt is enabled while
+ * the ring has data. Called with interrupts disabled.
+ */
+static void tx_kick(struct uart_data *ud)
+{
+	unsigned ctrl;
+
+	while(ud->tx_head != ud->tx_tail &&
+		!(readl(USOC_UART_CTRL) & USOC_UART_CTRL_TX_FF)) {
+		writel(ud->tx_buf[ud->tx_head & TX_MASK], USOC_UART_DATA);
+		++ud->tx_head;
+	}
+
+	ctrl = (ud->tx_head == ud->tx_tail ? USOC_UART_CTRL_TX_IM : 0);
+	if(ctrl != ud->ctrl) {
+		ud->ctrl = ctrl;
+		writel(ctrl, USOC_UART_CTRL);
+	}
+}
+
+
+/* Send everything from transmit ring. Called with interrupts disabled. */
+static void tx_flush(struct uart_data *ud)
+{
+	while(ud->tx_head != ud->tx_tail)
+		tx_kick(ud);
+}
+
+
+void uart_isr()
+{
+	struct uart_data *ud = &G()->uart;
+
+	/* Drain RX FIFO */
+	while(!(readl(USOC_UART_CTRL) & USOC_UART_CTRL_RX_FE)) {
+		char ch = readl(USOC_UART_DATA);
+		if(ud->rx_tail - ud->rx_head < CONFIG_UART_RXBUF_SZ) {
+			ud->rx_buf[ud->rx_tail & RX_MASK] = ch;
+			++ud->rx_tail;
+		} else
+			++ud->rx_lost;
+	}
+
+	/* Refill TX FIFO */
+	tx_kick(ud);
+}
+
+
+void uart_irq_enable()
+{
+	struct uart_data *ud = &G()->uart;
+	unsigned sr = irq_save();
+
+	ud->rx_head = ud->rx_tail = 0;
+	ud->tx_head = ud->tx_tail = 0;
+	ud->rx_lost = 0;
+	ud->irq = 1;
+
+	/* RX interrupt on, TX interrupt on demand */
+	ud->ctrl = USOC_UART_CTRL_TX_IM;
+	writel(ud->ctrl, USOC_UART_CTRL);
+	writel(readl(USOC_INTCTL_MASK) | USOC_INTCTL_UARTINT, USOC_INTCTL_MASK);
+
+	irq_restore(sr | IRQ_SR_IE);
+}
+
+
+void uart_irq_disable()
+{
+	struct uart_data *ud = &G()->uart;
+	unsigned sr = irq_save();
+
+	if(ud->irq) {
+		tx_flush(ud);
+		writel(readl(USOC_INTCTL_MASK) & ~USOC_INTCTL_UARTINT, USOC_INTCTL_MASK);
+		writel((USOC_UART_CTRL_TX_IM | USOC_UART_CTRL_RX_IM), USOC_UART_CTRL);
+		ud->irq = 0;
+	}
+
+	irq_restore(sr & ~IRQ_SR_IE);
+}
+
+
+unsigned uart_rx_lost()
+{
+	return G()->uart.rx_lost;
+}
+
+
+int uart_get_char()
+{
+	struct uart_data *ud = &G()->uart;
+	int ch;
+
+	if(!ud->irq)
+		return hw_get_char();
+
+	if(ud->rx_head == ud->rx_tail) {
+		/* Interrupt handler fills the ring, it is off only together
+		 * with ud->irq. Idle loop still reads UART status like polled
+		 * mode: fast-forward of Verilated model (-ff) skips only loops
+		 * polling UART registers.
+		 */
+		(void)readl(USOC_UART_CTRL);
+		return -1;
+	}
+
+	ch = ud->rx_buf[ud->rx_head & RX_MASK] & 0xFF;
+	++ud->rx_head;
+
+	return ch;
+}
+
+
+int uart_try_put_char(char ch)
+{
+	struct uart_data *ud = &G()->uart;
+	unsigned sr;
+
+	if(!ud->irq) {
+		if(readl(USOC_UART_CTRL) & USOC_UART_CTRL_TX_FF)
+			return -1;
+		writel(ch, USOC_UART_DATA);
+		return 0;
+	}
+
+	if(ud->tx_tail - ud->tx_head >= CONFIG_UART_TXBUF_SZ)
+		return -1;
+
+	ud->tx_buf[ud->tx_tail & TX_MASK] = ch;
+	++ud->tx_tail;
+
+	sr = irq_save();
+	tx_kick(ud);
+	irq_restore(sr);
+
+	return 0;
+}
+
+
+unsigned uart_tx_free()
+{
+	struct uart_data *ud = &G()->uart;
+
+	if(!ud->irq)
+		return hw_tx_free();
+
+	return CONFIG_UART_TXBUF_SZ - (ud->tx_tail - ud->tx_head);
+}
+
+
+void uart_put_char(char ch)
+{
+	struct uart_data *ud = &G()->uart;
+	unsigned sr;
+
+	if(!ud->irq) {
+		hw_put_char(ch);
+		return;
+	}
+
+	while(uart_try_put_char(ch) < 0) {
+		sr = irq_save();
+		tx_kick(ud);
+		irq_restore(sr);
+	}
+
+	/* Ring is not drained with interrupts disabled */
+	if(!irq_enabled()) {
+		sr = irq_save();
+		tx_flush(ud);
+		irq_restore(sr);
+	}
+}
+
+
+#else /* !CONFIG_UART_IRQ */
+
+
+int uart_get_char()
+{
+	return hw_get_char();
+}
+
+
+int uart_try_put_char(char ch)
+{
+	if(readl(USOC_UART_CTRL) & USOC_UART_CTRL_TX_FF)
+		return -1;
+	writel(ch, USOC_UART_DATA);
+	return 0;
+}
+
+
+unsigned uart_tx_free()
+{
+	return hw_tx_free();
+}
+
+
+void uart_put_char(char ch)
+{
+	hw_put_char(ch);
+}
+
+
+#endif /* CONFIG_UART_IRQ */
+
+
+int uart_baud_divider(unsigned baud)
+{
+	u32 sys_freq = readl(USOC_CTRL_SYSFREQ);
+	u32 bit, div, d, err, best_err = 0;
+	int best = -1;
+
+	if(!baud || baud > sys_freq / TX_BIT_CYCLES(1))
+		return -1;
+
+	bit = sys_freq / baud;		/* Bit time in cycles */
+	div = (bit + 6) / 16;		/* Nearest transmitter divider */
+
+	/* Check neighbours, receiver may need a different rounding */
+	for(d = div > 1 ? div - 1 : 1; d <= div + 1 && d <= 0xFFFF; ++d) {
+		u32 tx = TX_BIT_CYCLES(d);
+		u32 smp = RX_SAMPLE_CYCLES(d);
+
+		err = tx > bit ? tx - bit : bit - tx;
+
+		/* Transmitter error must be within 2% */
+		if(err * 50 > bit)
+			continue;
+
+		/* Receiver takes 14.75 to 15.94 samples per bit (upuart_rx) */
+		if(16 * bit < 236 * smp || 16 * bit > 255 * smp)
+			continue;
+
+		if(best < 0 || err < best_err) {
+			best = d;
+			best_err = err;
+		}
+	}
+
+	return best;
+}
+
+
+unsigned uart_get_divider()
+{
+	return readl(USOC_UART_DIVD) & 0xFFFF;
+}
+
+
+void uart_set_divider(unsigned div)
+{
+	uart_tx_drain();
+	writel(div, USOC_UART_DIVD);
+}
+
+
+unsigned uart_get_baud()
+{
+	return readl(USOC_CTRL_SYSFREQ) / TX_BIT_CYCLES(uart_get_divider());
+}
+
+
+void uart_tx_drain()
+{
+	u32 t;
+
+#if CONFIG_UART_IRQ
+	struct uart_data *ud = &G()->uart;
+
+	if(ud->irq) {
+		unsigned sr = irq_save();
+		tx_flush(ud);
+		irq_restore(sr);
+	}
+#endif
+
+	while(!(readl(USOC_UART_CTRL) & USOC_UART_CTRL_TX_FE))
+		;
+
+	/* Wait for the last character to leave shift register */
+	t = rdtsc_lo() + 10 * TX_BIT_CYCLES(uart_get_divider());
+	while((long)rdtsc_lo() - (long)t < 0)
+		;
+}
@@ -33,11 +33,15 @@
 #include <uart.h>
 #include <str.h>
 #include <con.h>
+#include <cmd.h>
 #include <cmd_types.h>
 #include <xmodem.h>
 #include <elf_stream.h>
+#include <lz_stream.h>
 #include <soc_info.h>
 #include <global.h>
+#include <baud.h>
+#include <config.h>
 
 
 
@@ -63,33 +67,27 @@ static int inbyte(struct xm_recvr *xr, unsigned timeout)
 }
 
 
-/* Load arbitrary data using XModem protocol */
-static int cmd_xmodem(struct cmd_args *args)
+/* Switch to upload baud rate given by optional argument i.
+ * Returns previous divider, 0 if rate is not given or -1 on error.
+ */
+static int upload_baud(struct cmd_args *args, int i)
 {
-	unsigned addr;
-	int res;
-	struct xm_recvr xmr;
+	unsigned baud;
 
-	if(args->n < 2) {
-		cprint_str("Insufficient arguments.\n");
-		return -1;
-	}
+	if(args->n <= i)
+		return 0;
 
-	/* Parse address */
-	if(str2u(args->args[1], &addr) < 0) {
-		cprint_str("Invalid argument: ");
-		cprint_str(args->args[1]);
-		cprint_str("\n");
+	/* Parse baud rate */
+	if(cmd_arg2u(args->args[i], &baud) < 0)
 		return -1;
-	}
 
-	/* Prepare XModem */
-	xm_recvr_init(&xmr, outbyte, inbyte);
+	return baud_negotiate(baud);
+}
 
-	cprint_str("XModem: [0x"); cprint_hex32(addr); cprint_str("] -> ");
 
-	/* Start receiver */
-	res = xm_recvr_start_rx(&xmr, (void*)addr);
+/* Print receiver status */
+static void print_xm_result(int res)
+{
 	switch(res) {
 		case XM_ERR_EOT:
 			cprint_str("\nDone.\n");
@@ -103,12 +101,91 @@ static int cmd_xmodem(struct cmd_args *args)
 		case XM_ERR_RETR:
 			cprint_str("\nMaximum retries reached.\n");
 			break;
+		case XM_ERR_DATA:
+			cprint_str("\nData error.\n");
+			break;
+		case XM_ERR_TMO:
+			cprint_str("\nReceive timeout.\n");
+			break;
 		default: ;
 	}
+}
+
+
+/* Load arbitrary data using XModem protocol */
+static int cmd_xmodem(struct cmd_args *args)
+{
+	unsigned addr;
+	int res, div;
+	struct xm_recvr xmr;
+
+	if(args->n < 2) {
+		cprint_str("Insufficient arguments.\n");
+		return -1;
+	}
+
+	/* Parse address */
+	if(cmd_arg2u(args->args[1], &addr) < 0)
+		return -1;
+
+	/* Prepare XModem */
+	xm_recvr_init(&xmr, outbyte, inbyte);
+
+	/* Switch baud rate */
+	if((div = upload_baud(args, 2)) < 0)
+		return -1;
+
+	cprint_str("XModem: [0x"); cprint_hex32(addr); cprint_str("] -> ");
+
+	/* Start receiver */
+	res = xm_recvr_start_rx(&xmr, (void*)addr);
+	if(div)
+		baud_restore(div);
+	print_xm_result(res);
+
+	return 0;
+}
+COMMAND(x0xmod, "xmodem", "xmodem <addr> [baud]", "load data over XModem protocol", cmd_xmodem);
+
+
+/* Load arbitrary data using YModem-G protocol */
+static int cmd_ymodem(struct cmd_args *args)
+{
+	unsigned addr;
+	int res, div;
+	struct xm_recvr xmr;
+
+	if(args->n < 2) {
+		cprint_str("Insufficient arguments.\n");
+		return -1;
+	}
+
+	/* Parse address */
+	if(cmd_arg2u(args->args[1], &addr) < 0)
+		return -1;
+
+	/* Prepare receiver */
+	xm_recvr_init(&xmr, outbyte, inbyte);
+
+	/* Switch baud rate */
+	if((div = upload_baud(args, 2)) < 0)
+		return -1;
+
+	cprint_str("YModem-G: [0x"); cprint_hex32(addr); cprint_str("] -> ");
+
+	/* Start receiver */
+	res = xm_recvr_start_rx_g(&xmr, (void*)addr);
+	if(div)
+		baud_restore(div);
+	print_xm_result(res);
+	if(res == XM_ERR_EOT) {
+		cprint_str("Received "); cprint_uint(xm_recvr_getrxsize(&xmr));
+			cprint_str(" bytes.\n");
+	}
 
 	return 0;
 }
-COMMAND(x0xmod, "xmodem", "xmodem <addr>", "load data over XModem protocol", cmd_xmodem);
+COMMAND(x1ymod, "ymodem", "ymodem <addr> [baud]", "load data over YModem-G protocol", cmd_ymodem);
 
 
 /* Called from ELF stream to set new destination buffer address */
@@ -127,37 +204,19 @@ int xmodem_cb(struct xm_recvr *xmr, void *buf, size_t size)
 }
 
 
-/* Load MIPS-I ELF using XModem protocol */
-static int cmd_xelf(struct cmd_args *args)
+/* Print ELF loading status */
+static void print_elf_result(int res, struct elf_stream *es)
 {
-	struct xm_recvr xmr;
-	struct elf_stream es;
-	int res;
-
-	/* Prepare XModem */
-	xm_recvr_init(&xmr, outbyte, inbyte);
-	xm_recvr_setucb(&xmr, xmodem_cb);
-	xm_recvr_setudata(&xmr, &es);
-
-	/* Prepare ELF loader */
-	elf_stream_init(&es, set_buf_cb, &xmr);
-
-	cprint_str("XModem: [ELF] -> ");
-
-	/* Start receiver */
-	res = xm_recvr_start_rx(&xmr, (void*)soc_ram_base());
 	switch(res) {
 		case XM_ERR_CAN:
-			cprint_str("\nTransmission canceled.\n");
-			break;
 		case XM_ERR_OOSEQ:
-			cprint_str("\nSequence error.\n");
-			break;
 		case XM_ERR_RETR:
-			cprint_str("\nMaximum retries reached.\n");
+		case XM_ERR_DATA:
+		case XM_ERR_TMO:
+			print_xm_result(res);
 			break;
 		case ELFS_LOADED:
-			G()->elf_entry = es.entry;	/* Set ELF entry point */
+			G()->elf_entry = es->entry;	/* Set ELF entry point */
 			cprint_str("\nELF loaded.\n");
 			break;
 		case ELFS_INV_FILE_FMT:
@@ -181,11 +240,224 @@ static int cmd_xelf(struct cmd_args *args)
 		case ELFS_INV_LAYOUT:
 			cprint_str("\nInvalid ELF object layout.\n");
 			break;
+#if CONFIG_ELF_LZ
+		case LZS_ERR_FMT:
+			cprint_str("\nInvalid compressed stream.\n");
+			break;
+		case LZS_ERR_WIN:
+			cprint_str("\nCompression window is too large.\n");
+			break;
+#endif
 		default:
 			cprint_str("\nELF not loaded.\n");
 			break;
 	}
+}
+
+
+/* Load MIPS-I ELF using XModem protocol */
+static int cmd_xelf(struct cmd_args *args)
+{
+	struct xm_recvr xmr;
+	struct elf_stream es;
+	char scratch[1024];	/* Receive buffer for data without destination */
+	int res, div;
+
+	/* Prepare XModem */
+	xm_recvr_init(&xmr, outbyte, inbyte);
+	xm_recvr_setucb(&xmr, xmodem_cb);
+	xm_recvr_setudata(&xmr, &es);
+
+	/* Prepare ELF loader */
+	elf_stream_init(&es, set_buf_cb, &xmr, scratch, sizeof(scratch));
+
+	/* Switch baud rate */
+	if((div = upload_baud(args, 1)) < 0)
+		return -1;
+
+	cprint_str("XModem: [ELF] -> ");
+
+	/* Start receiver */
+	res = xm_recvr_start_rx(&xmr, scratch);
+	if(div)
+		baud_restore(div);
+	print_elf_result(res, &es);
+
+	return 0;
+}
+COMMAND(x0xelf, "xelf", "xelf [baud]", "load ELF binary over XModem protocol", cmd_xelf);
+
+
+/* Load MIPS-I ELF using YModem-G protocol */
+static int cmd_yelf(struct cmd_args *args)
+{
+	struct xm_recvr xmr;
+	struct elf_stream es;
+	char scratch[1024];	/* Receive buffer for data without destination */
+	int res, div;
+
+	/* Prepare receiver */
+	xm_recvr_init(&xmr, outbyte, inbyte);
+	xm_recvr_setucb(&xmr, xmodem_cb);
+	xm_recvr_setudata(&xmr, &es);
+
+	/* Prepare ELF loader */
+	elf_stream_init(&es, set_buf_cb, &xmr, scratch, sizeof(scratch));
+
+	/* Switch baud rate */
+	if((div = upload_baud(args, 1)) < 0)
+		return -1;
+
+	cprint_str("YModem-G: [ELF] -> ");
+
+	/* Start receiver */
+	res = xm_recvr_start_rx_g(&xmr, scratch);
+	if(div)
+		baud_restore(div);
+	print_elf_result(res, &es);
+
+	return 0;
+}
+COMMAND(x1yelf, "yelf", "yelf [baud]", "load ELF binary over YModem-G protocol", cmd_yelf);
+
+
+#if CONFIG_ELF_LZ
+/* Compressed ELF loader state */
+struct lz_load {
+	struct lz_stream lz;
+	struct elf_stream es;
+	char win[CONFIG_LZ_WINDOW_SZ];	/* Decoder window */
+	char rx_buf[1024];		/* Receive buffer for compressed blocks */
+};
+
+
+/* Called from decoder for each decoded portion */
+static int lz_out_cb(void *udata, void *buf, size_t size)
+{
+	struct elf_stream *es = (struct elf_stream*)udata;
+	return elf_stream_parse(es, buf, size);
+}
+
+
+/* Called from XModem for each received compressed block */
+static int xmodem_lz_cb(struct xm_recvr *xmr, void *buf, size_t size)
+{
+	struct lz_load *ld = (struct lz_load*)xm_recvr_getudata(xmr);
+
+	/* Next block goes to the same buffer */
+	xm_recvr_setbuf(xmr, ld->rx_buf);
+
+	return lz_stream_feed(&ld->lz, buf, size);
+}
+
+
+/* Load compressed ELF using XModem or YModem-G protocol */
+static int load_elfz(struct cmd_args *args, int ymodem)
+{
+	struct xm_recvr xmr;
+	struct lz_load ld;
+	int res, div;
+
+	/* Prepare receiver */
+	xm_recvr_init(&xmr, outbyte, inbyte);
+	xm_recvr_setucb(&xmr, xmodem_lz_cb);
+	xm_recvr_setudata(&xmr, &ld);
+
+	/* Prepare decoder and ELF loader */
+	lz_stream_init(&ld.lz, ld.win, sizeof(ld.win), lz_out_cb, &ld.es);
+	elf_stream_init(&ld.es, NULL, NULL, NULL, 0);	/* Data is copied out of decoder window */
+
+	/* Switch baud rate */
+	if((div = upload_baud(args, 1)) < 0)
+		return -1;
+
+	cprint_str(ymodem ? "YModem-G: [ELF/LZ] -> " : "XModem: [ELF/LZ] -> ");
+
+	/* Start receiver */
+	if(ymodem)
+		res = xm_recvr_start_rx_g(&xmr, ld.rx_buf);
+	else
+		res = xm_recvr_start_rx(&xmr, ld.rx_buf);
+	if(div)
+		baud_restore(div);
+	print_elf_result(res, &ld.es);
+
+	return 0;
+}
+
+
+/* Load compressed MIPS-I ELF using XModem protocol */
+static int cmd_xelfz(struct cmd_args *args)
+{
+	return load_elfz(args, 0);
+}
+COMMAND(x0xelz, "xelfz", "xelfz [baud]", "load compressed ELF over XModem protocol", cmd_xelfz);
+
+
+/* Load compressed MIPS-I ELF using YModem-G protocol */
+static int cmd_yelfz(struct cmd_args *args)
+{
+	return load_elfz(args, 1);
+}
+COMMAND(x1yelz, "yelfz", "yelfz [baud]", "load compressed ELF over YModem-G protocol", cmd_yelfz);
+#endif
+
+
+#if CONFIG_XSEND
+/* Send byte (sender) */
+static void xs_outbyte(struct xm_sender *xs, char b)
+{
+	uart_put_char(b);
+}
+
+
+/* Receive byte (sender) */
+static int xs_inbyte(struct xm_sender *xs, unsigned timeout)
+{
+	return inbyte(NULL, timeout);
+}
+
+
+/* Send memory contents using XModem protocol */
+static int cmd_xsend(struct cmd_args *args)
+{
+	unsigned addr, len;
+	int res, div;
+	struct xm_sender xms;
+
+	if(args->n < 3) {
+		cprint_str("Insufficient arguments.\n");
+		return -1;
+	}
+
+	/* Parse address */
+	if(cmd_arg2u(args->args[1], &addr) < 0)
+		return -1;
+
+	/* Parse length */
+	if(cmd_arg2u(args->args[2], &len) < 0)
+		return -1;
+
+	/* Prepare sender */
+	xm_sender_init(&xms, xs_outbyte, xs_inbyte);
+
+	/* Switch baud rate */
+	if((div = upload_baud(args, 3)) < 0)
+		return -1;
+
+	cprint_str("XModem: [0x"); cprint_hex32(addr); cprint_str("] <- ");
+
+	/* Start sender */
+	res = xm_sender_start_tx(&xms, (const void*)addr, len);
+	if(div)
+		baud_restore(div);
+	print_xm_result(res);
+	if(res == XM_ERR_EOT) {
+		cprint_str("Sent "); cprint_uint(xm_sender_gettxsize(&xms));
+			cprint_str(" bytes.\n");
+	}
 
 	return 0;
 }
-COMMAND(x0xelf, "xelf", "xelf", "load ELF binary over XModem protocol", cmd_xelf);
+COMMAND(x2xsnd, "xsend", "xsend <addr> <len> [baud]", "send memory contents over XModem protocol", cmd_xsend);
+#endif
@@ -27,6 +27,8 @@
  * XModem protocol implementation
  */
 
+#include <config.h>
+#include <str.h>
 #include <crc16_ccitt.h>
 #include <xmodem.h>
 
@@ -39,6 +41,12 @@
 #define NAK	0x15	/* Not Acknowledge */
 #define CAN	0x18	/* Cancel */
 #define CRQ	0x43	/* Transmission Request (CRC) */
+#define CRG	0x47	/* Transmission Request (YModem-G streaming) */
+
+#define CPMEOF	0x1A	/* Padding of the last block */
+
+/* YModem header block size. Senders use 1K block for long names. */
+#define YM_HDR_SZ	1024
 
 
 /* XModem protocol sync */
@@ -139,15 +147,16 @@ static int xm_recv_block(struct xm_recvr *xmr, size_t blk_sz)
 {
 	size_t i;
 	int r;
-	crc16_t crc16;
+	crc16_t crc16, rx_crc16 = 0;
 	char *buf = xmr->buf;
 
-	/* Receive data */
+	/* Receive data. CRC is updated while waiting for the next byte. */
 	for(i = 0; i < blk_sz; ++i) {
 		r = xmr->inb(xmr, 10);
 		if(r < 0)
 			return NAK;
 		*buf = r;
+		rx_crc16 = crc16_ccitt_update(buf, 1, rx_crc16);
 		++buf;
 	}
 
@@ -166,7 +175,7 @@ static int xm_recv_block(struct xm_recvr *xmr, size_t blk_sz)
 	crc16 |= (crc16_t)r;
 
 	/* Verify CRC */
-	if(crc16_ccitt(xmr->buf, blk_sz) == crc16) {
+	if(rx_crc16 == crc16) {
 		xmr->buf = buf;
 		return ACK;
 	}
@@ -208,23 +217,31 @@ int xm_recvr_start_rx(struct xm_recvr *xmr, void *buf)
 
 		r = xm_recv_block(xmr, blk_sz);
 
-		if(r == ACK && xmr->callback) {		/* User callback */
-			int cbr = xmr->callback(xmr, old_buf, blk_sz);
-			if(cbr) {
-				xmr->outb(xmr, CAN);
-				xmr->outb(xmr, CAN);
-				r = cbr;
-				break;
+		if(r == ACK) {
+			/* Acknowledge first so the sender does not wait for the
+			 * callback. Beginning of the next block is held by UART
+			 * receive FIFO meanwhile.
+			 */
+			xmr->outb(xmr, ACK);
+
+			if(xmr->callback) {		/* User callback */
+				int cbr = xmr->callback(xmr, old_buf, blk_sz);
+				if(cbr) {
+					xmr->outb(xmr, CAN);
+					xmr->outb(xmr, CAN);
+					r = cbr;
+					break;
+				}
 			}
-		}
 
-		/* Update state if acknowledged */
-		if(r == ACK) {
+			/* Update state */
 			xmr->blk_no = xmr->cblk_no;
 			xmr->rx_size += blk_sz;
+
+			r = 0;	/* ACK is already sent */
 		}
 
-		/* Send ACK or NAK and synchronize */
+		/* Send NAK if needed and synchronize */
 		r = xm_sync(xmr, r, 10, 10);
 	}
 
@@ -234,3 +251,300 @@ int xm_recvr_start_rx(struct xm_recvr *xmr, void *buf)
 
 	return r;
 }
+
+
+/* Receive YModem-G block. Returns block size, EOT or error code. */
+static int ymg_recv_block(struct xm_recvr *xmr, char blk_no, size_t max_sz, unsigned timeout_sec)
+{
+	int r;
+	char rc, blk, nblk;
+	size_t blk_sz;
+
+	rc = r = xmr->inb(xmr, timeout_sec);
+	if(r < 0)
+		return XM_ERR_TMO;
+	else if(rc == EOT)
+		return EOT;
+	else if(rc == CAN)
+		return XM_ERR_CAN;
+	else if(rc != SOH && rc != SOX)
+		return XM_ERR_DATA;
+
+	blk_sz = (rc == SOX ? 1024 : 128);
+	if(blk_sz > max_sz)
+		return XM_ERR_DATA;
+
+	/* Receive sequence number and its ones' complement */
+	blk = r = xmr->inb(xmr, 10);
+	if(r < 0)
+		return XM_ERR_TMO;
+
+	nblk = r = xmr->inb(xmr, 10);
+	if(r < 0)
+		return XM_ERR_TMO;
+
+	if(blk != ~nblk)
+		return XM_ERR_DATA;
+	else if(blk != blk_no)
+		return XM_ERR_OOSEQ;
+
+	/* There are no retransmissions in streaming mode */
+	if(xm_recv_block(xmr, blk_sz) != ACK)
+		return XM_ERR_DATA;
+
+	return blk_sz;
+}
+
+
+/* Receive YModem header block (block 0) into hdr */
+static int ymg_recv_hdr(struct xm_recvr *xmr, char *hdr, unsigned timeout_sec)
+{
+	char *buf = xmr->buf;
+	int r;
+
+	xmr->buf = hdr;
+	r = ymg_recv_block(xmr, 0, YM_HDR_SZ, timeout_sec);
+	xmr->buf = buf;
+
+	if(r == EOT)
+		r = XM_ERR_OOSEQ;
+
+	return r;
+}
+
+
+/* Get file size from YModem header: name, NUL, decimal size, ... */
+static size_t ymg_hdr_fsize(const char *hdr)
+{
+	size_t i = 0, sz = 0;
+
+	while(i < YM_HDR_SZ && hdr[i])
+		++i;
+
+	for(++i; i < YM_HDR_SZ && hdr[i] >= '0' && hdr[i] <= '9'; ++i)
+		sz = sz * 10 + (hdr[i] - '0');
+
+	return sz;
+}
+
+
+/* Start YModem-G receive */
+int xm_recvr_start_rx_g(struct xm_recvr *xmr, void *buf)
+{
+	char hdr[YM_HDR_SZ];
+	unsigned retries = 10;
+	char blk = 1;
+	int r;
+
+	xmr->buf = (char*)buf;
+	xmr->blk_no = 0;
+	xmr->cblk_no = 0;
+	xmr->rx_size = 0;
+	xmr->fsize = 0;
+
+
+	/* Request file header */
+	do {
+		xmr->outb(xmr, CRG);
+		r = ymg_recv_hdr(xmr, hdr, 3);
+	} while(r == XM_ERR_TMO && --retries);
+
+	if(r == XM_ERR_TMO) {
+		r = XM_ERR_RETR;
+		goto cancel;
+	} else if(r < 0)
+		goto cancel;
+
+	/* Empty batch */
+	if(!hdr[0]) {
+		xmr->outb(xmr, ACK);
+		return XM_ERR_EOT;
+	}
+
+	xmr->fsize = ymg_hdr_fsize(hdr);
+
+
+	/* Start streaming. Data blocks are not acknowledged. */
+	xmr->outb(xmr, CRG);
+
+	while(1) {
+		char *old_buf = xmr->buf;
+		/* Block which can cross end of file is received into header
+		 * buffer, so its padding does not overwrite memory past the file.
+		 */
+		int last = (xmr->fsize && xmr->fsize - xmr->rx_size < 1024);
+		size_t n;
+
+		if(last)
+			xmr->buf = hdr;
+
+		r = ymg_recv_block(xmr, blk, 1024, 10);
+		if(last)
+			xmr->buf = old_buf;
+
+		if(r == EOT)
+			break;
+		else if(r < 0)
+			goto cancel;
+
+		/* Strip padding of the last block */
+		n = r;
+		if(xmr->fsize && xmr->rx_size + n > xmr->fsize)
+			n = xmr->fsize - xmr->rx_size;
+
+		if(last) {
+			memcpy(old_buf, hdr, n);
+			xmr->buf = old_buf + n;
+		}
+
+		xmr->blk_no = blk++;
+		xmr->rx_size += n;
+
+		if(n && xmr->callback) {	/* User callback */
+			int cbr = xmr->callback(xmr, old_buf, n);
+			if(cbr) {
+				r = cbr;
+				goto cancel;
+			}
+		}
+	}
+
+	xmr->outb(xmr, ACK);
+
+
+	/* Finish batch. Only single file transfers are supported. */
+	xmr->outb(xmr, CRG);
+	r = ymg_recv_hdr(xmr, hdr, 10);
+	if(r > 0 && !hdr[0]) {
+		xmr->outb(xmr, ACK);
+		return XM_ERR_EOT;
+	} else if(r > 0)
+		r = XM_ERR_DATA;
+
+
+cancel:
+	if(r != XM_ERR_CAN) {
+		xmr->outb(xmr, CAN);
+		xmr->outb(xmr, CAN);
+	}
+
+	/* Flush remaining data */
+	while(xmr->inb(xmr, 1) >= 0)
+		;
+
+	return r;
+}
+
+
+#if CONFIG_XSEND
+/* Wait for receiver response to a block or EOT.
+ * Returns ACK, NAK, CAN (two CANs received) or XM_ERR_TMO.
+ */
+static int xs_wait_resp(struct xm_sender *xms, unsigned timeout_sec)
+{
+	int can = 0;
+	int r;
+
+	while((r = xms->inb(xms, timeout_sec)) >= 0) {
+		if(r == ACK || r == NAK)
+			return r;
+		else if(r == CAN && can)
+			return CAN;
+
+		can = (r == CAN);	/* Other characters are line noise */
+	}
+
+	return XM_ERR_TMO;
+}
+
+
+/* Send data block */
+static void xs_send_block(struct xm_sender *xms, char blk_no, const char *data, size_t n,
+	size_t blk_sz)
+{
+	const char pad = CPMEOF;
+	crc16_t crc = 0;
+	size_t i;
+
+	xms->outb(xms, blk_sz == 1024 ? SOX : SOH);
+	xms->outb(xms, blk_no);
+	xms->outb(xms, ~blk_no);
+
+	/* CRC is updated while the byte is being transmitted */
+	for(i = 0; i < n; ++i) {
+		xms->outb(xms, data[i]);
+		crc = crc16_ccitt_update(&data[i], 1, crc);
+	}
+
+	for(; i < blk_sz; ++i) {
+		xms->outb(xms, pad);
+		crc = crc16_ccitt_update(&pad, 1, crc);
+	}
+
+	xms->outb(xms, crc >> 8);
+	xms->outb(xms, crc & 0xFF);
+}
+
+
+/* Start XModem transmit */
+int xm_sender_start_tx(struct xm_sender *xms, const void *buf, size_t size)
+{
+	const char *data = (const char*)buf;
+	unsigned retries = 60;
+	char blk = 1;
+	int r;
+
+	xms->tx_size = 0;
+
+
+	/* Wait for CRC mode request, receiver may start late */
+	while((r = xms->inb(xms, 1)) != CRQ) {
+		if(r == CAN)
+			return XM_ERR_CAN;
+		else if(r < 0 && !--retries)
+			return XM_ERR_RETR;
+	}
+
+
+	/* Send blocks */
+	while(xms->tx_size < size) {
+		size_t rem = size - xms->tx_size;
+		size_t blk_sz = (rem > 128 ? 1024 : 128);
+		size_t n = (rem < blk_sz ? rem : blk_sz);
+
+		retries = 10;
+		do {
+			xs_send_block(xms, blk, &data[xms->tx_size], n, blk_sz);
+			r = xs_wait_resp(xms, 10);
+		} while((r == NAK || r == XM_ERR_TMO) && --retries);
+
+		if(r == CAN)
+			return XM_ERR_CAN;
+		else if(r != ACK)
+			goto cancel;
+
+		xms->tx_size += n;
+		++blk;
+	}
+
+
+	/* End of transmission */
+	retries = 10;
+	do {
+		xms->outb(xms, EOT);
+		r = xs_wait_resp(xms, 10);
+	} while(r != ACK && r != CAN && --retries);
+
+	if(r == ACK)
+		return XM_ERR_EOT;
+	else if(r == CAN)
+		return XM_ERR_CAN;
+
+
+cancel:
+	xms->outb(xms, CAN);
+	xms->outb(xms, CAN);
+
+	return XM_ERR_RETR;
+}
+#endif
@@ -44,7 +44,15 @@ module soc_control(
 	o_SData,
 	o_SResp,
 	/* Peripherals control */
-	o_LED
+	o_LED,
+	/* Performance events */
+	i_perf_ifetch,
+	i_perf_istall,
+	i_perf_dstall,
+	i_perf_bus,
+	i_perf_uart_tx,
+	i_perf_uart_rx,
+	i_perf_intr
 );
 `include "soc_info.vh"
 
@@ -55,6 +63,23 @@ localparam [`ADDR_WIDTH-1:0] RAMSIZE_REG	= 32'h008;	/* RAM size (R/O) */
 localparam [`ADDR_WIDTH-1:0] ROMSIZE_REG	= 32'h00C;	/* ROM size (R/O) */
 localparam [`ADDR_WIDTH-1:0] SYSFREQ_REG	= 32'h010;	/* System frequency (R/O) */
 localparam [`ADDR_WIDTH-1:0] LED_REG		= 32'h100;	/* LEDs register (R/W) */
+localparam [`ADDR_WIDTH-1:0] PERF_CTRL_REG	= 32'h200;	/* Perf. counters control (R/W) */
+localparam [`ADDR_WIDTH-1:0] PERF_CNT_BASE	= 32'h300;	/* Perf. counters (R/O) */
+
+/* Performance counters */
+localparam PERF_CYCLES		= 0;	/* Clock cycles */
+localparam PERF_IFETCH		= 1;	/* Instruction fetches completed */
+localparam PERF_ISTALL		= 2;	/* I-Bus stall cycles */
+localparam PERF_DSTALL		= 3;	/* D-Bus stall cycles */
+localparam PERF_BUS		= 4;	/* Slave port transactions (5 counters) */
+localparam PERF_UART_TX		= 9;	/* UART bytes transmitted */
+localparam PERF_UART_RX		= 10;	/* UART bytes received */
+localparam PERF_INTR		= 11;	/* Interrupt requests */
+localparam PERF_NCNT		= 12;	/* Number of counters */
+
+/* Performance counters control bits */
+localparam PERF_CTRL_FREEZE	= 0;	/* Stop counting */
+localparam PERF_CTRL_CLEAR	= 1;	/* Clear all counters (W/O) */
 
 
 /* Inputs and outputs */
@@ -68,11 +93,34 @@ output wire			o_SCmdAccept;
 output reg [`DATA_WIDTH-1:0]	o_SData;
 output reg [1:0]		o_SResp;
 output reg [7:0]		o_LED;
+input wire			i_perf_ifetch;
+input wire			i_perf_istall;
+input wire			i_perf_dstall;
+input wire [4:0]		i_perf_bus;
+input wire			i_perf_uart_tx;
+input wire			i_perf_uart_rx;
+input wire			i_perf_intr;
 
 
 assign o_SCmdAccept = 1'b1;	/* Always ready to accept command */
 
 
+/*
+ * Performance counters. Counter N occupies two words at PERF_CNT_BASE+8*N:
+ * low word first. Reading low word latches high word, so the pair is read
+ * consistently without freezing counters.
+ */
+reg [63:0]		perf_cnt[0:PERF_NCNT-1];
+reg			perf_freeze;
+reg [31:0]		perf_hi;	/* Latched high word */
+reg			perf_intr_prev;
+integer			perf_i;
+
+wire perf_sel = (i_MAddr[`ADDR_WIDTH-1:7] == PERF_CNT_BASE[`ADDR_WIDTH-1:7]) &&
+	(i_MAddr[6:3] < PERF_NCNT);
+wire [3:0] perf_idx = i_MAddr[6:3];
+
+
 
 /* Bus logic */
 always @(*)
@@ -90,7 +138,13 @@ begin
 		ROMSIZE_REG: o_SData = `SOC_INFO_ROM_SIZE;
 		SYSFREQ_REG: o_SData = `SOC_INFO_SYS_FREQ;
 		LED_REG: o_SData = { {(`DATA_WIDTH-8){1'b0}}, o_LED };
-		default: o_SData = 32'hDEADDEAD;
+		PERF_CTRL_REG: o_SData = { {(`DATA_WIDTH-1){1'b0}}, perf_freeze };
+		default: begin
+			if(perf_sel)
+				o_SData = i_MAddr[2] ? perf_hi : perf_cnt[perf_idx][31:0];
+			else
+				o_SData = 32'hDEADDEAD;
+		end
 		endcase
 		o_SResp = `OCP_RESP_DVA;
 	end
@@ -119,4 +173,49 @@ begin
 end
 
 
+/* Performance counters update */
+always @(posedge clk or negedge nrst)
+begin
+	if(!nrst)
+	begin
+		for(perf_i = 0; perf_i < PERF_NCNT; perf_i = perf_i + 1)
+			perf_cnt[perf_i] <= 64'b0;
+		perf_freeze <= 1'b0;
+		perf_hi <= 32'b0;
+		perf_intr_prev <= 1'b0;
+	end
+	else
+	begin
+		perf_intr_prev <= i_perf_intr;
+
+		if(i_MCmd == `OCP_CMD_READ && perf_sel && !i_MAddr[2])
+			perf_hi <= perf_cnt[perf_idx][63:32];
+
+		if(i_MCmd == `OCP_CMD_WRITE && i_MAddr == PERF_CTRL_REG)
+			perf_freeze <= i_MData[PERF_CTRL_FREEZE];
+
+		if(i_MCmd == `OCP_CMD_WRITE && i_MAddr == PERF_CTRL_REG &&
+			i_MData[PERF_CTRL_CLEAR])
+		begin
+			for(perf_i = 0; perf_i < PERF_NCNT; perf_i = perf_i + 1)
+				perf_cnt[perf_i] <= 64'b0;
+		end
+		else if(!perf_freeze)
+		begin
+			perf_cnt[PERF_CYCLES] <= perf_cnt[PERF_CYCLES] + 64'b1;
+			perf_cnt[PERF_IFETCH] <= perf_cnt[PERF_IFETCH] + {63'b0, i_perf_ifetch};
+			perf_cnt[PERF_ISTALL] <= perf_cnt[PERF_ISTALL] + {63'b0, i_perf_istall};
+			perf_cnt[PERF_DSTALL] <= perf_cnt[PERF_DSTALL] + {63'b0, i_perf_dstall};
+			for(perf_i = 0; perf_i < 5; perf_i = perf_i + 1)
+				perf_cnt[PERF_BUS + perf_i] <= perf_cnt[PERF_BUS + perf_i] +
+					{63'b0, i_perf_bus[perf_i]};
+			perf_cnt[PERF_UART_TX] <= perf_cnt[PERF_UART_TX] + {63'b0, i_perf_uart_tx};
+			perf_cnt[PERF_UART_RX] <= perf_cnt[PERF_UART_RX] + {63'b0, i_perf_uart_rx};
+			perf_cnt[PERF_INTR] <= perf_cnt[PERF_INTR] +
+				{63'b0, i_perf_intr & ~perf_intr_prev};
+		end
+	end
+end
+
+
 endmodule /* soc_control */
@@ -110,6 +110,22 @@ wire timer_intr;
 /* UART interrupt */
 wire uart_intr;
 
+/* UART byte strobes */
+wire uart_tx_byte;
+wire uart_rx_byte;
+
+/* Performance events */
+wire perf_ifetch = C_IRdC & C_IRdy;
+wire perf_istall = C_IRdC & ~C_IRdy;
+wire perf_dstall = C_DCmd & ~C_DRdy;
+wire [4:0] perf_bus = {
+	P_SResp[4] != `OCP_RESP_NULL,
+	P_SResp[3] != `OCP_RESP_NULL,
+	P_SResp[2] != `OCP_RESP_NULL,
+	P_SResp[1] != `OCP_RESP_NULL,
+	P_SResp[0] != `OCP_RESP_NULL
+};
+
 
 /* IBus-to-OCP */
 `ifdef CONFIG_FABRIC2
@@ -200,6 +216,8 @@ upuart_top upuart(
 	.clk(clk),
 	.nrst(nrst),
 	.o_intr(uart_intr),
+	.o_tx_byte(uart_tx_byte),
+	.o_rx_byte(uart_rx_byte),
 	.rxd(RxD),
 	.txd(TxD),
 	.cts(CTS),
@@ -225,7 +243,14 @@ soc_control soc_ctl(
 	.o_SCmdAccept(P_SCmdAccept[2]),
 	.o_SData(P_SData[2]),
 	.o_SResp(P_SResp[2]),
-	.o_LED(LED)
+	.o_LED(LED),
+	.i_perf_ifetch(perf_ifetch),
+	.i_perf_istall(perf_istall),
+	.i_perf_dstall(perf_dstall),
+	.i_perf_bus(perf_bus),
+	.i_perf_uart_tx(uart_tx_byte),
+	.i_perf_uart_rx(uart_rx_byte),
+	.i_perf_intr(intr)
 );
 
 
@@ -56,6 +56,26 @@
 #define USOC_CTRL_ROMSIZE	(USOC_CTRL_IOBASE + 0x00C)	/* ROM size (R/O) */
 #define USOC_CTRL_SYSFREQ	(USOC_CTRL_IOBASE + 0x010)	/* System frequency (R/O) */
 #define USOC_CTRL_LED		(USOC_CTRL_IOBASE + 0x100)	/* LEDs control register (R/W) */
+#define USOC_CTRL_PERF_CTRL	(USOC_CTRL_IOBASE + 0x200)	/* Perf. counters control (R/W) */
+#define USOC_CTRL_PERF_LO(n)	(USOC_CTRL_IOBASE + 0x300 + 8*(n))	/* Counter low word (R/O) */
+#define USOC_CTRL_PERF_HI(n)	(USOC_CTRL_IOBASE + 0x304 + 8*(n))	/* Counter high word (R/O) */
+/***/
+#define USOC_CTRL_PERF_CTRL_FREEZE	(1<<0)			/* Stop counting */
+#define USOC_CTRL_PERF_CTRL_CLEAR	(1<<1)			/* Clear counters (W/O) */
+/* Performance counters. Reading low word latches high word. */
+#define USOC_PERF_CYCLES	0				/* Clock cycles */
+#define USOC_PERF_IFETCH	1				/* Instruction fetches */
+#define USOC_PERF_ISTALL	2				/* I-Bus stall cycles */
+#define USOC_PERF_DSTALL	3				/* D-Bus stall cycles */
+#define USOC_PERF_BUS_MEM	4				/* Memory transactions */
+#define USOC_PERF_BUS_UART	5				/* UART transactions */
+#define USOC_PERF_BUS_CTRL	6				/* Control device transactions */
+#define USOC_PERF_BUS_INTCTL	7				/* Interrupt controller transactions */
+#define USOC_PERF_BUS_ITIMER	8				/* Interval timer transactions */
+#define USOC_PERF_UART_TX	9				/* UART bytes transmitted */
+#define USOC_PERF_UART_RX	10				/* UART bytes received */
+#define USOC_PERF_INTR		11				/* Interrupt requests */
+#define USOC_PERF_COUNT		12				/* Number of counters */
 
 
 /* Interrupt controller */
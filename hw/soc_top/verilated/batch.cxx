@@ -0,0 +1,460 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Batch regression runner.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include "batch.h"
+#include "sim_threads.h"
+
+
+// Test description and results
+struct batch_test {
+	std::string name;
+	std::string rom;		// ROM image
+	std::string ram;		// RAM image
+	std::string expect;		// Expected UART output
+	std::string input;		// UART input
+	vluint64_t max_cycles;		// Cycle budget
+
+	bool pass;
+	std::string reason;		// Failure reason
+	vluint64_t cycles;		// Simulated cycles
+	double wall;			// Wall time
+};
+
+
+// Running test
+struct batch_job {
+	size_t test;		// Test index
+	int fd;			// Result pipe
+	double start;		// Start time
+};
+
+
+// Resolve path relative to manifest directory
+static std::string resolve(const std::string &base, const std::string &path)
+{
+	if(path == "-")
+		return std::string();
+	if(path[0] == '/' || base.empty())
+		return path;
+	return base + "/" + path;
+}
+
+
+// Read manifest file
+static bool read_manifest(const char *file, std::vector<batch_test> &tests)
+{
+	std::ifstream in(file);
+	std::string base(file);
+	std::string line;
+	unsigned lineno = 0;
+
+	if(!in) {
+		std::cerr << "Batch: cannot open manifest " << file << std::endl;
+		return false;
+	}
+
+	std::string::size_type slash = base.rfind('/');
+	base = (slash == std::string::npos ? std::string() : base.substr(0, slash));
+
+	while(std::getline(in, line)) {
+		std::istringstream ls(line);
+		std::string rom, ram, expect, cycles, input;
+		batch_test t;
+
+		++lineno;
+		if(!(ls >> t.name) || t.name[0] == '#')
+			continue;
+
+		if(!(ls >> rom >> ram >> expect >> cycles)) {
+			std::cerr << file << ":" << lineno << ": malformed test entry"
+				<< std::endl;
+			return false;
+		}
+		ls >> input;
+
+		t.rom = resolve(base, rom);
+		t.ram = resolve(base, ram);
+		t.expect = resolve(base, expect);
+		t.input = (input.empty() ? input : resolve(base, input));
+		t.max_cycles = strtoull(cycles.c_str(), 0, 0);
+		t.pass = false;
+		t.cycles = 0;
+		t.wall = 0;
+		tests.push_back(t);
+	}
+
+	return true;
+}
+
+
+// Read whole file
+static bool read_file(const std::string &file, std::string &data)
+{
+	std::ifstream in(file.c_str(), std::ios::binary);
+	std::ostringstream ss;
+
+	if(!in)
+		return false;
+	ss << in.rdbuf();
+	data = ss.str();
+
+	return true;
+}
+
+
+// Returns true if file name has .elf extension
+static bool is_elf(const std::string &file)
+{
+	return file.size() > 4 && file.compare(file.size() - 4, 4, ".elf") == 0;
+}
+
+
+// Run test in child process and report results to the pipe
+static void run_child(const batch_test &t, const sim_config &base,
+	const std::string &out_dir, int fd)
+{
+	std::string log = out_dir + "/" + t.name + ".log";
+	std::string uart = "file:" + out_dir + "/" + t.name + ".uart";
+	sim_config cfg = base;
+	sim_result res;
+
+	if(!t.input.empty())
+		uart += "," + t.input;
+
+	// Model output goes to test log
+	if(!freopen(log.c_str(), "w", stdout))
+		_exit(1);
+	dup2(fileno(stdout), fileno(stderr));
+
+	cfg.rom_image = (t.rom.empty() || is_elf(t.rom) ? 0 : t.rom.c_str());
+	cfg.ram_image = (t.ram.empty() || is_elf(t.ram) ? 0 : t.ram.c_str());
+	cfg.elf_file = (is_elf(t.ram) ? t.ram.c_str() :
+		is_elf(t.rom) ? t.rom.c_str() : 0);
+	cfg.uart_spec = uart.c_str();
+	cfg.max_cycles = t.max_cycles;
+	cfg.do_trace = false;		// All tests would share one dump file
+	cfg.itrace_file = 0;
+	cfg.profile_elf = 0;
+	cfg.bus_json = 0;
+	cfg.pin_cpu = -1;
+
+	simulate(cfg, res);
+
+	std::cout.flush();
+	fflush(stdout);
+	if(write(fd, &res, sizeof(res)) != sizeof(res))
+		_exit(1);
+	_exit(0);
+}
+
+
+// Evaluate finished test
+static void evaluate(batch_test &t, const sim_result &res, bool have_res,
+	int wstatus, const std::string &out_dir)
+{
+	std::ostringstream why;
+
+	t.pass = false;
+	if(!have_res) {
+		if(WIFSIGNALED(wstatus))
+			why << "killed by signal " << WTERMSIG(wstatus);
+		else
+			why << "no result (exit code " << WEXITSTATUS(wstatus) << ")";
+		t.reason = why.str();
+		return;
+	}
+
+	t.cycles = res.cycles;
+
+	switch(res.status) {
+	case SIM_FINISHED:
+		break;
+	case SIM_BUDGET:
+		t.reason = "cycle budget exhausted";
+		return;
+	case SIM_WALL_LIMIT:
+		t.reason = "wall time limit exceeded";
+		return;
+	case SIM_STUCK:
+		t.reason = "CPU stuck";
+		return;
+	case SIM_INTERRUPTED:
+		t.reason = "interrupted";
+		return;
+	default:
+		t.reason = "simulation setup error";
+		return;
+	}
+
+	if(!t.expect.empty()) {
+		std::string expect, actual;
+		if(!read_file(t.expect, expect)) {
+			t.reason = "cannot read expected output " + t.expect;
+			return;
+		}
+		read_file(out_dir + "/" + t.name + ".uart", actual);
+		if(expect != actual) {
+			t.reason = "UART output mismatch";
+			return;
+		}
+	}
+
+	t.pass = true;
+}
+
+
+// Escape string for JSON
+static std::string json_str(const std::string &s)
+{
+	std::ostringstream os;
+
+	os << '"';
+	for(size_t i = 0; i < s.size(); ++i) {
+		unsigned char c = s[i];
+		if(c == '"' || c == '\\')
+			os << '\\' << c;
+		else if(c < 0x20)
+			os << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+				<< (unsigned)c << std::dec;
+		else
+			os << c;
+	}
+	os << '"';
+
+	return os.str();
+}
+
+
+// Escape string for XML
+static std::string xml_str(const std::string &s)
+{
+	std::string r;
+
+	for(size_t i = 0; i < s.size(); ++i) {
+		switch(s[i]) {
+		case '&': r += "&amp;"; break;
+		case '<': r += "&lt;"; break;
+		case '>': r += "&gt;"; break;
+		case '"': r += "&quot;"; break;
+		default: r += s[i]; break;
+		}
+	}
+
+	return r;
+}
+
+
+// Write JSON summary
+static bool write_json(const char *file, const std::vector<batch_test> &tests,
+	unsigned failed, double wall)
+{
+	std::ofstream os(file);
+
+	if(!os) {
+		std::cerr << "Batch: cannot create " << file << std::endl;
+		return false;
+	}
+
+	os << std::fixed << std::setprecision(3);
+	os << "{" << std::endl;
+	os << "  \"tests\": " << tests.size() << "," << std::endl;
+	os << "  \"failed\": " << failed << "," << std::endl;
+	os << "  \"wall\": " << wall << "," << std::endl;
+	os << "  \"results\": [" << std::endl;
+	for(size_t i = 0; i < tests.size(); ++i) {
+		const batch_test &t = tests[i];
+		os << "    { \"name\": " << json_str(t.name)
+			<< ", \"pass\": " << (t.pass ? "true" : "false")
+			<< ", \"reason\": " << json_str(t.reason)
+			<< ", \"cycles\": " << t.cycles
+			<< ", \"wall\": " << t.wall << " }"
+			<< (i + 1 < tests.size() ? "," : "") << std::endl;
+	}
+	os << "  ]" << std::endl;
+	os << "}" << std::endl;
+
+	return true;
+}
+
+
+// Write JUnit XML summary
+static bool write_junit(const char *file, const std::vector<batch_test> &tests,
+	unsigned failed, double wall)
+{
+	std::ofstream os(file);
+
+	if(!os) {
+		std::cerr << "Batch: cannot create " << file << std::endl;
+		return false;
+	}
+
+	os << std::fixed << std::setprecision(3);
+	os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl;
+	os << "<testsuite name=\"vl_ultisoc\" tests=\"" << tests.size()
+		<< "\" failures=\"" << failed << "\" time=\"" << wall << "\">"
+		<< std::endl;
+	for(size_t i = 0; i < tests.size(); ++i) {
+		const batch_test &t = tests[i];
+		os << "  <testcase classname=\"vl_ultisoc\" name=\""
+			<< xml_str(t.name) << "\" time=\"" << t.wall << "\">" << std::endl;
+		os << "    <properties><property name=\"cycles\" value=\""
+			<< t.cycles << "\"/></properties>" << std::endl;
+		if(!t.pass)
+			os << "    <failure message=\"" << xml_str(t.reason)
+				<< "\"/>" << std::endl;
+		os << "  </testcase>" << std::endl;
+	}
+	os << "</testsuite>" << std::endl;
+
+	return true;
+}
+
+
+int run_batch(const batch_config &bc, const sim_config &base)
+{
+	std::vector<batch_test> tests;
+	std::map<pid_t, batch_job> jobs;
+	std::string out_dir(bc.out_dir);
+	int max_jobs = bc.jobs;
+	size_t next = 0, done = 0;
+	unsigned failed = 0;
+
+	if(!read_manifest(bc.manifest, tests))
+		return -1;
+
+	if(mkdir(bc.out_dir, 0755) < 0 && errno != EEXIST) {
+		std::cerr << "Batch: cannot create " << bc.out_dir << ": "
+			<< strerror(errno) << std::endl;
+		return -1;
+	}
+
+	if(max_jobs <= 0)
+		max_jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(max_jobs <= 0)
+		max_jobs = 1;
+
+	std::cout << "Running " << tests.size() << " tests, " << max_jobs
+		<< " parallel jobs." << std::endl << std::endl;
+
+	double start = wall_time();
+
+	while(done < tests.size()) {
+		// Start new jobs
+		while(jobs.size() < (size_t)max_jobs && next < tests.size()) {
+			int fds[2];
+			pid_t pid;
+
+			if(pipe(fds) < 0) {
+				perror("pipe");
+				return -1;
+			}
+
+			std::cout.flush();
+			fflush(stdout);
+
+			pid = fork();
+			if(pid < 0) {
+				perror("fork");
+				return -1;
+			} else if(pid == 0) {
+				close(fds[0]);
+				run_child(tests[next], base, out_dir, fds[1]);
+			}
+
+			close(fds[1]);
+			batch_job &j = jobs[pid];
+			j.test = next++;
+			j.fd = fds[0];
+			j.start = wall_time();
+		}
+
+		// Wait for any job to finish
+		int wstatus;
+		pid_t pid = waitpid(-1, &wstatus, 0);
+		if(pid < 0) {
+			if(errno == EINTR)
+				continue;
+			perror("waitpid");
+			return -1;
+		}
+
+		std::map<pid_t, batch_job>::iterator it = jobs.find(pid);
+		if(it == jobs.end())
+			continue;
+
+		batch_test &t = tests[it->second.test];
+		sim_result res;
+		bool have_res = (read(it->second.fd, &res, sizeof(res)) == sizeof(res));
+
+		close(it->second.fd);
+		t.wall = wall_time() - it->second.start;
+		evaluate(t, res, have_res, wstatus, out_dir);
+		jobs.erase(it);
+
+		++done;
+		if(!t.pass)
+			++failed;
+
+		std::cout << "[" << std::setw(4) << std::setfill(' ') << done << "/"
+			<< tests.size() << "] " << (t.pass ? "PASS " : "FAIL ")
+			<< t.name << " (" << t.cycles << " cycles, " << std::fixed
+			<< std::setprecision(2) << t.wall << " s)";
+		if(!t.pass)
+			std::cout << ": " << t.reason;
+		std::cout << std::endl;
+	}
+
+	double wall = wall_time() - start;
+
+	std::cout << std::endl << "Passed: " << tests.size() - failed
+		<< ", failed: " << failed << ", wall time: " << std::fixed
+		<< std::setprecision(2) << wall << " s" << std::endl;
+
+	if(bc.json_file && !write_json(bc.json_file, tests, failed, wall))
+		return -1;
+	if(bc.junit_file && !write_junit(bc.junit_file, tests, failed, wall))
+		return -1;
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Batch regression runner.
+ *
+ * Runs tests listed in a manifest file in parallel. Each test is a
+ * separate model instance simulated in its own child process, so tests
+ * are fully isolated. Manifest format, one test per line:
+ *
+ *   <name> <rom_image> <ram_image> <expected_output> <max_cycles> [<input>]
+ *
+ * Missing image or expected output file is given as '-'. Image with .elf
+ * extension is loaded directly (one ELF file per test). Relative paths
+ * are relative to manifest location. Lines starting with '#' are
+ * comments. Test passes if it stops (0xFF from UART or $finish) within
+ * cycle budget and its UART output matches expected output file. Wall
+ * time limit and hang detection options apply to each test.
+ */
+
+#ifndef _VL_BATCH_H_
+#define _VL_BATCH_H_
+
+#include "sim.h"
+
+
+// Batch run parameters
+struct batch_config {
+	const char *manifest;		// Manifest file
+	int jobs;			// Parallel jobs (0 - number of CPUs)
+	const char *out_dir;		// Directory for test logs and outputs
+	const char *json_file;		// JSON summary file or NULL
+	const char *junit_file;		// JUnit XML summary file or NULL
+
+	batch_config()
+		: manifest(0), jobs(0), out_dir("batch_out"), json_file(0),
+		junit_file(0)
+	{}
+};
+
+
+// Run batch. Simulation options for each test are taken from base.
+// Returns 0 if all tests passed, 1 if some failed, -1 on error.
+int run_batch(const batch_config &bc, const sim_config &base);
+
+
+#endif /* _VL_BATCH_H_ */
@@ -0,0 +1,69 @@
+#!/bin/sh
+# The UltiSoC Project
+# Verilated model throughput benchmark: single- vs multi-threaded builds.
+#
+# Usage: bench_threads.sh <rom_image.hex> [seconds] [threads list] [first CPU]
+#   seconds      - wall time of each run (default: 30);
+#   threads list - thread counts to compare, 0 - single-threaded build
+#                  (default: "0 1 2 4");
+#   first CPU    - pin model threads starting from this CPU (default: none).
+#
+# Each configuration is built into bench/vl_ultisoc_t<N>.elf and run with
+# the ROM image until interrupted after given wall time. Simulated
+# cycles/second is taken from model statistics.
+
+ROM_IMAGE=$1
+SECONDS_PER_RUN=${2:-30}
+THREADS_LIST=${3:-"0 1 2 4"}
+FIRST_CPU=$4
+
+if [ -z "$ROM_IMAGE" ]; then
+	echo "Usage: $0 <rom_image.hex> [seconds] [threads list] [first CPU]"
+	exit 1
+fi
+if [ ! -f "$ROM_IMAGE" ]; then
+	echo "$ROM_IMAGE: file not found"
+	exit 1
+fi
+
+# Make ROM image path absolute before changing directory
+case "$ROM_IMAGE" in
+	/*) ;;
+	*) ROM_IMAGE="`pwd`/$ROM_IMAGE" ;;
+esac
+
+cd "`dirname "$0"`" || exit 1
+mkdir -p bench || exit 1
+
+# Build
+for n in $THREADS_LIST; do
+	if [ "$n" = "0" ]; then THREADS_ARG=""; else THREADS_ARG="THREADS=$n"; fi
+	echo "Building model (threads: $n)..."
+	make clean > /dev/null
+	make $THREADS_ARG > bench/build_t$n.log 2>&1 || {
+		echo "Build failed, see bench/build_t$n.log"
+		exit 1
+	}
+	cp vl_ultisoc.elf bench/vl_ultisoc_t$n.elf
+done
+
+# Run
+PIN_ARG=""
+if [ -n "$FIRST_CPU" ]; then PIN_ARG="-pin_cpu $FIRST_CPU"; fi
+
+echo ""
+echo "Threads  Cycles/sec  Speedup"
+echo "-------  ----------  -------"
+BASE=""
+for n in $THREADS_LIST; do
+	timeout -s INT "$SECONDS_PER_RUN" bench/vl_ultisoc_t$n.elf \
+		-rom_image "$ROM_IMAGE" -uart_nostop -stats $PIN_ARG \
+		< /dev/null > bench/run_t$n.log 2>&1
+	CPS=`sed -n 's/^Cycles\/sec: *//p' bench/run_t$n.log`
+	if [ -z "$CPS" ]; then
+		echo "Run failed, see bench/run_t$n.log"
+		exit 1
+	fi
+	if [ -z "$BASE" ]; then BASE=$CPS; fi
+	printf "%7s  %10s  %7s\n" $n $CPS `echo "$CPS $BASE" | awk '{ printf "%.2f", $1 / $2 }'`
+done
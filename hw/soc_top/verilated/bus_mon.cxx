@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * OCP fabric bus monitor.
+ */
+
+#include <string.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "bus_mon.h"
+
+
+// OCP commands and responses (see ocp_const.vh)
+static const unsigned ocp_cmd_idle = 0;
+static const unsigned ocp_cmd_write = 1;
+static const unsigned ocp_resp_null = 0;
+static const unsigned ocp_resp_dva = 1;
+
+// Port names
+static const char *master_names[BUS_MASTERS] = { "ibus", "dbus" };
+static const char *slave_names[BUS_SLAVES] = {
+	"memory", "uart", "control", "intctl", "timer"
+};
+
+// Histogram bucket labels
+static const char *bucket_names[bus_monitor::BUCKETS] = {
+	"1", "2", "3", "4", "5-8", "9-16", "17-32", ">32"
+};
+
+
+// Slave port of address (see soc_regs.h). Returns -1 if unmapped.
+static int slave_port(vluint32_t addr)
+{
+	if(!(addr & 0x80000000))
+		return 0;				// Memory
+	if((addr & 0xFFC00000) == 0x80000000)
+		return 1 + ((addr >> 20) & 0x3);	// I/O devices
+	return -1;
+}
+
+
+// Histogram bucket of latency
+static unsigned bucket(vluint64_t lat)
+{
+	if(lat <= 4)
+		return (lat ? lat - 1 : 0);
+	else if(lat <= 8)
+		return 4;
+	else if(lat <= 16)
+		return 5;
+	else if(lat <= 32)
+		return 6;
+	return 7;
+}
+
+
+bus_monitor::bus_monitor()
+	: m_cycles(0)
+{
+	memset(m_master, 0, sizeof(m_master));
+	memset(m_slave, 0, sizeof(m_slave));
+	memset(m_conflicts, 0, sizeof(m_conflicts));
+	for(unsigned i = 0; i < BUS_MASTERS; ++i)
+		m_master[i].name = master_names[i];
+	for(unsigned i = 0; i < BUS_SLAVES; ++i)
+		m_slave[i].name = slave_names[i];
+}
+
+
+void bus_monitor::track(port &pt, vluint64_t cycle, unsigned cmd, bool accept,
+	unsigned resp)
+{
+	if(!pt.active && cmd != ocp_cmd_idle) {
+		pt.active = true;
+		pt.write = (cmd == ocp_cmd_write);
+		pt.start = cycle;
+	}
+
+	if(!pt.active)
+		return;
+
+	++pt.busy;
+	if(cmd != ocp_cmd_idle && !accept)
+		++pt.wait;
+
+	if(resp != ocp_resp_null) {
+		vluint64_t lat = cycle - pt.start + 1;
+		++pt.count[pt.write];
+		pt.lat_sum[pt.write] += lat;
+		++pt.hist[pt.write][bucket(lat)];
+		if(resp != ocp_resp_dva)
+			++pt.errors;
+		pt.active = false;
+	}
+}
+
+
+void bus_monitor::observe(vluint64_t cycle, const bus_probe &p)
+{
+	++m_cycles;
+
+	// Conflicts: command waits while other master talks to the same slave
+	for(unsigned i = 0; i < BUS_MASTERS; ++i) {
+		const port &other = m_master[BUS_MASTERS - 1 - i];
+		if(p.mcmd[i] != ocp_cmd_idle && !p.maccept[i] && other.active &&
+			other.slave == slave_port(p.maddr[i]))
+			++m_conflicts[i];
+	}
+
+	for(unsigned i = 0; i < BUS_MASTERS; ++i) {
+		if(!m_master[i].active && p.mcmd[i] != ocp_cmd_idle)
+			m_master[i].slave = slave_port(p.maddr[i]);
+		track(m_master[i], cycle, p.mcmd[i], p.maccept[i], p.mresp[i]);
+	}
+
+	for(unsigned i = 0; i < BUS_SLAVES; ++i)
+		track(m_slave[i], cycle, p.scmd[i], p.saccept[i], p.sresp[i]);
+}
+
+
+void bus_monitor::print_port(std::ostream &os, const port &pt) const
+{
+	os << std::setw(8) << std::left << pt.name << std::right
+		<< std::setw(11) << pt.count[0] << std::setw(11) << pt.count[1]
+		<< std::setw(7) << pt.errors << std::setw(8) << std::setprecision(2)
+		<< (m_cycles ? 100.0 * pt.busy / m_cycles : 0.0)
+		<< std::setw(11) << pt.wait;
+	for(unsigned k = 0; k < 2; ++k) {
+		os << std::setw(k ? 7 : 8) << std::setprecision(2)
+			<< (pt.count[k] ? (double)pt.lat_sum[k] / pt.count[k] : 0.0);
+	}
+	os << std::endl;
+}
+
+
+void bus_monitor::print(std::ostream &os) const
+{
+	os << std::fixed << std::setfill(' ');
+	os << "Bus port      Reads     Writes Errors  Busy %  Acc. wait"
+		"  Rd lat Wr lat" << std::endl;
+	for(unsigned i = 0; i < BUS_MASTERS; ++i)
+		print_port(os, m_master[i]);
+	for(unsigned i = 0; i < BUS_SLAVES; ++i)
+		print_port(os, m_slave[i]);
+	os << "I/D conflicts: ibus " << m_conflicts[0] << ", dbus "
+		<< m_conflicts[1] << " cycles" << std::endl;
+
+	os << "Latency (cycles) ";
+	for(unsigned b = 0; b < BUCKETS; ++b)
+		os << std::setw(7) << bucket_names[b];
+	os << std::endl;
+	for(unsigned i = 0; i < BUS_MASTERS + BUS_SLAVES; ++i) {
+		const port &pt = (i < BUS_MASTERS ? m_master[i] :
+			m_slave[i - BUS_MASTERS]);
+		for(unsigned k = 0; k < 2; ++k) {
+			if(!pt.count[k])
+				continue;
+			os << std::setw(8) << std::left << pt.name << std::right
+				<< (k ? " write   " : " read    ");
+			for(unsigned b = 0; b < BUCKETS; ++b)
+				os << std::setw(7) << pt.hist[k][b];
+			os << std::endl;
+		}
+	}
+}
+
+
+void bus_monitor::json_port(std::ostream &os, const port &pt, bool master) const
+{
+	static const char *kind[2] = { "read", "write" };
+
+	os << "    { \"name\": \"" << pt.name << "\", \"master\": "
+		<< (master ? "true" : "false")
+		<< ", \"reads\": " << pt.count[0]
+		<< ", \"writes\": " << pt.count[1]
+		<< ", \"errors\": " << pt.errors
+		<< ", \"busy_cycles\": " << pt.busy
+		<< ", \"accept_wait_cycles\": " << pt.wait;
+	for(unsigned k = 0; k < 2; ++k) {
+		os << ", \"" << kind[k] << "_latency\": { \"total\": "
+			<< pt.lat_sum[k] << ", \"histogram\": [";
+		for(unsigned b = 0; b < BUCKETS; ++b)
+			os << (b ? ", " : "") << pt.hist[k][b];
+		os << "] }";
+	}
+	os << " }";
+}
+
+
+bool bus_monitor::write_json(const char *file) const
+{
+	std::ofstream os(file);
+
+	if(!os) {
+		std::cerr << "Bus monitor: cannot create " << file << std::endl;
+		return false;
+	}
+
+	os << "{" << std::endl;
+	os << "  \"cycles\": " << m_cycles << "," << std::endl;
+	os << "  \"buckets\": [";
+	for(unsigned b = 0; b < BUCKETS; ++b)
+		os << (b ? ", " : "") << "\"" << bucket_names[b] << "\"";
+	os << "]," << std::endl;
+	os << "  \"conflicts\": { \"ibus\": " << m_conflicts[0]
+		<< ", \"dbus\": " << m_conflicts[1] << " }," << std::endl;
+	os << "  \"ports\": [" << std::endl;
+	for(unsigned i = 0; i < BUS_MASTERS + BUS_SLAVES; ++i) {
+		bool master = i < BUS_MASTERS;
+		json_port(os, master ? m_master[i] : m_slave[i - BUS_MASTERS], master);
+		os << (i + 1 < BUS_MASTERS + BUS_SLAVES ? "," : "") << std::endl;
+	}
+	os << "  ]" << std::endl;
+	os << "}" << std::endl;
+
+	return os.good();
+}
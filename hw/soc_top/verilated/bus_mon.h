@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * OCP fabric bus monitor.
+ *
+ * Tracks transactions on fabric master ports (I-Bus and D-Bus bridges) and
+ * slave ports (memory, UART, control device, interrupt controller, timer).
+ * Transaction starts with a command and ends with a response. Latency is
+ * counted from command to response inclusive, so master port latency minus
+ * slave port latency is the time spent in the fabric. Master port command
+ * not accepted while the other master has transaction to the same slave is
+ * counted as I/D conflict.
+ */
+
+#ifndef _VL_BUS_MON_H_
+#define _VL_BUS_MON_H_
+
+#include <verilated.h>
+#include <ostream>
+
+
+// Fabric ports
+enum {
+	BUS_MASTERS = 2,	// I-Bus, D-Bus
+	BUS_SLAVES = 5		// Memory, UART, control, interrupts, timer
+};
+
+
+// OCP ports state sampled from the model
+struct bus_probe {
+	vluint32_t maddr[BUS_MASTERS];	// Master port address
+	unsigned mcmd[BUS_MASTERS];	// Master port command
+	bool maccept[BUS_MASTERS];	// Master port command accepted
+	unsigned mresp[BUS_MASTERS];	// Master port response
+	unsigned scmd[BUS_SLAVES];	// Slave port command
+	bool saccept[BUS_SLAVES];	// Slave port command accepted
+	unsigned sresp[BUS_SLAVES];	// Slave port response
+
+	// Sample model outputs. Called after rising edge evaluation.
+	template<class Top>
+	void sample(Top &top)
+	{
+		maddr[0] = top->I_MAddr;
+		mcmd[0] = top->I_MCmd;
+		maccept[0] = top->I_SCmdAccept;
+		mresp[0] = top->I_SResp;
+		maddr[1] = top->D_MAddr;
+		mcmd[1] = top->D_MCmd;
+		maccept[1] = top->D_SCmdAccept;
+		mresp[1] = top->D_SResp;
+		for(unsigned i = 0; i < BUS_SLAVES; ++i) {
+			scmd[i] = (top->P_MCmd >> (3 * i)) & 0x7;
+			saccept[i] = (top->P_SCmdAccept >> i) & 1;
+			sresp[i] = (top->P_SResp >> (2 * i)) & 0x3;
+		}
+	}
+};
+
+
+// Bus monitor
+class bus_monitor {
+public:
+	// Latency histogram buckets: 1, 2, 3, 4, 5-8, 9-16, 17-32, >32
+	enum { BUCKETS = 8 };
+
+	bus_monitor();
+
+	// Observe fabric ports. Called once per cycle on rising edge.
+	void observe(vluint64_t cycle, const bus_probe &p);
+
+	// Print statistics
+	void print(std::ostream &os) const;
+
+	// Write statistics in JSON. Returns false on failure.
+	bool write_json(const char *file) const;
+
+private:
+	// Port statistics and transaction state
+	struct port {
+		const char *name;
+		vluint64_t count[2];		// Reads, writes
+		vluint64_t lat_sum[2];		// Total read, write latency
+		vluint64_t hist[2][BUCKETS];	// Read, write latency histogram
+		vluint64_t errors;		// Error and fail responses
+		vluint64_t busy;		// Cycles with transaction
+		vluint64_t wait;		// Cycles command not accepted
+		bool active;			// Transaction in progress
+		bool write;			// Write transaction
+		int slave;			// Target slave (masters only)
+		vluint64_t start;		// Transaction start cycle
+	};
+
+	// Track port transaction
+	void track(port &pt, vluint64_t cycle, unsigned cmd, bool accept,
+		unsigned resp);
+
+	// Print port line
+	void print_port(std::ostream &os, const port &pt) const;
+
+	// Write port object in JSON
+	void json_port(std::ostream &os, const port &pt, bool master) const;
+
+	port m_master[BUS_MASTERS];
+	port m_slave[BUS_SLAVES];
+	vluint64_t m_conflicts[BUS_MASTERS];	// Cycles blocked by other master
+	vluint64_t m_cycles;
+};
+
+
+#endif /* _VL_BUS_MON_H_ */
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Simulation checkpoints (requires model verilated with --savable).
+ */
+
+#include <string.h>
+#include <iostream>
+#include "checkpoint.h"
+
+#if defined(SIM_SAVABLE)
+
+#include <verilated_save.h>
+
+
+// Checkpoint file signature
+static const char ckpt_magic[8] = { 'U', 'S', 'O', 'C', 'C', 'K', 'P', '1' };
+
+
+bool checkpoint_save(const char *file, const sim_state &st)
+{
+	VerilatedSave os;
+
+	os.open(file);
+	if(!os.isOpen()) {
+		std::cerr << "Failed to create checkpoint " << file << std::endl;
+		return false;
+	}
+
+	os.write(ckpt_magic, sizeof(ckpt_magic));
+	os.write(st.time, sizeof(*st.time));
+	st.host->save(os);
+	st.xactor->save(os);
+	st.dpi->save(os);
+	os << *st.top;
+
+	os.close();
+
+	return true;
+}
+
+
+bool checkpoint_restore(const char *file, const sim_state &st)
+{
+	VerilatedRestore is;
+	char magic[sizeof(ckpt_magic)];
+
+	is.open(file);
+	if(!is.isOpen()) {
+		std::cerr << "Failed to open checkpoint " << file << std::endl;
+		return false;
+	}
+
+	is.read(magic, sizeof(magic));
+	if(memcmp(magic, ckpt_magic, sizeof(magic))) {
+		std::cerr << "Not a checkpoint file: " << file << std::endl;
+		return false;
+	}
+
+	is.read(st.time, sizeof(*st.time));
+	st.host->restore(is);
+	st.xactor->restore(is);
+	st.dpi->restore(is);
+	is >> *st.top;
+
+	is.close();
+
+	return true;
+}
+
+#endif /* SIM_SAVABLE */
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Simulation checkpoints (requires model verilated with --savable).
+ */
+
+#ifndef _VL_CHECKPOINT_H_
+#define _VL_CHECKPOINT_H_
+
+#include <verilated.h>
+#include "Vvl_soc_top.h"
+#include "uart_host.h"
+#include "uart_xactor.h"
+#include "uart_dpi.h"
+
+
+// Harness state saved along with the model
+struct sim_state {
+	vluint64_t *time;	// Simulation time (main_time)
+	Vvl_soc_top *top;	// Model
+	uart_host *host;	// UART host endpoint
+	uart_xactor *xactor;	// UART transactor
+	uart_dpi *dpi;		// UART fast path
+};
+
+
+// Save state to file. Returns false on failure.
+bool checkpoint_save(const char *file, const sim_state &st);
+
+// Restore state from file. Returns false on failure.
+bool checkpoint_restore(const char *file, const sim_state &st);
+
+
+#endif /* _VL_CHECKPOINT_H_ */
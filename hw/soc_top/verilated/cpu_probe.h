@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * CPU buses state sampled from the model.
+ */
+
+#ifndef _VL_CPU_PROBE_H_
+#define _VL_CPU_PROBE_H_
+
+#include <verilated.h>
+
+
+// CPU I-Bus and D-Bus state
+struct cpu_probe {
+	vluint32_t iaddr;	// Fetch address
+	vluint32_t idata;	// Fetched instruction
+	bool ireq;		// Fetch requested
+	bool ifetch;		// Fetch completed
+
+	vluint32_t daddr;	// Data address
+	vluint32_t dwdata;	// Write data
+	vluint32_t drdata;	// Read data
+	vluint8_t dben;		// Byte enables
+	bool dreq;		// Data access requested
+	bool dread;		// Read completed
+	bool dwrite;		// Write completed
+
+	bool intr;		// Interrupt request to CPU
+
+	// Idle buses
+	cpu_probe()
+		: iaddr(0), idata(0), ireq(false), ifetch(false),
+		daddr(0), dwdata(0), drdata(0), dben(0), dreq(false),
+		dread(false), dwrite(false), intr(false)
+	{}
+
+	// Sample model outputs. Called after rising edge evaluation.
+	template<class Top>
+	void sample(Top &top)
+	{
+		iaddr = top->C_IAddr;
+		idata = top->C_IData;
+		ireq = top->C_IRdC;
+		ifetch = top->C_IRdC && top->C_IRdy;
+
+		daddr = top->C_DAddr;
+		dwdata = top->C_DDataM;
+		drdata = top->C_DDataS;
+		dben = top->C_DBen;
+		dreq = top->C_DCmd;
+		dread = top->C_DCmd && top->C_DRdy && top->C_DRnW;
+		dwrite = top->C_DCmd && top->C_DRdy && !top->C_DRnW;
+
+		intr = top->INTR;
+	}
+};
+
+
+#endif /* _VL_CPU_PROBE_H_ */
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * ELF32 (MIPS, little-endian) executable file reader.
+ */
+
+#include <elf.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include "elf_file.h"
+
+
+bool elf_file::read(const char *file)
+{
+	std::ifstream in(file, std::ios::binary);
+	std::vector<unsigned char> img;
+	const Elf32_Ehdr *eh;
+
+	m_entry = 0;
+	m_segs.clear();
+	m_syms.clear();
+
+	if(!in) {
+		std::cerr << "ELF: cannot open " << file << std::endl;
+		return false;
+	}
+
+	img.assign(std::istreambuf_iterator<char>(in),
+		std::istreambuf_iterator<char>());
+
+	// Check header
+	eh = (const Elf32_Ehdr*)(img.size() >= sizeof(Elf32_Ehdr) ? &img[0] : 0);
+	if(!eh || memcmp(eh->e_ident, ELFMAG, SELFMAG) ||
+		eh->e_ident[EI_CLASS] != ELFCLASS32 ||
+		eh->e_ident[EI_DATA] != ELFDATA2LSB) {
+		std::cerr << "ELF: " << file << " is not a little-endian ELF32 file"
+			<< std::endl;
+		return false;
+	}
+
+	if(eh->e_type != ET_EXEC || eh->e_machine != EM_MIPS) {
+		std::cerr << "ELF: " << file << " is not a MIPS executable" << std::endl;
+		return false;
+	}
+
+	if(eh->e_phentsize != sizeof(Elf32_Phdr) ||
+		eh->e_phoff + (size_t)eh->e_phnum * sizeof(Elf32_Phdr) > img.size()) {
+		std::cerr << "ELF: " << file << ": bad program headers" << std::endl;
+		return false;
+	}
+
+	m_entry = eh->e_entry;
+
+	// Collect loadable segments
+	for(unsigned i = 0; i < eh->e_phnum; ++i) {
+		const Elf32_Phdr *ph = (const Elf32_Phdr*)&img[eh->e_phoff +
+			i * sizeof(Elf32_Phdr)];
+		segment seg;
+
+		if(ph->p_type != PT_LOAD || !ph->p_memsz)
+			continue;
+
+		if(ph->p_offset + (size_t)ph->p_filesz > img.size() ||
+			ph->p_filesz > ph->p_memsz) {
+			std::cerr << "ELF: " << file << ": bad segment " << i << std::endl;
+			return false;
+		}
+
+		seg.paddr = ph->p_paddr;
+		seg.memsz = ph->p_memsz;
+		seg.data.assign(img.begin() + ph->p_offset,
+			img.begin() + ph->p_offset + ph->p_filesz);
+		m_segs.push_back(seg);
+	}
+
+	return read_symbols(file, img);
+}
+
+
+bool elf_file::read_symbols(const char *file, const std::vector<unsigned char> &img)
+{
+	const Elf32_Ehdr *eh = (const Elf32_Ehdr*)&img[0];
+
+	if(!eh->e_shoff || !eh->e_shnum)
+		return true;	// Stripped
+
+	if(eh->e_shentsize != sizeof(Elf32_Shdr) ||
+		eh->e_shoff + (size_t)eh->e_shnum * sizeof(Elf32_Shdr) > img.size()) {
+		std::cerr << "ELF: " << file << ": bad section headers" << std::endl;
+		return false;
+	}
+
+	const Elf32_Shdr *sh = (const Elf32_Shdr*)&img[eh->e_shoff];
+	for(unsigned i = 0; i < eh->e_shnum; ++i) {
+		if(sh[i].sh_type != SHT_SYMTAB)
+			continue;
+
+		if(sh[i].sh_link >= eh->e_shnum ||
+			sh[i].sh_offset + (size_t)sh[i].sh_size > img.size() ||
+			sh[sh[i].sh_link].sh_offset +
+				(size_t)sh[sh[i].sh_link].sh_size > img.size()) {
+			std::cerr << "ELF: " << file << ": bad symbol table" << std::endl;
+			return false;
+		}
+
+		const Elf32_Sym *sym = (const Elf32_Sym*)&img[sh[i].sh_offset];
+		const char *str = (const char*)&img[sh[sh[i].sh_link].sh_offset];
+		size_t str_size = sh[sh[i].sh_link].sh_size;
+		size_t n = sh[i].sh_size / sizeof(Elf32_Sym);
+
+		for(size_t j = 0; j < n; ++j) {
+			unsigned type = ELF32_ST_TYPE(sym[j].st_info);
+			symbol s;
+
+			// Defined functions and assembler labels only
+			if((type != STT_FUNC && type != STT_NOTYPE) ||
+				sym[j].st_shndx == SHN_UNDEF ||
+				sym[j].st_shndx >= eh->e_shnum ||
+				!(sh[sym[j].st_shndx].sh_flags & SHF_EXECINSTR) ||
+				sym[j].st_name >= str_size || !str[sym[j].st_name])
+				continue;
+
+			const Elf32_Shdr &sec = sh[sym[j].st_shndx];
+			s.addr = sym[j].st_value;
+			s.size = (sym[j].st_size ? sym[j].st_size :
+				sec.sh_addr + sec.sh_size - sym[j].st_value);
+			s.name.assign(str + sym[j].st_name,
+				strnlen(str + sym[j].st_name, str_size - sym[j].st_name));
+			m_syms.push_back(s);
+		}
+	}
+
+	// Sort and drop aliases. Labels without size extend up to section end,
+	// symbols are clipped by next symbol.
+	std::stable_sort(m_syms.begin(), m_syms.end());
+	std::vector<symbol> syms;
+	for(size_t i = 0; i < m_syms.size(); ++i) {
+		if(!syms.empty() && syms.back().addr == m_syms[i].addr)
+			continue;
+		syms.push_back(m_syms[i]);
+	}
+	for(size_t i = 0; i < syms.size(); ++i) {
+		if(i + 1 < syms.size() && syms[i + 1].addr - syms[i].addr < syms[i].size)
+			syms[i].size = syms[i + 1].addr - syms[i].addr;
+	}
+	m_syms.swap(syms);
+
+	return true;
+}
+
+
+int elf_file::find_symbol(vluint32_t addr) const
+{
+	symbol key;
+	key.addr = addr;
+
+	// Last symbol starting at or below address
+	std::vector<symbol>::const_iterator it =
+		std::upper_bound(m_syms.begin(), m_syms.end(), key);
+	if(it == m_syms.begin())
+		return -1;
+	--it;
+
+	return (addr - it->addr < it->size ? (int)(it - m_syms.begin()) : -1);
+}
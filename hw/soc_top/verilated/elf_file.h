@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * ELF32 (MIPS, little-endian) executable file reader.
+ */
+
+#ifndef _VL_ELF_FILE_H_
+#define _VL_ELF_FILE_H_
+
+#include <verilated.h>
+#include <string>
+#include <vector>
+
+
+// ELF executable
+class elf_file {
+public:
+	// Loadable segment
+	struct segment {
+		vluint32_t paddr;			// Physical address
+		vluint32_t memsz;			// Size in memory
+		std::vector<unsigned char> data;	// File image (may be shorter)
+	};
+
+	// Code symbol
+	struct symbol {
+		vluint32_t addr;	// Start address
+		vluint32_t size;	// Size (up to next symbol if not set)
+		std::string name;
+
+		bool operator<(const symbol &s) const { return addr < s.addr; }
+	};
+
+	// Read executable. Returns false and prints error on failure.
+	bool read(const char *file);
+
+	// Entry point
+	vluint32_t entry() const { return m_entry; }
+
+	// Loadable segments
+	const std::vector<segment> &segments() const { return m_segs; }
+
+	// Function and label symbols sorted by address
+	const std::vector<symbol> &symbols() const { return m_syms; }
+
+	// Find symbol containing address. Returns index or -1.
+	int find_symbol(vluint32_t addr) const;
+
+private:
+	// Read symbol table if present
+	bool read_symbols(const char *file, const std::vector<unsigned char> &img);
+
+	vluint32_t m_entry;
+	std::vector<segment> m_segs;
+	std::vector<symbol> m_syms;
+};
+
+
+#endif /* _VL_ELF_FILE_H_ */
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Idle-cycle fast-forward engine.
+ */
+
+#include "fast_fwd.h"
+
+
+// Tight loop limit in fetches per iteration
+static const unsigned max_loop_fetches = 64;
+
+// Number of identical iterations to consider loop quiescent
+static const unsigned min_stable_iters = 2;
+
+// Idle cycles after wait instruction to consider CPU halted
+static const unsigned wait_idle_cycles = 128;
+
+// Address map (see soc_regs.h)
+static const vluint32_t io_base = 0x80000000;
+static const vluint32_t uart_base = 0x80000000;
+static const vluint32_t uart_end = 0x80100000;
+static const vluint32_t itimer_ctrl = 0x80300000;
+
+
+// Signature mixing step
+static inline vluint32_t mix(vluint32_t h, vluint32_t v)
+{
+	return (h ^ v) * 16777619u;
+}
+
+
+// Returns true for mfc0/mtc0 instructions
+static inline bool is_cop0_move(vluint32_t w)
+{
+	unsigned rs = (w >> 21) & 0x1F;
+	return (w >> 26) == 0x10 && (rs == 0 || rs == 4);
+}
+
+
+// Returns true for wait instruction
+static inline bool is_wait(vluint32_t w)
+{
+	return (w & 0xFE00003F) == 0x42000020;
+}
+
+
+fast_fwd::fast_fwd()
+	: m_cycle(0), m_intr(false), m_timer_en(false), m_head_valid(false),
+	m_head(0), m_last_fetch(0), m_iter_start(0), m_iter_hash(0),
+	m_iter_fetches(0), m_iter_clean(false), m_iter_uart(false),
+	m_prev_hash(0), m_prev_len(0), m_stable(0), m_since_wait(~0u),
+	m_last_activity(0), m_skipped(0), m_jumps(0)
+{
+}
+
+
+void fast_fwd::start_iter(vluint64_t cycle)
+{
+	m_iter_start = cycle;
+	m_iter_hash = 2166136261u;
+	m_iter_fetches = 0;
+	m_iter_clean = true;
+	m_iter_uart = false;
+}
+
+
+void fast_fwd::observe(vluint64_t cycle, const cpu_probe &p)
+{
+	m_cycle = cycle;
+	m_intr = p.intr;
+
+	if(p.dwrite) {
+		if(p.daddr == itimer_ctrl)
+			m_timer_en = (p.dwdata & 1);
+		m_iter_clean = false;
+		m_last_activity = cycle;
+	}
+
+	if(p.dread) {
+		if(p.daddr >= uart_base && p.daddr < uart_end)
+			m_iter_uart = true;
+		else if(p.daddr >= io_base)
+			m_iter_clean = false;	// Other devices may change state
+		m_iter_hash = mix(mix(m_iter_hash, p.daddr), p.drdata);
+		m_last_activity = cycle;
+	}
+
+	if(!p.ifetch)
+		return;
+
+	m_last_activity = cycle;
+
+	if(is_wait(p.idata))
+		m_since_wait = 0;
+	else if(m_since_wait != ~0u)
+		++m_since_wait;
+
+	if(m_head_valid && p.iaddr == m_head) {
+		// Loop head reached, compare with previous iteration
+		vluint64_t len = cycle - m_iter_start;
+		if(m_iter_clean && m_iter_uart && m_iter_hash == m_prev_hash &&
+			len == m_prev_len)
+			++m_stable;
+		else
+			m_stable = 0;
+		m_prev_hash = m_iter_hash;
+		m_prev_len = len;
+		start_iter(cycle);
+	} else if(p.iaddr < m_last_fetch && (!m_head_valid || !m_iter_clean)) {
+		// Backward jump, new loop candidate
+		m_head_valid = true;
+		m_head = p.iaddr;
+		m_stable = 0;
+		m_prev_len = 0;
+		start_iter(cycle);
+	}
+
+	m_last_fetch = p.iaddr;
+	m_iter_hash = mix(mix(m_iter_hash, p.iaddr), p.idata);
+
+	if(++m_iter_fetches > max_loop_fetches || is_cop0_move(p.idata))
+		m_iter_clean = false;
+}
+
+
+vluint64_t fast_fwd::period() const
+{
+	if(m_intr || m_timer_en)
+		return 0;
+
+	// CPU halted by wait instruction
+	if(m_since_wait < 4 && m_cycle - m_last_activity >= wait_idle_cycles)
+		return 1;
+
+	// CPU spins in polling loop
+	if(m_stable >= min_stable_iters && m_iter_clean &&
+		m_cycle - m_iter_start < m_prev_len)
+		return m_prev_len;
+
+	return 0;
+}
+
+
+void fast_fwd::skip(vluint64_t n)
+{
+	m_iter_start += n;
+	m_last_activity += n;
+	m_cycle += n;
+	m_skipped += n;
+	++m_jumps;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Idle-cycle fast-forward engine.
+ *
+ * Detects quiescent states of the model: CPU spinning in a polling loop
+ * or halted by a wait instruction with no other activity. Such states are
+ * periodic, so simulation time can be advanced by a whole number of loop
+ * periods without evaluating the model, up to the next known external
+ * event (UART fast path transfer or host input poll).
+ *
+ * Limitations: CP0 time stamp counter lives inside the CPU and is not
+ * advanced over skipped cycles, therefore loops accessing CP0 are never
+ * skipped. Polling loops must read UART registers and must not access
+ * anything except memory and UART. Enabled interval timer disables
+ * fast-forward. Performance counters of soc_control are advanced by the
+ * harness: their change over one loop period is measured right before
+ * each jump and multiplied by the number of skipped periods.
+ */
+
+#ifndef _VL_FAST_FWD_H_
+#define _VL_FAST_FWD_H_
+
+#include <verilated.h>
+#include "cpu_probe.h"
+
+
+// Fast-forward engine
+class fast_fwd {
+public:
+	fast_fwd();
+
+	// Observe CPU buses. Called once per cycle on rising edge.
+	void observe(vluint64_t cycle, const cpu_probe &p);
+
+	// Returns quiescent loop period in cycles or 0 if model is active
+	vluint64_t period() const;
+
+	// Account cycles skipped by the caller
+	void skip(vluint64_t n);
+
+	// Statistics
+	vluint64_t skipped() const { return m_skipped; }
+	vluint64_t jumps() const { return m_jumps; }
+
+private:
+	// Start new loop iteration
+	void start_iter(vluint64_t cycle);
+
+	vluint64_t m_cycle;		// Last observed cycle
+	bool m_intr;			// Interrupt request pending
+	bool m_timer_en;		// Interval timer enabled
+
+	// Loop tracking
+	bool m_head_valid;		// Loop head address is valid
+	vluint32_t m_head;		// Loop head address
+	vluint32_t m_last_fetch;	// Previous fetch address
+	vluint64_t m_iter_start;	// Cycle of current iteration start
+	vluint32_t m_iter_hash;		// Current iteration signature
+	unsigned m_iter_fetches;	// Fetches in current iteration
+	bool m_iter_clean;		// Current iteration is side effect free
+	bool m_iter_uart;		// Current iteration polls UART
+	vluint32_t m_prev_hash;		// Previous iteration signature
+	vluint64_t m_prev_len;		// Previous iteration length
+	unsigned m_stable;		// Number of identical iterations
+
+	// Wait instruction tracking
+	unsigned m_since_wait;		// Fetches since wait instruction
+	vluint64_t m_last_activity;	// Last cycle with bus activity
+
+	// Statistics
+	vluint64_t m_skipped;
+	vluint64_t m_jumps;
+};
+
+
+#endif /* _VL_FAST_FWD_H_ */
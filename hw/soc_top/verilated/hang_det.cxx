@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * CPU hang detector.
+ */
+
+#include <iomanip>
+#include "hang_det.h"
+
+
+// Max size of address window of a stuck loop in bytes
+static const vluint32_t stuck_window = 16;
+
+// Loop collapsing depth in PC history
+static const size_t collapse_depth = stuck_window / 4;
+
+
+hang_detector::hang_detector(vluint64_t stuck_cycles, unsigned history)
+	: m_stuck_cycles(stuck_cycles), m_stuck(false), m_started(false),
+	m_since(0), m_lo(0), m_hi(0), m_empty(true),
+	m_ring(history ? history : 1), m_head(0), m_count(0)
+{
+}
+
+
+void hang_detector::record(vluint32_t pc)
+{
+	// Collapse short loops
+	for(size_t i = 1; i <= collapse_depth && i <= m_count; ++i) {
+		if(m_ring[(m_head + m_ring.size() - i) % m_ring.size()] == pc)
+			return;
+	}
+
+	m_ring[m_head] = pc;
+	m_head = (m_head + 1) % m_ring.size();
+	if(m_count < m_ring.size())
+		++m_count;
+}
+
+
+void hang_detector::observe(vluint64_t cycle, const cpu_probe &p)
+{
+	if(p.ifetch)
+		record(p.iaddr);
+
+	if(!m_stuck_cycles)
+		return;
+
+	if(p.dwrite || !m_started) {
+		// Progress is made (or first cycle), restart window
+		m_since = cycle;
+		m_empty = true;
+		m_started = true;
+	}
+
+	if(p.ifetch) {
+		vluint32_t lo = (m_empty || p.iaddr < m_lo ? p.iaddr : m_lo);
+		vluint32_t hi = (m_empty || p.iaddr > m_hi ? p.iaddr : m_hi);
+		if(hi - lo >= stuck_window) {
+			// Left the window, start a new one here
+			m_since = cycle;
+			lo = hi = p.iaddr;
+		}
+		m_lo = lo;
+		m_hi = hi;
+		m_empty = false;
+	}
+
+	m_stuck = (cycle - m_since >= m_stuck_cycles);
+}
+
+
+void hang_detector::dump(std::ostream &os) const
+{
+	std::ios::fmtflags flags = os.flags();
+	char fill = os.fill();
+
+	os << "Last fetched PCs (oldest first):" << std::endl;
+	for(size_t i = 0; i < m_count; ++i) {
+		size_t idx = (m_head + m_ring.size() - m_count + i) % m_ring.size();
+		os << "  0x" << std::hex << std::setw(8) << std::setfill('0')
+			<< m_ring[idx] << std::endl;
+	}
+
+	os.flags(flags);
+	os.fill(fill);
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * CPU hang detector.
+ *
+ * CPU is considered stuck when all instruction fetches stay within a small
+ * address window (single instruction or short branch-to-self loop) and no
+ * D-Bus writes happen for given number of cycles. CPU halted with no
+ * fetches at all is stuck as well. History of recently fetched PCs is kept
+ * for diagnostics; repeated iterations of short loops are collapsed.
+ */
+
+#ifndef _VL_HANG_DET_H_
+#define _VL_HANG_DET_H_
+
+#include <verilated.h>
+#include <ostream>
+#include <vector>
+#include "cpu_probe.h"
+
+
+// Hang detector
+class hang_detector {
+public:
+	// Stuck time in cycles (0 - detection off) and PC history length
+	hang_detector(vluint64_t stuck_cycles, unsigned history);
+
+	// Observe CPU buses. Called once per cycle on rising edge.
+	void observe(vluint64_t cycle, const cpu_probe &p);
+
+	// Returns true if CPU is stuck
+	bool stuck() const { return m_stuck; }
+
+	// Address window of stuck loop
+	vluint32_t window_lo() const { return m_lo; }
+	vluint32_t window_hi() const { return m_hi; }
+
+	// Cycle since which CPU is stuck
+	vluint64_t since() const { return m_since; }
+
+	// Dump recent PCs, oldest first
+	void dump(std::ostream &os) const;
+
+private:
+	// Record PC in history
+	void record(vluint32_t pc);
+
+	vluint64_t m_stuck_cycles;
+	bool m_stuck;
+	bool m_started;		// First cycle observed
+
+	// Current confinement window
+	vluint64_t m_since;	// Window start cycle
+	vluint32_t m_lo;	// Lowest fetched address
+	vluint32_t m_hi;	// Highest fetched address
+	bool m_empty;		// No fetches in window yet
+
+	// PC history ring
+	std::vector<vluint32_t> m_ring;
+	size_t m_head;		// Next slot
+	size_t m_count;		// Valid entries
+};
+
+
+#endif /* _VL_HANG_DET_H_ */
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Instruction trace writer.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <iostream>
+#include "itrace_fmt.h"
+#include "itrace.h"
+
+
+// Output buffer size
+static const size_t buf_size = 1 << 20;
+
+// Invalid cache tag (PCs are word aligned)
+static const vluint32_t no_tag = 0xFFFFFFFF;
+
+
+itrace_writer::itrace_writer()
+	: m_file(0), m_cycle(0), m_pc(0), m_daddr(0),
+	m_itag(ITRACE_ICACHE_SIZE, no_tag), m_iword(ITRACE_ICACHE_SIZE, 0),
+	m_memq(0), m_memq_n(0), m_records(0), m_bytes(0)
+{
+}
+
+
+itrace_writer::~itrace_writer()
+{
+	close();
+}
+
+
+bool itrace_writer::open(const char *file)
+{
+	m_file = fopen(file, "wb");
+	if(!m_file) {
+		std::cerr << "Instruction trace: " << file << ": "
+			<< strerror(errno) << std::endl;
+		return false;
+	}
+
+	setvbuf(m_file, 0, _IOFBF, buf_size);
+	fwrite(ITRACE_MAGIC, 1, ITRACE_MAGIC_LEN, m_file);
+	m_bytes = ITRACE_MAGIC_LEN;
+
+	return true;
+}
+
+
+void itrace_writer::close()
+{
+	if(m_file) {
+		fclose(m_file);
+		m_file = 0;
+	}
+}
+
+
+void itrace_writer::put_byte(unsigned b)
+{
+	putc(b, m_file);
+	++m_bytes;
+}
+
+
+void itrace_writer::put_uleb(vluint64_t v)
+{
+	while(v >= 0x80) {
+		put_byte((v & 0x7F) | 0x80);
+		v >>= 7;
+	}
+	put_byte(v);
+}
+
+
+void itrace_writer::put_sleb(vluint32_t from, vluint32_t to)
+{
+	vluint32_t d = to - from;
+
+	// Zigzag encoding of 32-bit signed delta
+	put_uleb((d << 1) ^ (vluint32_t)((vlsint32_t)d >> 31));
+}
+
+
+void itrace_writer::put_word(vluint32_t w)
+{
+	put_byte(w & 0xFF);
+	put_byte((w >> 8) & 0xFF);
+	put_byte((w >> 16) & 0xFF);
+	put_byte(w >> 24);
+}
+
+
+void itrace_writer::desync(vluint64_t cycle, unsigned flags)
+{
+	put_byte(ITRACE_REC_DESYNC | flags);
+	put_uleb(cycle - m_cycle);
+
+	m_cycle = cycle;
+	m_memq = 0;
+	m_memq_n = 0;
+	++m_records;
+}
+
+
+void itrace_writer::fetch(vluint64_t cycle, vluint32_t pc, vluint32_t instr)
+{
+	unsigned idx = (pc >> 2) & (ITRACE_ICACHE_SIZE - 1);
+	unsigned tag = ITRACE_REC_FETCH;
+	bool cached = (m_itag[idx] == pc && m_iword[idx] == instr);
+	unsigned op = instr >> 26;
+
+	if(!m_file)
+		return;
+
+	// Queue loads / stores to pair them with data accesses
+	if(ITRACE_OP_LOAD(op) || ITRACE_OP_STORE(op)) {
+		if(m_memq_n == ITRACE_MEMQ_SIZE)
+			desync(cycle, ITRACE_F_OVERFLOW);
+		if(ITRACE_OP_LOAD(op))
+			m_memq |= 1 << m_memq_n;
+		++m_memq_n;
+	}
+
+	if(pc == m_pc + 4)
+		tag |= ITRACE_F_SEQ;
+	if(cached)
+		tag |= ITRACE_F_CACHED;
+
+	put_byte(tag);
+	put_uleb(cycle - m_cycle);
+	if(!(tag & ITRACE_F_SEQ))
+		put_sleb(m_pc, pc);
+	if(!cached) {
+		put_word(instr);
+		m_itag[idx] = pc;
+		m_iword[idx] = instr;
+	}
+
+	m_cycle = cycle;
+	m_pc = pc;
+	++m_records;
+}
+
+
+void itrace_writer::data(vluint64_t cycle, vluint32_t addr, vluint32_t data,
+	unsigned ben, bool write)
+{
+	unsigned tag = ITRACE_REC_DATA | ((ben & 0xF) << ITRACE_BEN_SHIFT);
+
+	if(!m_file)
+		return;
+
+	if(write)
+		tag |= ITRACE_F_WRITE;
+
+	// Access must match the oldest pending load / store
+	if(!m_memq_n || (m_memq & 1) != (write ? 0u : 1u))
+		desync(cycle, 0);
+	else {
+		m_memq >>= 1;
+		--m_memq_n;
+	}
+
+	put_byte(tag);
+	put_uleb(cycle - m_cycle);
+	put_sleb(m_daddr, addr);
+	put_word(data);
+
+	m_cycle = cycle;
+	m_daddr = addr;
+	++m_records;
+}
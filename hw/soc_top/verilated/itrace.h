@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Instruction trace writer.
+ *
+ * Records instruction fetches and data accesses observed on CPU buses in
+ * compact binary format (see itrace_fmt.h). Use itrace_dec to print it.
+ * Fetches are not retirements and ALU writebacks are not recorded.
+ */
+
+#ifndef _VL_ITRACE_H_
+#define _VL_ITRACE_H_
+
+#include <stdio.h>
+#include <verilated.h>
+#include <vector>
+
+
+// Instruction trace writer
+class itrace_writer {
+public:
+	itrace_writer();
+	~itrace_writer();
+
+	// Create trace file. Returns false on failure.
+	bool open(const char *file);
+
+	// Close trace file
+	void close();
+
+	// Returns true if trace file is open
+	bool is_open() const { return m_file != 0; }
+
+	// Record instruction fetch
+	void fetch(vluint64_t cycle, vluint32_t pc, vluint32_t instr);
+
+	// Record data access
+	void data(vluint64_t cycle, vluint32_t addr, vluint32_t data,
+		unsigned ben, bool write);
+
+	// Statistics
+	vluint64_t records() const { return m_records; }
+	vluint64_t bytes() const { return m_bytes; }
+
+private:
+	void put_byte(unsigned b);
+	void put_uleb(vluint64_t v);
+	void put_sleb(vluint32_t from, vluint32_t to);
+	void put_word(vluint32_t w);
+	void desync(vluint64_t cycle, unsigned flags);
+
+	FILE *m_file;
+	vluint64_t m_cycle;		// Cycle of previous record
+	vluint32_t m_pc;		// Previous fetch address
+	vluint32_t m_daddr;		// Previous data address
+	std::vector<vluint32_t> m_itag;	// Instruction cache tags (PCs)
+	std::vector<vluint32_t> m_iword;	// Instruction cache words
+	unsigned m_memq;		// Pending loads / stores (bit set - load)
+	unsigned m_memq_n;		// Pending loads / stores count
+	vluint64_t m_records;
+	vluint64_t m_bytes;
+
+	itrace_writer(const itrace_writer&);
+	itrace_writer& operator=(const itrace_writer&);
+};
+
+
+#endif /* _VL_ITRACE_H_ */
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Instruction trace decoder.
+ *
+ * Prints instruction trace recorded by the Verilated model (-itrace) with
+ * instructions disassembled by BootROM disassembler. Loaded values are
+ * annotated with destination register of the matching load instruction.
+ * Listed instructions are fetches and may include squashed ones; results
+ * of non-load instructions are not in the trace (see itrace_fmt.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <con.h>
+#include <disasm.h>
+#include "itrace_fmt.h"
+
+
+/* Console output for disassembler */
+void con_putc(char ch)
+{
+	putchar(ch);
+}
+
+
+void cprint_str(const char *str)
+{
+	fputs(str ? str : "<NULL>", stdout);
+}
+
+
+void cprint_hex(unsigned hex, size_t nn)
+{
+	printf("%0*X", (int)(nn > 8 ? 8 : nn), nn < 8 ?
+		hex & ((1u << (4 * nn)) - 1) : hex);
+}
+
+
+void cprint_int(int v)
+{
+	printf("%d", v);
+}
+
+
+void cprint_uint(unsigned v)
+{
+	printf("%u", v);
+}
+
+
+void cprint_strf(const char *str, size_t w)
+{
+	size_t i, c;
+
+	if(!w || !str)
+		return;
+
+	for(c = 0, i = 0; i < w; ++i)
+		putchar(str[c] ? str[c++] : ' ');
+}
+
+
+/* Input helpers. Return -1 on end of file. */
+static int get_uleb(FILE *f, unsigned long long *v)
+{
+	int c, shift = 0;
+
+	*v = 0;
+	do {
+		if((c = getc(f)) == EOF)
+			return -1;
+		*v |= (unsigned long long)(c & 0x7F) << shift;
+		shift += 7;
+	} while(c & 0x80);
+
+	return 0;
+}
+
+
+static int get_sleb(FILE *f, u32 *v)
+{
+	unsigned long long z;
+
+	if(get_uleb(f, &z) < 0)
+		return -1;
+	*v += (u32)(z >> 1) ^ (u32)-(s32)(z & 1);
+
+	return 0;
+}
+
+
+static int get_word(FILE *f, u32 *w)
+{
+	unsigned char b[4];
+
+	if(fread(b, 1, 4, f) != 4)
+		return -1;
+	*w = b[0] | (b[1] << 8) | (b[2] << 16) | ((u32)b[3] << 24);
+
+	return 0;
+}
+
+
+/* Returns true for load instructions */
+static int is_load(u32 instr)
+{
+	return ITRACE_OP_LOAD(instr >> 26);
+}
+
+
+/* Returns true for load / store instructions */
+static int is_mem(u32 instr)
+{
+	return is_load(instr) || ITRACE_OP_STORE(instr >> 26);
+}
+
+
+int main(int argc, char **argv)
+{
+	static u32 itag[ITRACE_ICACHE_SIZE];
+	static u32 iword[ITRACE_ICACHE_SIZE];
+	u32 memq[ITRACE_MEMQ_SIZE];
+	unsigned memq_n = 0;
+	char magic[ITRACE_MAGIC_LEN];
+	unsigned long long cycle = 0, delta;
+	u32 pc = 0, daddr = 0, word;
+	FILE *f;
+	int tag;
+
+	if(argc != 2) {
+		fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+		return 1;
+	}
+
+	f = fopen(argv[1], "rb");
+	if(!f) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	if(fread(magic, 1, sizeof(magic), f) != sizeof(magic) ||
+		memcmp(magic, ITRACE_MAGIC, ITRACE_MAGIC_LEN)) {
+		fprintf(stderr, "%s: not an instruction trace\n", argv[1]);
+		return 1;
+	}
+
+	memset(itag, 0xFF, sizeof(itag));
+
+	while((tag = getc(f)) != EOF) {
+		if(get_uleb(f, &delta) < 0)
+			break;
+		cycle += delta;
+
+		if((tag & ITRACE_REC_MASK) == ITRACE_REC_FETCH) {
+			unsigned idx;
+
+			if(tag & ITRACE_F_SEQ)
+				pc += 4;
+			else if(get_sleb(f, &pc) < 0)
+				break;
+
+			idx = (pc >> 2) & (ITRACE_ICACHE_SIZE - 1);
+			if(tag & ITRACE_F_CACHED) {
+				word = iword[idx];
+			} else {
+				if(get_word(f, &word) < 0)
+					break;
+				itag[idx] = pc;
+				iword[idx] = word;
+			}
+
+			/* Remember memory instructions to annotate data accesses.
+			 * Writer resets pairing with desync record before the
+			 * queue overflows. */
+			if(is_mem(word)) {
+				if(memq_n == ITRACE_MEMQ_SIZE) {
+					fprintf(stderr, "%s: pending load / store queue"
+						" overflow\n", argv[1]);
+					return 1;
+				}
+				memq[memq_n++] = word;
+			}
+
+			printf("%12llu  %08X  %08X  ", cycle, pc, word);
+			disasm_instr(word, pc);
+			putchar('\n');
+		} else if((tag & ITRACE_REC_MASK) == ITRACE_REC_DATA) {
+			unsigned ben = (tag >> ITRACE_BEN_SHIFT) & 0xF;
+			u32 instr = 0;
+			int have = 0;
+
+			if(get_sleb(f, &daddr) < 0 || get_word(f, &word) < 0)
+				break;
+
+			if(memq_n) {
+				instr = memq[0];
+				have = 1;
+				memmove(memq, memq + 1, --memq_n * sizeof(memq[0]));
+			}
+
+			printf("%12llu  %8s  %8s  %-8s[%08X] = %08X (BE %X)", cycle, "",
+				"", (tag & ITRACE_F_WRITE) ? "store" : "load", daddr,
+				word, ben);
+			if(have && !(tag & ITRACE_F_WRITE) && is_load(instr))
+				printf(" -> %s", disasm_gprs[(instr >> 16) & 0x1F]);
+			putchar('\n');
+		} else if((tag & ITRACE_REC_MASK) == ITRACE_REC_DESYNC) {
+			/* Pending instructions cannot be paired with data */
+			memq_n = 0;
+			printf("%12llu  %8s  %8s  <desync: %s>\n", cycle, "", "",
+				(tag & ITRACE_F_OVERFLOW) ?
+				"too many pending loads / stores" :
+				"data access without matching load / store");
+		} else {
+			fprintf(stderr, "%s: bad record tag %02X\n", argv[1], tag);
+			return 1;
+		}
+	}
+
+	fclose(f);
+
+	return 0;
+}
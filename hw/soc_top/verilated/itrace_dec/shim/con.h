@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Host replacement of BootROM console for disassembler.
+ */
+
+#ifndef _ITRACE_DEC_CON_H_
+#define _ITRACE_DEC_CON_H_
+
+
+#include <stddef.h>
+
+
+/* Put char */
+void con_putc(char ch);
+
+
+/* Print char */
+static inline
+void cprint_char(char ch)
+{
+	con_putc(ch);
+}
+
+
+/* Print string */
+void cprint_str(const char *str);
+
+
+/* Print HEX value */
+void cprint_hex(unsigned hex, size_t nn);
+
+static inline
+void cprint_hex32(unsigned hex)
+{
+	cprint_hex(hex, 8);
+}
+
+
+/* Print integer value */
+void cprint_int(int v);
+
+
+/* Print unsigned value */
+void cprint_uint(unsigned v);
+
+
+/* Print string field of specified width */
+void cprint_strf(const char *str, size_t w);
+
+
+#endif /* _ITRACE_DEC_CON_H_ */
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Instruction trace binary format. Shared by the model and the decoder.
+ *
+ * File starts with ITRACE_MAGIC followed by records. Each record begins
+ * with a tag byte; record type is in its low bits. All following fields
+ * are optional depending on tag flags:
+ *
+ *   Fetch: tag, cycle delta (uleb128), PC delta (sleb128, omitted if
+ *          ITRACE_F_SEQ), instruction word (4 bytes LE, omitted if
+ *          ITRACE_F_CACHED).
+ *   Data:  tag, cycle delta (uleb128), address delta from previous data
+ *          access (sleb128), data word (4 bytes LE).
+ *   Desync: tag, cycle delta (uleb128).
+ *
+ * Cycle delta is relative to previous record. Instruction words are
+ * cached in a direct-mapped table of ITRACE_ICACHE_SIZE entries indexed
+ * by PC bits [13:2]; a cached word is omitted if it did not change.
+ * Signed values use zigzag encoding before uleb128.
+ *
+ * Records come from the CPU buses, not from pipeline retirement. Fetch
+ * records are instruction fetches, so instructions fetched and then
+ * squashed (e.g. by an exception) appear as executed. GPR writebacks of
+ * ALU and other non-load instructions are absent. A load's writeback is
+ * shown by pairing data accesses with fetched load / store instructions
+ * in fetch order. Writer and decoder keep the same queue of up to
+ * ITRACE_MEMQ_SIZE pending load / store instructions. When the queue
+ * overflows or a data access does not match its head, the writer emits
+ * a desync record and both sides empty the queue.
+ */
+
+#ifndef _VL_ITRACE_FMT_H_
+#define _VL_ITRACE_FMT_H_
+
+
+#define ITRACE_MAGIC		"USOCITR1"	/* File signature */
+#define ITRACE_MAGIC_LEN	8		/* Signature length */
+
+#define ITRACE_REC_MASK		0x03	/* Record type mask */
+#define ITRACE_REC_FETCH	0x01	/* Instruction fetch */
+#define ITRACE_REC_DATA		0x02	/* Data access */
+#define ITRACE_REC_DESYNC	0x03	/* Load / store pairing reset */
+
+#define ITRACE_F_SEQ		0x04	/* Fetch: PC is previous PC + 4 */
+#define ITRACE_F_CACHED		0x08	/* Fetch: word is cached for this PC */
+
+#define ITRACE_F_WRITE		0x04	/* Data: write access */
+#define ITRACE_BEN_SHIFT	4	/* Data: byte enables in tag bits 7:4 */
+
+#define ITRACE_F_OVERFLOW	0x04	/* Desync: too many pending instructions */
+
+#define ITRACE_ICACHE_SIZE	4096	/* Instruction cache entries */
+#define ITRACE_MEMQ_SIZE	4	/* Pending load / store queue size */
+
+/* MIPS-I load and store opcodes (instruction bits 31:26) */
+#define ITRACE_OP_LOAD(op)	((op) == 32 || (op) == 33 || (op) == 35 || \
+				(op) == 36 || (op) == 37)
+#define ITRACE_OP_STORE(op)	((op) == 40 || (op) == 41 || (op) == 43)
+
+
+#endif /* _VL_ITRACE_FMT_H_ */
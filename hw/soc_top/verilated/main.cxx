@@ -27,48 +27,20 @@
  * Verilated cycle accurate system model.
  */
 
-#include <stdio.h>		// For fflush(stdout)
+#include <stdlib.h>
+#include <string.h>
 #include <iostream>
-#include <iomanip>
-#include <string>
 #include <verilated.h>		// Defines common routines
-#if VM_TRACE
-# include <verilated_vcd_c.h>	// Trace file format header
-#endif
-#include "Vvl_soc_top.h"	// From Verilating "vl_soc_top.v"
-
-
-vluint64_t main_time = 0;	// Current simulation time
-const int rst_cycles = 10;	// Reset cycles
-
-
-// Called by $time in Verilog
-double sc_time_stamp()
-{
-	return main_time;
-}
-
-
-// Top-level wrapper
-template<class Top>
-class system_top {
-	Top *m_top;
-public:
-	system_top() : m_top(new Top) {}
-	~system_top() { delete m_top; }
-	Top* operator->() { return m_top; }
-};
+#include "sim.h"		// Simulation run
+#include "batch.h"		// Batch regression runner
 
 
 // MAIN
 int main(int argc, char **argv)
 {
-#if VM_TRACE
-	bool do_trace = false;
-#endif
-	bool do_stats = false;
-	const char *rom_image = 0;
-	const char *ram_image = 0;
+	sim_config cfg;
+	batch_config bc;
+	sim_result res;
 
 	// Print welcome
 	std::cout << "Verilated UltiSoC System Model" << std::endl
@@ -86,23 +58,144 @@ int main(int argc, char **argv)
 			std::cout << "Command line arguments:" << std::endl
 				<< "\t-h                    - this help screen;" << std::endl
 				<< "\t-stats                - print statistics;" << std::endl
+				<< "\t-bus_stats            - print statistics including bus (slows simulation);" << std::endl
+				<< "\t-bus_json <file>      - write bus statistics in JSON;" << std::endl
 #if VM_TRACE
 				<< "\t-trace                - dump trace;" << std::endl
+				<< "\t-trace_file <file>    - trace file (default: vlt_dump.vcd or .fst);" << std::endl
+				<< "\t-trace_start <trig>   - start tracing on trigger: <cycle>, pc:<addr>" << std::endl
+				<< "\t                        or exc[:<ivtb>] (exception vector fetch);" << std::endl
+				<< "\t-trace_stop <trig>    - stop tracing on trigger (see above);" << std::endl
+				<< "\t-trace_window <n>     - keep only last n to 2n traced cycles in" << std::endl
+				<< "\t                        file.<seg>.vcd segments;" << std::endl
+#endif
+				<< "\t-itrace <file>        - record instruction trace (see itrace_dec);" << std::endl
+				<< "\t-profile <file.elf>   - profile program using ELF symbols;" << std::endl
+				<< "\t-profile_period <n>   - profiler sampling period (default: 97 cycles);" << std::endl
+				<< "\t-profile_out <prefix> - profile files prefix (default: profile);" << std::endl
+				<< "\t-rom_image <file.hex> - ROM image;" << std::endl
+				<< "\t-ram_image <file.hex> - RAM image;" << std::endl
+				<< "\t-elf <file.elf>       - load ELF executable directly into ROM/RAM;" << std::endl
+				<< "\t-pin_cpu <n>          - pin model threads to CPUs starting from n;" << std::endl
+				<< "\t-max_cycles <n>       - stop after n cycles (exit code 2);" << std::endl
+				<< "\t-max_wall_seconds <s> - stop after s seconds of wall time (exit code 3);" << std::endl
+				<< "\t-stuck_cycles <n>     - stop if CPU makes no progress for n cycles" << std::endl
+				<< "\t                        (exit code 4);" << std::endl
+				<< "\t-pc_history <n>       - fetched PCs dumped on above stops (default: 32);" << std::endl
+				<< "\t-uart <endpoint>      - UART host endpoint: stdio (default)," << std::endl
+				<< "\t                        pty or tcp:<port>;" << std::endl
+				<< "\t-uart_lf2cr           - translate LF to CR on UART input;" << std::endl
+				<< "\t-uart_nostop          - do not stop simulation on 0xFF from UART;" << std::endl
+				<< "\t-batch <manifest>     - run regression tests listed in manifest;" << std::endl
+				<< "\t-jobs <n>             - parallel batch jobs (default: number of CPUs);" << std::endl
+				<< "\t-batch_dir <dir>      - batch logs and outputs (default: batch_out);" << std::endl
+				<< "\t-json <file>          - write batch summary in JSON;" << std::endl
+				<< "\t-junit <file>         - write batch summary in JUnit XML;" << std::endl
+#if defined(UPUART_DPI)
+				<< "\t-uart_fast            - byte-level UART (bypass serial TX/RX);" << std::endl
+				<< "\t-uart_baud <bps>      - fast UART virtual baud rate, 0 - unlimited" << std::endl
+				<< "\t                        (default: follow programmed divider);" << std::endl
+				<< "\t-ff                   - fast-forward idle cycles (requires -uart_fast," << std::endl
+				<< "\t                        ignored when tracing or profiling);" << std::endl
+#endif
+#if defined(SIM_SAVABLE)
+				<< "\t-save_checkpoint <file>" << std::endl
+				<< "\t                      - save simulation state to file;" << std::endl
+				<< "\t-at <cycle>           - cycle to save checkpoint at (default: 0);" << std::endl
+				<< "\t-restore_checkpoint <file>" << std::endl
+				<< "\t                      - resume simulation from checkpoint." << std::endl
 #endif
-				<< "\t-rom_image <file.hex> - ROM image." << std::endl
-				<< "\t-ram_image <file.hex> - RAM image." << std::endl
 				<< std::endl;
 			return 0;
 		} else if(!strcmp(argv[i], "-stats")) {
-			do_stats = true;
+			cfg.do_stats = true;
+		} else if(!strcmp(argv[i], "-bus_stats")) {
+			cfg.do_stats = true;
+			cfg.bus_stats = true;
 #if VM_TRACE
 		} else if(!strcmp(argv[i], "-trace")) {
-			do_trace = true;
+			cfg.do_trace = true;
+		} else if(!strcmp(argv[i], "-trace_file")) {
+			++i;
+			if(i<argc) {
+				cfg.trace_file = argv[i];
+				cfg.do_trace = true;
+			} else {
+				std::cerr << "-trace_file: missing file name." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-trace_start")) {
+			++i;
+			if(i<argc) {
+				cfg.trace_start = argv[i];
+				cfg.do_trace = true;
+			} else {
+				std::cerr << "-trace_start: missing trigger." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-trace_stop")) {
+			++i;
+			if(i<argc) {
+				cfg.trace_stop = argv[i];
+				cfg.do_trace = true;
+			} else {
+				std::cerr << "-trace_stop: missing trigger." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-trace_window")) {
+			++i;
+			if(i<argc) {
+				cfg.trace_window = strtoull(argv[i], 0, 0);
+				cfg.do_trace = true;
+			} else {
+				std::cerr << "-trace_window: missing number of cycles." << std::endl;
+				return -1;
+			}
 #endif
+		} else if(!strcmp(argv[i], "-itrace")) {
+			++i;
+			if(i<argc) {
+				cfg.itrace_file = argv[i];
+			} else {
+				std::cerr << "-itrace: missing file name." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-bus_json")) {
+			++i;
+			if(i<argc) {
+				cfg.bus_json = argv[i];
+			} else {
+				std::cerr << "-bus_json: missing file name." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-profile")) {
+			++i;
+			if(i<argc) {
+				cfg.profile_elf = argv[i];
+			} else {
+				std::cerr << "-profile: missing file name." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-profile_period")) {
+			++i;
+			if(i<argc && atoi(argv[i]) > 0) {
+				cfg.profile_period = atoi(argv[i]);
+			} else {
+				std::cerr << "-profile_period: missing or invalid period." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-profile_out")) {
+			++i;
+			if(i<argc) {
+				cfg.profile_out = argv[i];
+			} else {
+				std::cerr << "-profile_out: missing prefix." << std::endl;
+				return -1;
+			}
 		} else if(!strcmp(argv[i], "-rom_image")) {
 			++i;
 			if(i<argc) {
-				rom_image = argv[i];
+				cfg.rom_image = argv[i];
 			} else {
 				std::cerr << "-rom_image: missing file name." << std::endl;
 				return -1;
@@ -110,11 +203,151 @@ int main(int argc, char **argv)
 		} else if(!strcmp(argv[i], "-ram_image")) {
 			++i;
 			if(i<argc) {
-				ram_image = argv[i];
+				cfg.ram_image = argv[i];
 			} else {
 				std::cerr << "-ram_image: missing file name." << std::endl;
 				return -1;
 			}
+		} else if(!strcmp(argv[i], "-elf")) {
+			++i;
+			if(i<argc) {
+				cfg.elf_file = argv[i];
+			} else {
+				std::cerr << "-elf: missing file name." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-pin_cpu")) {
+			++i;
+			if(i<argc) {
+				cfg.pin_cpu = atoi(argv[i]);
+			} else {
+				std::cerr << "-pin_cpu: missing CPU number." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-max_cycles")) {
+			++i;
+			if(i<argc) {
+				cfg.max_cycles = strtoull(argv[i], 0, 0);
+			} else {
+				std::cerr << "-max_cycles: missing number of cycles." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-max_wall_seconds")) {
+			++i;
+			if(i<argc) {
+				cfg.max_wall = atof(argv[i]);
+			} else {
+				std::cerr << "-max_wall_seconds: missing time." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-stuck_cycles")) {
+			++i;
+			if(i<argc) {
+				cfg.stuck_cycles = strtoull(argv[i], 0, 0);
+			} else {
+				std::cerr << "-stuck_cycles: missing number of cycles." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-pc_history")) {
+			++i;
+			if(i<argc) {
+				cfg.pc_history = atoi(argv[i]);
+			} else {
+				std::cerr << "-pc_history: missing number of PCs." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-uart")) {
+			++i;
+			if(i<argc) {
+				cfg.uart_spec = argv[i];
+			} else {
+				std::cerr << "-uart: missing endpoint." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-batch")) {
+			++i;
+			if(i<argc) {
+				bc.manifest = argv[i];
+			} else {
+				std::cerr << "-batch: missing manifest file name." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-jobs")) {
+			++i;
+			if(i<argc) {
+				bc.jobs = atoi(argv[i]);
+			} else {
+				std::cerr << "-jobs: missing number of jobs." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-batch_dir")) {
+			++i;
+			if(i<argc) {
+				bc.out_dir = argv[i];
+			} else {
+				std::cerr << "-batch_dir: missing directory name." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-json")) {
+			++i;
+			if(i<argc) {
+				bc.json_file = argv[i];
+			} else {
+				std::cerr << "-json: missing file name." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-junit")) {
+			++i;
+			if(i<argc) {
+				bc.junit_file = argv[i];
+			} else {
+				std::cerr << "-junit: missing file name." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-uart_lf2cr")) {
+			cfg.uart_lf2cr = true;
+		} else if(!strcmp(argv[i], "-uart_nostop")) {
+			cfg.uart_nostop = true;
+#if defined(UPUART_DPI)
+		} else if(!strcmp(argv[i], "-uart_fast")) {
+			cfg.uart_fast = true;
+		} else if(!strcmp(argv[i], "-uart_baud")) {
+			++i;
+			if(i<argc) {
+				cfg.uart_baud = atol(argv[i]);
+			} else {
+				std::cerr << "-uart_baud: missing baud rate." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-ff")) {
+			cfg.do_ff = true;
+#endif
+#if defined(SIM_SAVABLE)
+		} else if(!strcmp(argv[i], "-save_checkpoint")) {
+			++i;
+			if(i<argc) {
+				cfg.save_file = argv[i];
+			} else {
+				std::cerr << "-save_checkpoint: missing file name." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-at")) {
+			++i;
+			if(i<argc) {
+				cfg.save_at = strtoull(argv[i], 0, 0);
+			} else {
+				std::cerr << "-at: missing cycle." << std::endl;
+				return -1;
+			}
+		} else if(!strcmp(argv[i], "-restore_checkpoint")) {
+			++i;
+			if(i<argc) {
+				cfg.restore_file = argv[i];
+			} else {
+				std::cerr << "-restore_checkpoint: missing file name." << std::endl;
+				return -1;
+			}
+#endif
 		} else {
 			std::cerr << "Wrong argument: " << argv[i] << std::endl;
 			return -1;
@@ -122,85 +355,10 @@ int main(int argc, char **argv)
 	}
 
 
-	// Prepare command line arguments for Verilator
-	std::string v_rom_arg = (rom_image ? std::string("+ROM_FILE=") +
-		rom_image : std::string(""));
-	std::string v_ram_arg = (ram_image ? std::string("+RAM_FILE=") +
-		ram_image : std::string(""));
-	const char* v_argv[] = { "", v_rom_arg.c_str(), v_ram_arg.c_str() };
-	Verilated::commandArgs(3, v_argv);	// Pass args to Verilator
-
-
-	// Create top-level instance
-	system_top<Vvl_soc_top> top;
-
-
-	// Print simulation summary
-	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
-	std::cout << "Simulation parameters:" << std::endl;
-#if VM_TRACE
-	std::cout << "> Tracing: " << (do_trace ? "ON" : "OFF") << std::endl;
-#endif
-	std::cout << "> Statistics: " << (do_stats ? "ON" : "OFF") << std::endl;
-	std::cout << "> ROM image: " << (rom_image ? rom_image : "N/A") << std::endl;
-	std::cout << "> RAM image: " << (ram_image ? ram_image : "N/A") << std::endl;
-	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
-	std::cout << std::endl;
-
-
-#if VM_TRACE
-	VerilatedVcdC* tfp = 0;
-	if(do_trace) {
-		Verilated::traceEverOn(true);	// Enable traces
-		tfp = new VerilatedVcdC;
-		top->trace (tfp, 99);		// Trace 99 levels of hierarchy
-		tfp->open ("vlt_dump.vcd");	// Open the dump file
-	}
-#endif
-
-
-	// Set initial clock and reset
-	top->nrst = 0;
-	top->clk = 1;
-
-
-	// Main simulation loop
-	while (!Verilated::gotFinish()) {
-		top->nrst = (main_time > 2*rst_cycles ? 1 : 0); // De-assert reset
-		top->clk = !top->clk;				// Toggle clock
-		top->eval();					// Evaluate model
-#if VM_TRACE
-		if (tfp) tfp->dump (main_time);			// Dump waveforms
-#endif
-
-#if !defined(_NO_FFLUSH)
-		fflush(stdout);					// Flush stdout
-#endif
-
-		++main_time;					// Time passes...
-	}
-
-
-	top->final();	// Done simulating
-
-
-#if VM_TRACE
-	if (tfp) tfp->close();
-#endif
-
-
-	// Print statistics
-	if(do_stats) {
-		std::cout << std::endl;
-		std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
-		std::cout << "Reset cycles:  " << rst_cycles << std::endl;
-		std::cout << "Active cycles: " << main_time / 2 - rst_cycles << std::endl;
-		std::cout << std::setfill('-') << std::setw(80) << "-" << std::endl;
-		std::cout << "Total cycles:  " << main_time / 2 << std::endl;
-		std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
-		std::cout << std::endl;
-	}
-
+	// Regression run
+	if(bc.manifest)
+		return run_batch(bc, cfg);
 
-	return 0;
+	// Single simulation run. Exit code tells how it ended.
+	return simulate(cfg, res);
 }
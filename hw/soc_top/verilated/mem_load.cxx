@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Direct loading of executables into model memory arrays.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <svdpi.h>
+#include "Vvl_soc_top__Dpi.h"	// DPI prototypes
+#include "elf_file.h"
+#include "mem_load.h"
+
+
+// Reset vector address
+static const vluint32_t reset_vector = 0x00000000;
+
+
+// Write word to memory
+static bool mem_write(vluint32_t addr, vluint32_t data)
+{
+	if(vl_mem_write((int)addr, (int)data) < 0) {
+		std::cerr << "ELF: address 0x" << std::hex << std::setw(8)
+			<< std::setfill('0') << addr << std::dec
+			<< " is outside of memory" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+bool load_elf(const char *file, bool rom_image)
+{
+	elf_file elf;
+	bool vector_used = false;
+
+	if(!elf.read(file))
+		return false;
+
+	svSetScope(svGetScopeFromName("TOP.vl_soc_top"));
+
+	for(size_t i = 0; i < elf.segments().size(); ++i) {
+		const elf_file::segment &seg = elf.segments()[i];
+
+		if(seg.paddr & 3) {
+			std::cerr << "ELF: " << file << ": unaligned segment" << std::endl;
+			return false;
+		}
+
+		// Write file image and zero the rest, word by word (little-endian)
+		for(vluint32_t off = 0; off < seg.memsz; off += 4) {
+			vluint32_t w = 0;
+			for(unsigned b = 0; b < 4; ++b) {
+				if(off + b < seg.data.size())
+					w |= (vluint32_t)seg.data[off + b] << (8 * b);
+			}
+			if(!mem_write(seg.paddr + off, w))
+				return false;
+		}
+
+		if(seg.paddr <= reset_vector && reset_vector < seg.paddr + seg.memsz)
+			vector_used = true;
+	}
+
+	// Jump to entry point from reset vector
+	if(elf.entry() != reset_vector && !vector_used && !rom_image) {
+		vluint32_t e = elf.entry();
+		if(!mem_write(reset_vector + 0, 0x3C080000 | (e >> 16)) ||	// lui t0, %hi
+			!mem_write(reset_vector + 4, 0x35080000 | (e & 0xFFFF)) ||	// ori t0, t0, %lo
+			!mem_write(reset_vector + 8, 0x01000008) ||		// jr t0
+			!mem_write(reset_vector + 12, 0x00000000))		// nop
+			return false;
+	}
+
+	return true;
+}
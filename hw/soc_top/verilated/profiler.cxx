@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * PC-sampling profiler.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "profiler.h"
+
+
+// Max tracked call depth
+static const size_t max_depth = 256;
+
+
+profiler::profiler()
+	: m_period(0), m_next(0), m_samples(0), m_pc(0), m_sym_lo(0),
+	m_sym_hi(0), m_sym(-1), m_nodes(1, node(-1, -1)), m_stack(0),
+	m_depth(0), m_leaf(-1), m_leaf_stack(-1), m_leaf_sym(-1), m_lost(0),
+	m_pending(0), m_pending_call(false), m_pending_sym(-1)
+{
+}
+
+
+bool profiler::open(const char *elf, unsigned period)
+{
+	if(!m_elf.read(elf))
+		return false;
+
+	if(m_elf.symbols().empty()) {
+		std::cerr << "Profiler: no symbols in " << elf << std::endl;
+		return false;
+	}
+
+	m_period = (period ? period : 1);
+	m_flat.resize(m_elf.symbols().size() + 1);
+
+	return true;
+}
+
+
+int profiler::lookup(vluint32_t addr)
+{
+	// Consecutive samples mostly hit the same function
+	if(addr - m_sym_lo < m_sym_hi - m_sym_lo)
+		return m_sym;
+
+	m_sym = m_elf.find_symbol(addr);
+	if(m_sym >= 0) {
+		m_sym_lo = m_elf.symbols()[m_sym].addr;
+		m_sym_hi = m_sym_lo + m_elf.symbols()[m_sym].size;
+	} else {
+		m_sym_lo = 0;
+		m_sym_hi = 0;
+	}
+
+	return m_sym;
+}
+
+
+int profiler::child(int parent, int sym)
+{
+	vluint64_t key = ((vluint64_t)parent << 32) | (vluint32_t)sym;
+	std::map<vluint64_t, int>::iterator it = m_children.lower_bound(key);
+
+	if(it != m_children.end() && it->first == key)
+		return it->second;
+
+	m_nodes.push_back(node(parent, sym));
+	m_children.insert(it, std::make_pair(key, (int)m_nodes.size() - 1));
+
+	return m_nodes.size() - 1;
+}
+
+
+void profiler::track(vluint32_t pc, vluint32_t instr)
+{
+	unsigned op = instr >> 26;
+	unsigned funct = instr & 0x3F;
+	unsigned rs = (instr >> 21) & 0x1F;
+	unsigned rt = (instr >> 16) & 0x1F;
+
+	bool call = (op == 0x03 ||			// jal
+		(op == 0x00 && funct == 0x09) ||	// jalr
+		(op == 0x01 && (rt == 0x10 || rt == 0x11)));	// bltzal, bgezal
+	bool ret = (op == 0x00 && funct == 0x08 && rs == 31);	// jr $ra
+
+	// Apply call or return once delay slot is fetched
+	if(m_pending && !--m_pending) {
+		if(m_pending_call) {
+			if(m_depth < max_depth) {
+				m_stack = child(m_stack, m_pending_sym);
+				++m_depth;
+			} else
+				++m_lost;
+		} else {
+			if(m_lost)
+				--m_lost;
+			else if(m_depth) {
+				m_stack = m_nodes[m_stack].parent;
+				--m_depth;
+			}
+		}
+	}
+
+	if(call || ret) {
+		m_pending = 2;
+		m_pending_call = call;
+		m_pending_sym = (call ? m_elf.find_symbol(pc) : -1);
+	}
+}
+
+
+void profiler::observe(vluint64_t cycle, const cpu_probe &p)
+{
+	if(p.ifetch) {
+		m_pc = p.iaddr;
+		track(p.iaddr, p.idata);
+	}
+
+	if(cycle < m_next)
+		return;
+	m_next = cycle + m_period;
+	++m_samples;
+
+	int kind;
+	if(p.ifetch)
+		kind = EXEC;
+	else if(p.dreq && !p.dread && !p.dwrite)
+		kind = DSTALL;
+	else if(p.ireq)
+		kind = ISTALL;
+	else
+		kind = IDLE;
+
+	int sym = lookup(m_pc);
+	counts &c = m_flat[sym >= 0 ? sym : m_flat.size() - 1];
+	++c.n[kind];
+	++c.total;
+
+	// Folded stack: functions of call sites from outermost, then leaf
+	if(m_stack != m_leaf_stack || sym != m_leaf_sym) {
+		m_leaf = child(m_stack, sym);
+		m_leaf_stack = m_stack;
+		m_leaf_sym = sym;
+	}
+	++m_nodes[m_leaf].samples;
+}
+
+
+std::string profiler::name(int sym) const
+{
+	return (sym >= 0 ? m_elf.symbols()[sym].name : std::string("[unknown]"));
+}
+
+
+bool profiler::write(const char *prefix) const
+{
+	std::string flat_name = std::string(prefix) + ".txt";
+	std::string folded_name = std::string(prefix) + ".folded";
+	std::ofstream flat(flat_name.c_str());
+	std::ofstream folded(folded_name.c_str());
+
+	if(!flat || !folded) {
+		std::cerr << "Profiler: cannot create " << prefix << ".*" << std::endl;
+		return false;
+	}
+
+	// Flat profile sorted by number of samples
+	std::vector<std::pair<vluint64_t, int> > order;
+	for(size_t i = 0; i < m_flat.size(); ++i) {
+		if(m_flat[i].total)
+			order.push_back(std::make_pair(m_flat[i].total,
+				i + 1 < m_flat.size() ? (int)i : -1));
+	}
+	std::sort(order.rbegin(), order.rend());
+
+	flat << "Flat profile: " << m_samples << " samples, one every "
+		<< m_period << " cycle(s)" << std::endl << std::endl;
+	flat << "  %time     samples        exec     i-stall     d-stall"
+		"        idle  function" << std::endl;
+	for(size_t i = 0; i < order.size(); ++i) {
+		int sym = order[i].second;
+		const counts &c = m_flat[sym >= 0 ? sym : m_flat.size() - 1];
+		flat << std::fixed << std::setprecision(2) << std::setw(7)
+			<< 100.0 * c.total / m_samples << std::setw(12) << c.total;
+		for(int k = 0; k < NKINDS; ++k)
+			flat << std::setw(12) << c.n[k];
+		flat << "  " << name(sym) << std::endl;
+	}
+
+	// Folded stacks
+	std::vector<int> path;
+	for(size_t i = 0; i < m_nodes.size(); ++i) {
+		if(!m_nodes[i].samples)
+			continue;
+		path.clear();
+		for(int n = i; n > 0; n = m_nodes[n].parent)
+			path.push_back(m_nodes[n].sym);
+		for(size_t j = path.size(); j > 0; --j)
+			folded << (j < path.size() ? ";" : "") << name(path[j - 1]);
+		folded << " " << m_nodes[i].samples << std::endl;
+	}
+
+	return flat.good() && folded.good();
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * PC-sampling profiler.
+ *
+ * Every N cycles the function of the last fetched instruction is charged
+ * with one sample of one of the kinds:
+ *   exec    - instruction fetch completed (pipeline advances);
+ *   i-stall - fetch requested but not completed;
+ *   d-stall - data access requested but not completed;
+ *   idle    - no bus requests (pipeline stalled or CPU waits for interrupt).
+ * Call stack is tracked on fetched instructions: jal, jalr, bltzal and
+ * bgezal push the call site, jr $ra pops it; both take effect after the
+ * delay slot. Distinct stacks are kept in a tree of (parent, function)
+ * nodes, so the current stack is a node index and each sample increments
+ * one counter. Results are written as flat profile (<prefix>.txt) and
+ * folded stacks (<prefix>.folded) which can be passed to flamegraph.pl.
+ */
+
+#ifndef _VL_PROFILER_H_
+#define _VL_PROFILER_H_
+
+#include <verilated.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "cpu_probe.h"
+#include "elf_file.h"
+
+
+// Profiler
+class profiler {
+public:
+	profiler();
+
+	// Load symbols and set sampling period in cycles.
+	// Returns false on failure.
+	bool open(const char *elf, unsigned period);
+
+	// Observe CPU buses. Called once per cycle on rising edge.
+	void observe(vluint64_t cycle, const cpu_probe &p);
+
+	// Write profile files. Returns false on failure.
+	bool write(const char *prefix) const;
+
+	// Returns true if profiling is active
+	bool is_open() const { return m_period != 0; }
+
+	// Number of samples
+	vluint64_t samples() const { return m_samples; }
+
+private:
+	// Sample kinds
+	enum { EXEC, ISTALL, DSTALL, IDLE, NKINDS };
+
+	// Per-function counters
+	struct counts {
+		vluint64_t n[NKINDS];
+		vluint64_t total;
+		counts() : total(0) { for(int i = 0; i < NKINDS; ++i) n[i] = 0; }
+	};
+
+	// Lookup symbol index by address (-1 - unknown)
+	int lookup(vluint32_t addr);
+
+	// Track calls and returns
+	void track(vluint32_t pc, vluint32_t instr);
+
+	// Stack node for function called from given stack node
+	int child(int parent, int sym);
+
+	// Function name by symbol index
+	std::string name(int sym) const;
+
+	elf_file m_elf;
+	unsigned m_period;
+	vluint64_t m_next;			// Next sample cycle
+	vluint64_t m_samples;
+	vluint32_t m_pc;			// Last fetched PC
+	vluint32_t m_sym_lo;			// Cached symbol range
+	vluint32_t m_sym_hi;
+	int m_sym;				// Cached symbol index
+	std::vector<counts> m_flat;		// Per symbol, last is unknown
+
+	// Stack tree node. Node 0 is empty stack.
+	struct node {
+		int parent;			// Caller node
+		int sym;			// Function symbol index
+		vluint64_t samples;		// Samples with this stack
+		node(int p, int s) : parent(p), sym(s), samples(0) {}
+	};
+
+	std::vector<node> m_nodes;		// Stack tree
+	std::map<vluint64_t, int> m_children;	// (parent, sym) to node
+	int m_stack;				// Node of call sites stack
+	size_t m_depth;				// Call sites stack depth
+	int m_leaf;				// Cached sample node
+	int m_leaf_stack;			// Stack and symbol of cached node
+	int m_leaf_sym;
+	unsigned m_lost;			// Calls not pushed (stack full)
+	unsigned m_pending;			// Fetches until call/return applies
+	bool m_pending_call;			// Pending call (or return)
+	int m_pending_sym;			// Function of pending call site
+};
+
+
+#endif /* _VL_PROFILER_H_ */
@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Simulation run of the Verilated system model.
+ */
+
+#include <stdio.h>		// For fflush(stdout)
+#include <stdlib.h>
+#include <signal.h>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <verilated.h>		// Defines common routines
+#include <svdpi.h>
+#include "Vvl_soc_top.h"	// From Verilating "vl_soc_top.v"
+#include "Vvl_soc_top__Dpi.h"	// DPI prototypes
+#include "sim.h"		// Simulation run
+#include "uart_host.h"		// Host UART endpoint
+#include "uart_xactor.h"	// UART transactor
+#include "uart_dpi.h"		// UART fast path
+#include "cpu_probe.h"		// CPU buses probe
+#include "fast_fwd.h"		// Idle-cycle fast-forward
+#include "checkpoint.h"		// Simulation checkpoints
+#include "sim_threads.h"	// Host threads
+#include "hang_det.h"		// CPU hang detector
+#include "mem_load.h"		// ELF loader
+#include "itrace.h"		// Instruction trace
+#include "wave_trace.h"		// Waveform capture
+#include "profiler.h"		// PC-sampling profiler
+#include "bus_mon.h"		// Bus monitor
+
+
+vluint64_t main_time = 0;	// Current simulation time
+static const int rst_cycles = 10;	// Reset cycles
+static const unsigned sys_freq = 50000000;	// System frequency (see soc_info.vh)
+static const vluint64_t ff_max_skip = 1000000;	// Max cycles skipped at once
+static const int perf_ncnt = 12;	// soc_control performance counters
+static const unsigned wall_check_mask = 0xFFF;	// Wall time check interval
+
+
+// Set by SIGINT/SIGTERM to stop simulation gracefully
+static volatile sig_atomic_t stop_req = 0;
+
+static void stop_handler(int)
+{
+	stop_req = 1;
+}
+
+
+// Called by $time in Verilog
+double sc_time_stamp()
+{
+	return main_time;
+}
+
+
+#if defined(UPUART_DPI)
+// Keeps soc_control performance counters consistent over skipped cycles.
+// Counters change by the same amount every period of a quiescent loop, so
+// the change over one period is measured before the jump and multiplied.
+class perf_sync {
+	vluint64_t m_start;		// Measurement start cycle
+	vluint64_t m_period;		// Measured period (0 - not measuring)
+	vluint64_t m_cnt[perf_ncnt];	// Counters at measurement start
+
+	void read(vluint64_t *cnt) const {
+		for(int i = 0; i < perf_ncnt; ++i)
+			cnt[i] = (vluint64_t)vl_perf_read(i);
+	}
+public:
+	perf_sync() : m_start(0), m_period(0) {}
+
+	// Returns true when a full period is measured and skip can be done
+	bool ready(vluint64_t cycle, vluint64_t period) {
+		if(period != m_period) {
+			m_start = cycle;
+			m_period = period;
+			read(m_cnt);
+			return false;
+		}
+		return cycle - m_start >= period;
+	}
+
+	// Cancel measurement
+	void reset() { m_period = 0; }
+
+	// Advance counters by n cycles (multiple of period)
+	void skip(vluint64_t n) {
+		vluint64_t cnt[perf_ncnt];
+		read(cnt);
+		for(int i = 0; i < perf_ncnt; ++i)
+			vl_perf_add(i, (long long)((cnt[i] - m_cnt[i]) * (n / m_period)));
+		m_period = 0;
+	}
+};
+#endif
+
+
+// Top-level wrapper
+template<class Top>
+class system_top {
+	Top *m_top;
+public:
+	system_top() : m_top(new Top) {}
+	~system_top() { delete m_top; }
+	Top* operator->() { return m_top; }
+	Top& operator*() { return *m_top; }
+};
+
+
+// Run simulation
+int simulate(const sim_config &cfg, sim_result &res)
+{
+#if defined(UPUART_DPI)
+	bool do_ff = cfg.do_ff;
+#endif
+#if defined(SIM_SAVABLE)
+	const char *save_file = cfg.save_file;
+#endif
+
+	res.status = SIM_ERROR;
+	res.cycles = 0;
+	res.wall = 0;
+
+	// Prepare command line arguments for Verilator
+	std::string v_rom_arg = (cfg.rom_image ? std::string("+ROM_FILE=") +
+		cfg.rom_image : std::string(""));
+	std::string v_ram_arg = (cfg.ram_image ? std::string("+RAM_FILE=") +
+		cfg.ram_image : std::string(""));
+	const char* v_argv[] = { "", v_rom_arg.c_str(), v_ram_arg.c_str() };
+	Verilated::commandArgs(3, v_argv);	// Pass args to Verilator
+
+
+	// Open host UART endpoint
+	uart_host uart;
+	if(!uart.open(cfg.uart_spec))
+		return SIM_ERROR;
+	uart.set_lf2cr(cfg.uart_lf2cr);
+
+	// UART transactor. Byte 0xFF from model stops simulation.
+	uart_xactor uart_xa(uart);
+	uart_xa.set_stop_byte(cfg.uart_nostop ? -1 : 0xFF);
+
+	// UART fast path
+	uart_dpi uart_fp(uart, main_time);
+	uart_fp.set_stop_byte(cfg.uart_nostop ? -1 : 0xFF);
+#if defined(UPUART_DPI)
+	if(cfg.uart_fast)
+		uart_fp.enable();
+	if(cfg.uart_baud >= 0)
+		uart_fp.set_baud(sys_freq, cfg.uart_baud);
+	// Fast-forward needs fast path to know next UART event
+	do_ff = do_ff && uart_fp.enabled();
+# if VM_TRACE
+	do_ff = do_ff && !cfg.do_trace;
+# endif
+	do_ff = do_ff && !cfg.profile_elf;	// Skipped cycles are not sampled
+#endif
+
+	// Idle-cycle fast-forward
+	fast_fwd ff;
+#if defined(UPUART_DPI)
+	perf_sync ff_perf;
+#endif
+
+	// Instruction trace
+	itrace_writer itrace;
+	if(cfg.itrace_file && !itrace.open(cfg.itrace_file))
+		return SIM_ERROR;
+
+	// Profiler
+	profiler prof;
+	if(cfg.profile_elf && !prof.open(cfg.profile_elf, cfg.profile_period))
+		return SIM_ERROR;
+
+	// Bus monitor
+	bus_monitor bus;
+	bool do_bus = (cfg.bus_stats || cfg.bus_json);
+
+	// Hang detection. Fetched PCs are tracked whenever a watchdog is
+	// armed to be dumped on abnormal termination.
+	hang_detector hang(cfg.stuck_cycles, cfg.pc_history);
+	bool do_probe = (cfg.stuck_cycles || cfg.max_cycles || cfg.max_wall > 0 ||
+		cfg.itrace_file || cfg.profile_elf);
+#if defined(UPUART_DPI)
+	do_probe = do_probe || do_ff;
+#endif
+
+#if VM_TRACE
+	// Waveform capture triggers
+	wave_trigger trace_start;
+	wave_trigger trace_stop;
+	if(cfg.trace_start && !trace_start.parse(cfg.trace_start)) {
+		std::cerr << "Invalid trace start trigger: " << cfg.trace_start << std::endl;
+		return SIM_ERROR;
+	}
+	if(cfg.trace_stop && !trace_stop.parse(cfg.trace_stop)) {
+		std::cerr << "Invalid trace stop trigger: " << cfg.trace_stop << std::endl;
+		return SIM_ERROR;
+	}
+	if(cfg.do_trace)
+		do_probe = do_probe || trace_start.needs_probe() || trace_stop.needs_probe();
+#endif
+
+
+	// Create top-level instance
+	system_top<Vvl_soc_top> top;
+
+	// Pin model threads
+	int nthreads = 0;
+	if(cfg.pin_cpu >= 0 && (nthreads = pin_threads(cfg.pin_cpu)) < 0)
+		return SIM_ERROR;
+
+
+	// Print simulation summary
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << "Simulation parameters:" << std::endl;
+#if VM_TRACE
+	std::cout << "> Tracing: " << (cfg.do_trace ? "ON" : "OFF") << std::endl;
+	if(cfg.do_trace) {
+		if(cfg.trace_start)
+			std::cout << "> Trace start: " << cfg.trace_start << std::endl;
+		if(cfg.trace_stop)
+			std::cout << "> Trace stop: " << cfg.trace_stop << std::endl;
+		if(cfg.trace_window)
+			std::cout << "> Trace window: " << cfg.trace_window << " cycles" << std::endl;
+	}
+#endif
+	std::cout << "> Statistics: " << (cfg.do_stats ? "ON" : "OFF") << std::endl;
+	std::cout << "> Bus monitor: " << (do_bus ? "ON" : "OFF") << std::endl;
+	std::cout << "> ROM image: " << (cfg.rom_image ? cfg.rom_image : "N/A") << std::endl;
+	std::cout << "> RAM image: " << (cfg.ram_image ? cfg.ram_image : "N/A") << std::endl;
+	if(cfg.elf_file)
+		std::cout << "> ELF file: " << cfg.elf_file << std::endl;
+	if(cfg.profile_elf)
+		std::cout << "> Profile: " << cfg.profile_elf << ", every "
+			<< cfg.profile_period << " cycle(s)" << std::endl;
+	if(nthreads)
+		std::cout << "> Threads: " << nthreads << " pinned to CPU "
+			<< cfg.pin_cpu << "-" << cfg.pin_cpu + nthreads - 1 << std::endl;
+	std::cout << "> UART: " << uart.name()
+		<< (uart_fp.enabled() ? " (fast)" : "") << std::endl;
+#if defined(UPUART_DPI)
+	std::cout << "> Fast-forward: " << (do_ff ? "ON" : "OFF") << std::endl;
+#endif
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << std::endl;
+
+
+#if VM_TRACE
+	wave_trace *wave = 0;
+	if(cfg.do_trace) {
+		wave = new wave_trace(cfg.trace_file, trace_start, trace_stop,
+			cfg.trace_window);
+		wave->attach(*top);
+	}
+#endif
+
+
+	// Set initial clock and reset
+	top->nrst = 0;
+	top->clk = 1;
+	top->CTS = 0;
+	top->RxD = 1;
+
+
+	// Load ELF file after memory initialization done by initial blocks
+	if(cfg.elf_file && !cfg.restore_file) {
+		top->eval();
+		if(!load_elf(cfg.elf_file, cfg.rom_image != 0))
+			return SIM_ERROR;
+	}
+
+
+#if defined(SIM_SAVABLE)
+	// Harness state for checkpoints
+	sim_state st;
+	st.time = &main_time;
+	st.top = &*top;
+	st.host = &uart;
+	st.xactor = &uart_xa;
+	st.dpi = &uart_fp;
+
+	// Resume from checkpoint. Model pins are restored as well.
+	if(cfg.restore_file) {
+		if(!checkpoint_restore(cfg.restore_file, st))
+			return SIM_ERROR;
+		std::cout << "Restored checkpoint " << cfg.restore_file << " at cycle "
+			<< main_time / 2 << std::endl;
+	}
+#endif
+
+
+#if defined(UPUART_DPI)
+	// Performance counters are accessed on fast-forward
+	if(do_ff)
+		svSetScope(svGetScopeFromName("TOP.vl_soc_top"));
+#endif
+
+
+	// Stop gracefully on interrupt to print statistics
+	signal(SIGINT, stop_handler);
+	signal(SIGTERM, stop_handler);
+
+	vluint64_t start_time = main_time;
+	double start_wall = wall_time();
+	int status = SIM_FINISHED;
+
+
+	// Main simulation loop
+	while (!Verilated::gotFinish() && !stop_req) {
+		// Stop when cycle budget is exhausted
+		if(cfg.max_cycles && main_time >= 2*cfg.max_cycles) {
+			status = SIM_BUDGET;
+			break;
+		}
+		// Check wall time limit from time to time
+		if(cfg.max_wall > 0 && !(main_time & wall_check_mask) &&
+			wall_time() - start_wall >= cfg.max_wall) {
+			status = SIM_WALL_LIMIT;
+			break;
+		}
+#if defined(SIM_SAVABLE)
+		// Save checkpoint between rising and falling edges
+		if(save_file && main_time >= 2*cfg.save_at) {
+			if(!checkpoint_save(save_file, st))
+				return SIM_ERROR;
+			std::cout << "Saved checkpoint " << save_file << " at cycle "
+				<< main_time / 2 << std::endl;
+			save_file = 0;
+		}
+#endif
+		top->nrst = (main_time > 2*rst_cycles ? 1 : 0); // De-assert reset
+		top->clk = !top->clk;				// Toggle clock
+		top->eval();					// Evaluate model
+
+		// Exchange UART data on rising edge
+		if(top->clk && !uart_fp.enabled()) {
+			top->RxD = uart_xa.clock(top->TxD, top->RTS, top->UART_DIV);
+			if(uart_xa.stopped())
+				Verilated::gotFinish(true);
+		} else if(uart_fp.stopped()) {
+			Verilated::gotFinish(true);
+		}
+		// Observe CPU buses
+		cpu_probe probe;
+		if(do_probe && top->clk && main_time > 2*rst_cycles) {
+			probe.sample(top);
+			if(itrace.is_open()) {
+				if(probe.ifetch)
+					itrace.fetch(main_time / 2, probe.iaddr, probe.idata);
+				if(probe.dread || probe.dwrite)
+					itrace.data(main_time / 2, probe.daddr, probe.dread ?
+						probe.drdata : probe.dwdata, probe.dben,
+						probe.dwrite);
+			}
+			if(prof.is_open())
+				prof.observe(main_time / 2, probe);
+			hang.observe(main_time / 2, probe);
+			if(hang.stuck()) {
+				status = SIM_STUCK;
+				break;
+			}
+		}
+		// Observe fabric ports
+		if(do_bus && top->clk && main_time > 2*rst_cycles) {
+			bus_probe bp;
+			bp.sample(top);
+			bus.observe(main_time / 2, bp);
+		}
+#if defined(UPUART_DPI)
+		// Skip idle cycles up to next UART event
+		if(do_ff && top->clk && main_time > 2*rst_cycles) {
+			ff.observe(main_time / 2, probe);
+			vluint64_t period = ff.period();
+			vluint64_t now = main_time / 2;
+			vluint64_t next = uart_fp.next_event();
+			if(cfg.max_cycles && next > cfg.max_cycles)
+				next = cfg.max_cycles;
+			if(period && next > now + period) {
+				// Run one more period to measure counters
+				if(ff_perf.ready(now, period)) {
+					vluint64_t n = next - now - 1;
+					if(n > ff_max_skip)
+						n = ff_max_skip;
+					n -= n % period;
+					if(n) {
+						main_time += 2*n;
+						ff.skip(n);
+						ff_perf.skip(n);
+					} else
+						ff_perf.reset();
+				}
+			} else
+				ff_perf.reset();
+		}
+#endif
+#if VM_TRACE
+		if (wave) {
+			if (top->clk)
+				wave->cycle(main_time / 2, probe);	// Check triggers
+			wave->dump (main_time);			// Dump waveforms
+		}
+#endif
+
+#if !defined(_NO_FFLUSH)
+		fflush(stdout);					// Flush stdout
+#endif
+
+		++main_time;					// Time passes...
+	}
+
+
+	double wall = wall_time() - start_wall;
+
+	if(status == SIM_FINISHED && stop_req)
+		status = SIM_INTERRUPTED;
+	res.status = status;
+	res.cycles = main_time / 2;
+	res.wall = wall;
+	std::vector<sim_thread> threads;
+	thread_times(threads);
+
+	top->final();	// Done simulating
+	uart.close();
+	itrace.close();
+	if(cfg.bus_json)
+		bus.write_json(cfg.bus_json);
+	if(prof.is_open() && prof.write(cfg.profile_out))
+		std::cout << "Profile written to " << cfg.profile_out << ".txt and "
+			<< cfg.profile_out << ".folded" << std::endl;
+
+
+	// Report abnormal termination
+	if(status == SIM_BUDGET) {
+		std::cerr << std::endl << "Cycle budget of " << cfg.max_cycles
+			<< " cycles exhausted." << std::endl;
+		hang.dump(std::cerr);
+	} else if(status == SIM_WALL_LIMIT) {
+		std::cerr << std::endl << "Wall time limit of " << cfg.max_wall
+			<< " s exceeded at cycle " << main_time / 2 << "." << std::endl;
+		hang.dump(std::cerr);
+	} else if(status == SIM_STUCK) {
+		std::cerr << std::endl << "CPU stuck at 0x" << std::hex
+			<< std::setw(8) << std::setfill('0') << hang.window_lo()
+			<< "-0x" << std::setw(8) << hang.window_hi() << std::dec
+			<< " since cycle " << hang.since() << "." << std::endl;
+		hang.dump(std::cerr);
+	}
+
+
+#if VM_TRACE
+	if (wave) wave->close();
+#endif
+
+
+	// Print statistics
+	if(cfg.do_stats) {
+		std::cout << std::endl;
+		std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+		std::cout << "Reset cycles:  " << rst_cycles << std::endl;
+		std::cout << "Active cycles: " << main_time / 2 - rst_cycles << std::endl;
+		std::cout << std::setfill('-') << std::setw(80) << "-" << std::endl;
+		std::cout << "Total cycles:  " << main_time / 2 << std::endl;
+		std::cout << std::setfill('-') << std::setw(80) << "-" << std::endl;
+		std::cout << "UART RX bytes: " << uart.rx_bytes() << std::endl;
+		std::cout << "UART TX bytes: " << uart.tx_bytes() << std::endl;
+		std::cout << std::setfill('-') << std::setw(80) << "-" << std::endl;
+		if(cfg.bus_stats) {
+			bus.print(std::cout);
+			std::cout << std::setfill('-') << std::setw(80) << "-" << std::endl;
+		}
+		std::cout << "Wall time:     " << std::fixed << std::setprecision(3)
+			<< wall << " s" << std::endl;
+		std::cout << "Cycles/sec:    " << std::setprecision(0)
+			<< (wall > 0 ? (main_time - start_time) / 2 / wall : 0) << std::endl;
+		for(size_t i = 0; threads.size() > 1 && i < threads.size(); ++i) {
+			std::cout << "Thread " << std::setw(2) << std::setfill(' ') << i
+				<< " (" << threads[i].name << "): " << std::setprecision(3)
+				<< threads[i].cpu_ns * 1e-9 << " s" << std::endl;
+		}
+		if(itrace.records()) {
+			std::cout << std::setfill('-') << std::setw(80) << "-" << std::endl;
+			std::cout << "Instr. trace:  " << itrace.records() << " records, "
+				<< itrace.bytes() << " bytes" << std::endl;
+		}
+#if VM_TRACE
+		if(wave && wave->last_cycle()) {
+			std::cout << std::setfill('-') << std::setw(80) << "-" << std::endl;
+			std::cout << "Waveform:      " << wave->name() << ", cycles "
+				<< wave->first_cycle() << "-" << wave->last_cycle() << std::endl;
+		}
+#endif
+		if(ff.jumps()) {
+			std::cout << std::setfill('-') << std::setw(80) << "-" << std::endl;
+			std::cout << "Skipped cycles: " << ff.skipped()
+				<< " (" << ff.jumps() << " jumps)" << std::endl;
+		}
+		std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+		std::cout << std::endl;
+	}
+
+
+#if VM_TRACE
+	delete wave;
+#endif
+
+	return res.status;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Simulation run of the Verilated system model.
+ */
+
+#ifndef _VL_SIM_H_
+#define _VL_SIM_H_
+
+#include <verilated.h>
+
+
+// Simulation time in half-cycles
+extern vluint64_t main_time;
+
+
+// Simulation run parameters
+struct sim_config {
+	bool do_trace;			// Dump waveforms
+	const char *trace_file;		// Waveform file (0 - default)
+	const char *trace_start;	// Capture start trigger (0 - from reset)
+	const char *trace_stop;		// Capture stop trigger (0 - never)
+	vluint64_t trace_window;	// Flight recorder window (0 - off)
+	bool do_stats;			// Print statistics
+	bool bus_stats;			// Monitor bus and print its statistics
+	const char *bus_json;		// Bus statistics JSON file
+	const char *itrace_file;	// Instruction trace file
+	const char *profile_elf;	// ELF with symbols for profiler
+	unsigned profile_period;	// Profiler sampling period in cycles
+	const char *profile_out;	// Profile files prefix
+	const char *rom_image;		// ROM image file
+	const char *ram_image;		// RAM image file
+	const char *elf_file;		// ELF executable to load
+	const char *uart_spec;		// UART host endpoint
+	bool uart_lf2cr;		// Translate LF to CR on UART input
+	bool uart_nostop;		// Do not stop on 0xFF from UART
+	bool uart_fast;			// Byte-level UART fast path
+	long uart_baud;			// Fast path baud rate (-1 - follow divider)
+	bool do_ff;			// Fast-forward idle cycles
+	int pin_cpu;			// First CPU to pin threads to (-1 - none)
+	vluint64_t max_cycles;		// Cycle budget (0 - unlimited)
+	double max_wall;		// Wall time limit in seconds (0 - unlimited)
+	vluint64_t stuck_cycles;	// Hang detection time (0 - off)
+	unsigned pc_history;		// PCs dumped on hang
+	const char *save_file;		// Checkpoint to save
+	vluint64_t save_at;		// Cycle to save checkpoint at
+	const char *restore_file;	// Checkpoint to restore
+
+	sim_config()
+		: do_trace(false), trace_file(0), trace_start(0), trace_stop(0),
+		trace_window(0), do_stats(false), bus_stats(false), bus_json(0), itrace_file(0),
+		profile_elf(0), profile_period(97), profile_out("profile"), rom_image(0), ram_image(0),
+		elf_file(0), uart_spec("stdio"), uart_lf2cr(false), uart_nostop(false),
+		uart_fast(false), uart_baud(-1), do_ff(false), pin_cpu(-1),
+		max_cycles(0), max_wall(0), stuck_cycles(0), pc_history(32),
+		save_file(0), save_at(0), restore_file(0)
+	{}
+};
+
+
+// Simulation run outcome. Values are used as process exit codes.
+enum sim_status {
+	SIM_FINISHED = 0,	// Stop byte received or $finish called
+	SIM_BUDGET = 2,		// Cycle budget exhausted
+	SIM_WALL_LIMIT = 3,	// Wall time limit exceeded
+	SIM_STUCK = 4,		// CPU hang detected
+	SIM_INTERRUPTED = 5,	// Stopped by signal
+	SIM_ERROR = -1		// Setup error
+};
+
+
+// Simulation run results
+struct sim_result {
+	int status;		// One of sim_status
+	vluint64_t cycles;	// Simulated cycles
+	double wall;		// Wall time in seconds
+};
+
+
+// Run simulation. Can be called once per process.
+int simulate(const sim_config &cfg, sim_result &res);
+
+
+#endif /* _VL_SIM_H_ */
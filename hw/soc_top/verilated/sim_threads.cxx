@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Host threads of the model process: CPU pinning and time accounting.
+ */
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE	// For CPU_SET
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include "sim_threads.h"
+
+
+// Get IDs of all threads of the process in creation order
+static bool list_threads(std::vector<int> &tids)
+{
+	DIR *dir = opendir("/proc/self/task");
+	struct dirent *de;
+
+	tids.clear();
+	if(!dir)
+		return false;
+
+	while((de = readdir(dir)) != 0) {
+		if(de->d_name[0] != '.')
+			tids.push_back(atoi(de->d_name));
+	}
+	closedir(dir);
+
+	std::sort(tids.begin(), tids.end());
+
+	return !tids.empty();
+}
+
+
+// Read first line of a file under /proc/self/task/<tid>/
+static std::string read_task_file(int tid, const char *name)
+{
+	char path[64];
+	char buf[256] = "";
+	FILE *f;
+
+	snprintf(path, sizeof(path), "/proc/self/task/%d/%s", tid, name);
+	f = fopen(path, "r");
+	if(!f)
+		return std::string();
+	if(!fgets(buf, sizeof(buf), f))
+		buf[0] = '\0';
+	fclose(f);
+
+	buf[strcspn(buf, "\n")] = '\0';
+
+	return std::string(buf);
+}
+
+
+int pin_threads(int first_cpu)
+{
+	std::vector<int> tids;
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if(!list_threads(tids)) {
+		std::cerr << "Failed to list threads." << std::endl;
+		return -1;
+	}
+
+	if(first_cpu < 0 || first_cpu + (long)tids.size() > ncpus) {
+		std::cerr << "Not enough CPUs to pin " << tids.size()
+			<< " threads starting from CPU " << first_cpu << "." << std::endl;
+		return -1;
+	}
+
+	for(size_t i = 0; i < tids.size(); ++i) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(first_cpu + i, &set);
+		if(sched_setaffinity(tids[i], sizeof(set), &set)) {
+			perror("sched_setaffinity");
+			return -1;
+		}
+	}
+
+	return (int)tids.size();
+}
+
+
+void thread_times(std::vector<sim_thread> &threads)
+{
+	std::vector<int> tids;
+
+	threads.clear();
+	list_threads(tids);
+
+	for(size_t i = 0; i < tids.size(); ++i) {
+		sim_thread t;
+		t.tid = tids[i];
+		t.name = read_task_file(tids[i], "comm");
+		// First field of schedstat is time spent on CPU in ns
+		t.cpu_ns = strtoull(read_task_file(tids[i], "schedstat").c_str(), 0, 10);
+		threads.push_back(t);
+	}
+}
+
+
+double wall_time()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Host threads of the model process: CPU pinning and time accounting.
+ */
+
+#ifndef _VL_SIM_THREADS_H_
+#define _VL_SIM_THREADS_H_
+
+#include <string>
+#include <vector>
+
+
+// Host thread information
+struct sim_thread {
+	int tid;			// Thread ID
+	std::string name;		// Thread name
+	unsigned long long cpu_ns;	// CPU time in nanoseconds
+};
+
+
+// Pin all threads of the process (main thread and Verilator workers)
+// to consecutive CPUs starting from first_cpu. Must be called after the
+// model is created. Returns number of pinned threads or -1 on error.
+int pin_threads(int first_cpu);
+
+// Get CPU time of all threads of the process
+void thread_times(std::vector<sim_thread> &threads);
+
+// Monotonic wall clock time in seconds
+double wall_time();
+
+
+#endif /* _VL_SIM_THREADS_H_ */
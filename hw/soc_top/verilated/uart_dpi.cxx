@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Byte-level UART fast path. Host side of DPI hooks in upuart_top.
+ */
+
+#include "uart_dpi.h"
+#if defined(UPUART_DPI)
+# include "Vvl_soc_top__Dpi.h"	// DPI prototypes
+#endif
+#if defined(SIM_SAVABLE)
+# include <verilated_save.h>
+#endif
+
+
+// Bit time of upuart transmitter in cycles, baud rate generator toggles
+// its output every 8*div+1 cycles (upuart_brgen)
+static inline unsigned tx_bit_cycles(unsigned div)
+{
+	return 16 * div + 2;
+}
+
+// Bits per frame (8N1)
+static const unsigned frame_bits = 10;
+
+// Host poll interval in cycles
+static const unsigned poll_interval = 1024;
+
+// Active instance
+static uart_dpi *dpi_inst = 0;
+
+
+uart_dpi::uart_dpi(uart_host &host, const vluint64_t &time)
+	: m_host(host), m_time(time), m_enabled(false), m_follow(true),
+	m_cycles(0), m_stop_byte(-1), m_stopped(false), m_next_tx(0),
+	m_next_rx(0), m_next_poll(0)
+{
+}
+
+
+uart_dpi::~uart_dpi()
+{
+	if(dpi_inst == this)
+		dpi_inst = 0;
+}
+
+
+void uart_dpi::enable()
+{
+	m_enabled = true;
+	dpi_inst = this;
+}
+
+
+void uart_dpi::set_baud(unsigned sys_freq, unsigned baud)
+{
+	m_follow = false;
+	m_cycles = (baud ? (vluint64_t)sys_freq * frame_bits / baud : 0);
+}
+
+
+vluint64_t uart_dpi::byte_cycles(unsigned div) const
+{
+	return m_follow ? (vluint64_t)frame_bits * tx_bit_cycles(div) : m_cycles;
+}
+
+
+vluint64_t uart_dpi::next_event() const
+{
+	vluint64_t now = cycle();
+	vluint64_t ev = ~(vluint64_t)0;
+
+	if(m_next_tx > now)
+		ev = m_next_tx;
+
+	if(m_host.has_input()) {
+		vluint64_t t = (m_next_rx > now ? m_next_rx : now);
+		if(t < ev) ev = t;
+	} else if(!m_host.eof()) {
+		vluint64_t t = (m_next_poll > now ? m_next_poll : now);
+		if(t < ev) ev = t;
+	}
+
+	return ev;
+}
+
+
+bool uart_dpi::tx_ready(unsigned div)
+{
+	// Real UART does not transmit until divider is programmed
+	if(m_follow && !div)
+		return false;
+
+	if(cycle() < m_next_tx)
+		return false;
+
+	m_next_tx = cycle() + byte_cycles(div);
+
+	return true;
+}
+
+
+void uart_dpi::tx(unsigned char b)
+{
+	if((int)b == m_stop_byte)
+		m_stopped = true;
+	else
+		m_host.put_byte(b);
+}
+
+
+int uart_dpi::rx(unsigned div)
+{
+	int b;
+
+	if((m_follow && !div) || cycle() < m_next_rx)
+		return -1;
+
+	if(!m_host.has_input()) {
+		if(cycle() < m_next_poll)
+			return -1;
+		m_host.poll();
+		m_next_poll = cycle() + poll_interval;
+	}
+
+	b = m_host.get_byte();
+	if(b >= 0)
+		m_next_rx = cycle() + byte_cycles(div);
+
+	return b;
+}
+
+
+#if defined(SIM_SAVABLE)
+
+void uart_dpi::save(VerilatedSerialize &os)
+{
+	os.write(&m_enabled, sizeof(m_enabled));
+	os.write(&m_stopped, sizeof(m_stopped));
+	os.write(&m_next_tx, sizeof(m_next_tx));
+	os.write(&m_next_rx, sizeof(m_next_rx));
+	os.write(&m_next_poll, sizeof(m_next_poll));
+}
+
+
+void uart_dpi::restore(VerilatedDeserialize &is)
+{
+	bool enabled;
+
+	is.read(&enabled, sizeof(enabled));
+	is.read(&m_stopped, sizeof(m_stopped));
+	is.read(&m_next_tx, sizeof(m_next_tx));
+	is.read(&m_next_rx, sizeof(m_next_rx));
+	is.read(&m_next_poll, sizeof(m_next_poll));
+
+	if(enabled)
+		enable();
+}
+
+#endif /* SIM_SAVABLE */
+
+
+#if defined(UPUART_DPI)
+
+/* DPI functions imported by upuart_top */
+
+int upuart_dpi_enabled()
+{
+	return dpi_inst ? 1 : 0;
+}
+
+
+int upuart_dpi_tx_ready(int divider)
+{
+	return dpi_inst && dpi_inst->tx_ready((unsigned)divider) ? 1 : 0;
+}
+
+
+void upuart_dpi_tx(int data)
+{
+	if(dpi_inst)
+		dpi_inst->tx((unsigned char)data);
+}
+
+
+int upuart_dpi_rx(int divider)
+{
+	return dpi_inst ? dpi_inst->rx((unsigned)divider) : -1;
+}
+
+#endif /* UPUART_DPI */
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Byte-level UART fast path. Host side of DPI hooks in upuart_top.
+ */
+
+#ifndef _VL_UART_DPI_H_
+#define _VL_UART_DPI_H_
+
+#include <verilated.h>
+#include "uart_host.h"
+
+class VerilatedSerialize;
+class VerilatedDeserialize;
+
+
+// UART FIFOs access over DPI
+class uart_dpi {
+public:
+	// Time is simulation time in half-cycles (main_time)
+	uart_dpi(uart_host &host, const vluint64_t &time);
+	~uart_dpi();
+
+	// Enable fast path. Must be called before model evaluation starts.
+	void enable();
+
+	// Virtual baud rate. Zero means unlimited.
+	void set_baud(unsigned sys_freq, unsigned baud);
+
+	// Byte which stops simulation when received from model (-1 - none)
+	void set_stop_byte(int b) { m_stop_byte = b; }
+
+	// Returns true if stop byte was received
+	bool stopped() const { return m_stopped; }
+
+	// Returns true if fast path is enabled
+	bool enabled() const { return m_enabled; }
+
+	// Cycle of next possible transfer to/from model
+	vluint64_t next_tx() const { return m_next_tx; }
+	vluint64_t next_rx() const { return m_next_rx; }
+
+	// Cycle of next event which may change model state
+	vluint64_t next_event() const;
+
+	// Checkpoint support (SAVABLE builds only). Fast path
+	// is enabled on restore if it was enabled in saved model.
+	void save(VerilatedSerialize &os);
+	void restore(VerilatedDeserialize &is);
+
+	// DPI entry points
+	bool tx_ready(unsigned div);
+	void tx(unsigned char b);
+	int rx(unsigned div);
+
+private:
+	// Returns number of cycles per byte
+	vluint64_t byte_cycles(unsigned div) const;
+
+	// Current cycle
+	vluint64_t cycle() const { return m_time / 2; }
+
+	uart_host &m_host;
+	const vluint64_t &m_time;
+	bool m_enabled;
+	bool m_follow;		// Follow programmed divider
+	vluint64_t m_cycles;	// Fixed number of cycles per byte
+	int m_stop_byte;
+	bool m_stopped;
+	vluint64_t m_next_tx;	// Next TX cycle
+	vluint64_t m_next_rx;	// Next RX cycle
+	vluint64_t m_next_poll;	// Next host poll cycle
+
+	uart_dpi(const uart_dpi&);
+	uart_dpi& operator=(const uart_dpi&);
+};
+
+
+#endif /* _VL_UART_DPI_H_ */
@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Host side of the model UART: standard I/O, pseudo-terminal or TCP socket.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <iostream>
+#include <sstream>
+#include "uart_host.h"
+#if defined(SIM_SAVABLE)
+# include <verilated_save.h>
+#endif
+
+
+uart_host::uart_host()
+	: m_type(UH_STDIO), m_name("N/A"), m_in_fd(-1), m_out_fd(-1),
+	m_listen_fd(-1), m_slave_fd(-1), m_tty_fd(-1), m_stdin_flags(-1), m_eof(false),
+	m_lf2cr(false), m_rx_bytes(0), m_tx_bytes(0)
+{
+	memset(&m_tty_saved, 0, sizeof(m_tty_saved));
+}
+
+
+uart_host::~uart_host()
+{
+	close();
+}
+
+
+bool uart_host::open(const std::string &spec)
+{
+	if(spec == "stdio") {
+		return open_stdio();
+	} else if(spec == "pty") {
+		return open_pty();
+	} else if(spec.compare(0, 4, "tcp:") == 0) {
+		char *end;
+		unsigned long port = strtoul(spec.c_str() + 4, &end, 0);
+		if(*end || !port || port > 65535) {
+			std::cerr << "UART: invalid TCP port: " << spec << std::endl;
+			return false;
+		}
+		return open_tcp((unsigned)port);
+	} else if(spec.compare(0, 5, "file:") == 0) {
+		std::string::size_type comma = spec.find(',', 5);
+		if(comma == std::string::npos)
+			return open_file(spec.substr(5), "");
+		return open_file(spec.substr(5, comma - 5), spec.substr(comma + 1));
+	}
+
+	std::cerr << "UART: unknown endpoint: " << spec << std::endl;
+	return false;
+}
+
+
+void uart_host::close()
+{
+	flush();
+
+	if(m_tty_fd >= 0) {
+		tcsetattr(m_tty_fd, TCSANOW, &m_tty_saved);
+		m_tty_fd = -1;
+	}
+
+	if(m_type == UH_STDIO) {
+		// Not owned, give stdin back to the shell as it was
+		if(m_in_fd >= 0 && m_stdin_flags >= 0)
+			fcntl(m_in_fd, F_SETFL, m_stdin_flags);
+		m_stdin_flags = -1;
+		m_in_fd = m_out_fd = -1;
+	} else {
+		if(m_in_fd >= 0)
+			::close(m_in_fd);
+		if(m_out_fd >= 0 && m_out_fd != m_in_fd)
+			::close(m_out_fd);
+		m_in_fd = m_out_fd = -1;
+	}
+
+	if(m_slave_fd >= 0) {
+		::close(m_slave_fd);
+		m_slave_fd = -1;
+	}
+
+	if(m_listen_fd >= 0) {
+		::close(m_listen_fd);
+		m_listen_fd = -1;
+	}
+}
+
+
+// Switch terminal to raw mode
+void uart_host::set_raw(int fd)
+{
+	struct termios t;
+
+	if(tcgetattr(fd, &t) < 0)
+		return;
+
+	if(m_tty_fd < 0) {
+		m_tty_saved = t;
+		m_tty_fd = fd;
+	}
+
+	cfmakeraw(&t);
+	if(fd == STDIN_FILENO)
+		t.c_lflag |= ISIG;	// Keep Ctrl+C working on console
+	tcsetattr(fd, TCSANOW, &t);
+}
+
+
+bool uart_host::open_stdio()
+{
+	m_type = UH_STDIO;
+	m_name = "stdio";
+	m_in_fd = STDIN_FILENO;
+	m_out_fd = STDOUT_FILENO;
+
+	if(isatty(m_in_fd))
+		set_raw(m_in_fd);
+
+	m_stdin_flags = fcntl(m_in_fd, F_GETFL);
+	if(m_stdin_flags >= 0)
+		fcntl(m_in_fd, F_SETFL, m_stdin_flags | O_NONBLOCK);
+
+	return true;
+}
+
+
+bool uart_host::open_pty()
+{
+	int fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if(fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0) {
+		std::cerr << "UART: failed to create pseudo-terminal: "
+			<< strerror(errno) << std::endl;
+		if(fd >= 0)
+			::close(fd);
+		return false;
+	}
+
+	m_type = UH_PTY;
+	m_name = std::string("pty ") + ptsname(fd);
+
+	// Keep slave side open so master does not get EIO while no client
+	// is attached. Slave is in raw mode to pass binary data.
+	m_slave_fd = ::open(ptsname(fd), O_RDWR | O_NOCTTY);
+	if(m_slave_fd >= 0) {
+		struct termios t;
+		if(tcgetattr(m_slave_fd, &t) == 0) {
+			cfmakeraw(&t);
+			tcsetattr(m_slave_fd, TCSANOW, &t);
+		}
+	}
+
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	m_in_fd = m_out_fd = fd;
+
+	std::cout << "UART: connect to " << ptsname(fd) << std::endl;
+
+	return true;
+}
+
+
+bool uart_host::open_tcp(unsigned port)
+{
+	struct sockaddr_in sa;
+	int one = 1;
+	int fd;
+
+	m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if(m_listen_fd < 0) {
+		std::cerr << "UART: socket: " << strerror(errno) << std::endl;
+		return false;
+	}
+
+	setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons(port);
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if(bind(m_listen_fd, (struct sockaddr*)&sa, sizeof(sa)) < 0 ||
+		listen(m_listen_fd, 1) < 0) {
+		std::cerr << "UART: bind/listen on port " << port << ": "
+			<< strerror(errno) << std::endl;
+		return false;
+	}
+
+	std::cout << "UART: waiting for connection on 127.0.0.1:" << port
+		<< "..." << std::endl;
+
+	do {
+		fd = accept(m_listen_fd, NULL, NULL);
+	} while(fd < 0 && errno == EINTR);
+
+	if(fd < 0) {
+		std::cerr << "UART: accept: " << strerror(errno) << std::endl;
+		return false;
+	}
+
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	std::ostringstream nm;
+	nm << "tcp:" << port;
+
+	m_type = UH_TCP;
+	m_name = nm.str();
+	m_in_fd = m_out_fd = fd;
+
+	return true;
+}
+
+
+bool uart_host::open_file(const std::string &out, const std::string &in)
+{
+	m_out_fd = ::open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(m_out_fd < 0) {
+		std::cerr << "UART: " << out << ": " << strerror(errno) << std::endl;
+		return false;
+	}
+
+	if(!in.empty()) {
+		m_in_fd = ::open(in.c_str(), O_RDONLY);
+		if(m_in_fd < 0) {
+			std::cerr << "UART: " << in << ": " << strerror(errno) << std::endl;
+			::close(m_out_fd);
+			m_out_fd = -1;
+			return false;
+		}
+	} else {
+		m_eof = true;	// No input
+	}
+
+	m_type = UH_FILE;
+	m_name = std::string("file:") + out;
+	if(!in.empty())
+		m_name += std::string(",") + in;
+
+	return true;
+}
+
+
+void uart_host::poll()
+{
+	unsigned char buf[256];
+	ssize_t n;
+
+	if(m_eof || m_in_fd < 0)
+		return;
+
+	n = read(m_in_fd, buf, sizeof(buf));
+	if(n > 0) {
+		for(ssize_t i = 0; i < n; ++i)
+			m_rxq.push_back(m_lf2cr && buf[i] == '\n' ? '\r' : buf[i]);
+	} else if(n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK &&
+		errno != EINTR)) {
+		m_eof = (m_type != UH_PTY);	// PTY reports EIO until a client opens it
+	}
+}
+
+
+int uart_host::get_byte()
+{
+	int b;
+
+	if(m_rxq.empty())
+		return -1;
+
+	b = m_rxq.front();
+	m_rxq.pop_front();
+	++m_rx_bytes;
+
+	return b;
+}
+
+
+void uart_host::put_byte(unsigned char b)
+{
+	++m_tx_bytes;
+
+	if(m_type == UH_STDIO) {
+		fputc(b, stdout);
+		return;
+	}
+
+	if(m_out_fd < 0)
+		return;
+
+	// Output is rare compared to simulation speed, so blocking write is
+	// fine. Data is dropped if nobody reads it for a while.
+	while(write(m_out_fd, &b, 1) < 0) {
+		if(errno == EAGAIN || errno == EWOULDBLOCK) {
+			struct pollfd pfd = { m_out_fd, POLLOUT, 0 };
+			if(::poll(&pfd, 1, 100) <= 0)
+				break;
+		} else if(errno != EINTR) {
+			break;	// Peer gone, drop output
+		}
+	}
+}
+
+
+void uart_host::flush()
+{
+	if(m_type == UH_STDIO)
+		fflush(stdout);
+}
+
+
+#if defined(SIM_SAVABLE)
+
+void uart_host::save(VerilatedSerialize &os)
+{
+	vluint32_t n = m_rxq.size();
+
+	os.write(&n, sizeof(n));
+	for(std::deque<unsigned char>::const_iterator it = m_rxq.begin();
+		it != m_rxq.end(); ++it)
+		os.write(&*it, 1);
+	os.write(&m_rx_bytes, sizeof(m_rx_bytes));
+	os.write(&m_tx_bytes, sizeof(m_tx_bytes));
+}
+
+
+void uart_host::restore(VerilatedDeserialize &is)
+{
+	vluint32_t n;
+
+	is.read(&n, sizeof(n));
+	m_rxq.clear();
+	while(n--) {
+		unsigned char b;
+		is.read(&b, 1);
+		m_rxq.push_back(b);
+	}
+	is.read(&m_rx_bytes, sizeof(m_rx_bytes));
+	is.read(&m_tx_bytes, sizeof(m_tx_bytes));
+}
+
+#endif /* SIM_SAVABLE */
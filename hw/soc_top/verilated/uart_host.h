@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Host side of the model UART: standard I/O, pseudo-terminal or TCP socket.
+ */
+
+#ifndef _VL_UART_HOST_H_
+#define _VL_UART_HOST_H_
+
+#include <termios.h>
+#include <string>
+#include <deque>
+
+class VerilatedSerialize;
+class VerilatedDeserialize;
+
+
+// Host UART endpoint
+class uart_host {
+public:
+	// Endpoint types
+	enum type {
+		UH_STDIO,	// stdin / stdout
+		UH_PTY,		// Pseudo-terminal
+		UH_TCP,		// Local TCP socket
+		UH_FILE		// Output to file, input from file or none
+	};
+
+	uart_host();
+	~uart_host();
+
+	// Open endpoint described by spec: "stdio", "pty", "tcp:<port>" or
+	// "file:<output>[,<input>]". Returns false on failure.
+	bool open(const std::string &spec);
+
+	// Close endpoint and restore terminal settings
+	void close();
+
+	// Poll host for input. Call periodically, not every cycle.
+	void poll();
+
+	// Get next received byte or -1 if nothing buffered
+	int get_byte();
+
+	// Returns true if input bytes are buffered
+	bool has_input() const { return !m_rxq.empty(); }
+
+	// Returns true if host closed input
+	bool eof() const { return m_eof; }
+
+	// Send byte to host
+	void put_byte(unsigned char b);
+
+	// Flush output
+	void flush();
+
+	// Translate LF to CR on input (for scripted console sessions)
+	void set_lf2cr(bool on) { m_lf2cr = on; }
+
+	// Endpoint description
+	const std::string &name() const { return m_name; }
+
+	// Transfer statistics
+	unsigned long long rx_bytes() const { return m_rx_bytes; }
+	unsigned long long tx_bytes() const { return m_tx_bytes; }
+
+	// Checkpoint support (SAVABLE builds only). Endpoint
+	// itself is not saved, only buffered input and statistics.
+	void save(VerilatedSerialize &os);
+	void restore(VerilatedDeserialize &is);
+
+private:
+	bool open_stdio();
+	bool open_pty();
+	bool open_tcp(unsigned port);
+	bool open_file(const std::string &out, const std::string &in);
+	void set_raw(int fd);
+
+	type m_type;
+	std::string m_name;
+	int m_in_fd;			// Input file descriptor
+	int m_out_fd;			// Output file descriptor
+	int m_listen_fd;		// Listening socket (TCP)
+	int m_slave_fd;			// Slave side (PTY)
+	int m_tty_fd;			// Terminal with saved settings or -1
+	struct termios m_tty_saved;	// Saved terminal settings
+	int m_stdin_flags;		// Saved stdin file status flags or -1
+	bool m_eof;			// Input closed
+	bool m_lf2cr;			// Translate LF to CR
+	std::deque<unsigned char> m_rxq;	// Input queue
+	unsigned long long m_rx_bytes;
+	unsigned long long m_tx_bytes;
+
+	uart_host(const uart_host&);
+	uart_host& operator=(const uart_host&);
+};
+
+
+#endif /* _VL_UART_HOST_H_ */
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Bit-level UART transactor connecting model UART pins to host endpoint.
+ */
+
+#include <iostream>
+#include "uart_xactor.h"
+#if defined(SIM_SAVABLE)
+# include <verilated_save.h>
+#endif
+
+
+// Bit time of upuart transmitter in cycles. Baud rate generator toggles
+// its output every 8*div+1 cycles (upuart_brgen). Same as TX_BIT_CYCLES
+// in boot/src/uart.c.
+static inline unsigned tx_bit_cycles(unsigned div)
+{
+	return 16 * div + 2;
+}
+
+// Sampling period of upuart receiver in cycles (upuart_brgen in
+// oversampling mode). Same as RX_SAMPLE_CYCLES in boot/src/uart.c.
+static inline unsigned rx_sample_cycles(unsigned div)
+{
+	return 2 * (div / 2 + 1);
+}
+
+// Host poll interval in cycles when transmitter is idle
+static const unsigned poll_interval = 1024;
+
+
+uart_xactor::uart_xactor(uart_host &host)
+	: m_host(host), m_stop_byte(-1), m_stopped(false),
+	m_rx_state(RX_IDLE), m_rx_count(0), m_rx_bit(0), m_rx_data(0),
+	m_tx_bit(-1), m_tx_count(0), m_tx_frame(0), m_poll_count(0),
+	m_div(0)
+{
+}
+
+
+bool uart_xactor::clock(bool txd, bool rts, unsigned div)
+{
+	// Host runs at the baud rate of model's transmitter, like a terminal
+	// set to the rate the ROM programmed.
+	unsigned period = tx_bit_cycles(div);	// Bit period in cycles
+
+	if(!div)
+		return true;	// UART is not configured yet, keep line idle
+
+	// Model's receiver takes 14.75 to 15.94 samples per bit (upuart_rx),
+	// the ROM does not program dividers outside this range.
+	if(div != m_div) {
+		unsigned smp = rx_sample_cycles(div);
+		m_div = div;
+		if(16 * period < 236 * smp || 16 * period > 255 * smp)
+			std::cerr << "UART: divider " << div
+				<< " is outside receiver range, input may be lost"
+				<< std::endl;
+	}
+
+	/* Receive from model */
+	if(m_rx_state == RX_IDLE) {
+		if(!txd) {	// Start bit
+			m_rx_state = RX_DATA;
+			m_rx_count = period + period / 2;	// Middle of bit 0
+			m_rx_bit = 0;
+			m_rx_data = 0;
+		}
+	} else if(!--m_rx_count) {
+		if(m_rx_bit < 8) {
+			m_rx_data |= (txd ? 1 : 0) << m_rx_bit;
+			m_rx_count = period;
+			++m_rx_bit;
+		} else {
+			// Middle of stop bit. Framing errors are ignored.
+			m_rx_state = RX_IDLE;
+			if((int)m_rx_data == m_stop_byte)
+				m_stopped = true;
+			else
+				m_host.put_byte((unsigned char)m_rx_data);
+		}
+	}
+
+	/* Transmit to model */
+	if(m_tx_bit < 0) {
+		if(!m_poll_count--) {
+			m_host.poll();
+			m_poll_count = poll_interval;
+		}
+
+		// Start next frame if model is ready to receive
+		if(!rts && m_host.has_input()) {
+			m_tx_frame = (1u << 9) | ((unsigned)m_host.get_byte() << 1);
+			m_tx_bit = 0;
+			m_tx_count = period;
+		}
+	} else if(!--m_tx_count) {
+		if(++m_tx_bit == 10)
+			m_tx_bit = -1;	// Frame sent
+		else
+			m_tx_count = period;
+	}
+
+	return m_tx_bit < 0 ? true : ((m_tx_frame >> m_tx_bit) & 1);
+}
+
+
+#if defined(SIM_SAVABLE)
+
+void uart_xactor::save(VerilatedSerialize &os)
+{
+	os.write(&m_stopped, sizeof(m_stopped));
+	os.write(&m_rx_state, sizeof(m_rx_state));
+	os.write(&m_rx_count, sizeof(m_rx_count));
+	os.write(&m_rx_bit, sizeof(m_rx_bit));
+	os.write(&m_rx_data, sizeof(m_rx_data));
+	os.write(&m_tx_bit, sizeof(m_tx_bit));
+	os.write(&m_tx_count, sizeof(m_tx_count));
+	os.write(&m_tx_frame, sizeof(m_tx_frame));
+	os.write(&m_poll_count, sizeof(m_poll_count));
+}
+
+
+void uart_xactor::restore(VerilatedDeserialize &is)
+{
+	is.read(&m_stopped, sizeof(m_stopped));
+	is.read(&m_rx_state, sizeof(m_rx_state));
+	is.read(&m_rx_count, sizeof(m_rx_count));
+	is.read(&m_rx_bit, sizeof(m_rx_bit));
+	is.read(&m_rx_data, sizeof(m_rx_data));
+	is.read(&m_tx_bit, sizeof(m_tx_bit));
+	is.read(&m_tx_count, sizeof(m_tx_count));
+	is.read(&m_tx_frame, sizeof(m_tx_frame));
+	is.read(&m_poll_count, sizeof(m_poll_count));
+}
+
+#endif /* SIM_SAVABLE */
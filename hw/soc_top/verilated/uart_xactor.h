@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Bit-level UART transactor connecting model UART pins to host endpoint.
+ */
+
+#ifndef _VL_UART_XACTOR_H_
+#define _VL_UART_XACTOR_H_
+
+#include "uart_host.h"
+
+class VerilatedSerialize;
+class VerilatedDeserialize;
+
+
+// UART transactor (8N1 framing)
+class uart_xactor {
+public:
+	explicit uart_xactor(uart_host &host);
+
+	// Byte which stops simulation when received from model (-1 - none)
+	void set_stop_byte(int b) { m_stop_byte = b; }
+
+	// Returns true if stop byte was received
+	bool stopped() const { return m_stopped; }
+
+	// Advance one clock cycle. Takes model's TxD and RTS lines and
+	// current baud rate divider, returns RxD line level for the model.
+	bool clock(bool txd, bool rts, unsigned div);
+
+	// Returns true if no transfer in progress in either direction
+	bool idle() const { return m_rx_state == RX_IDLE && m_tx_bit < 0; }
+
+	// Checkpoint support (SAVABLE builds only)
+	void save(VerilatedSerialize &os);
+	void restore(VerilatedDeserialize &is);
+
+private:
+	enum { RX_IDLE, RX_DATA };
+
+	uart_host &m_host;
+	int m_stop_byte;
+	bool m_stopped;
+
+	// Model -> host
+	int m_rx_state;
+	unsigned m_rx_count;	// Cycles to next sample
+	unsigned m_rx_bit;	// Current bit number
+	unsigned m_rx_data;	// Shift register
+
+	// Host -> model
+	int m_tx_bit;		// Current frame bit (-1 - idle)
+	unsigned m_tx_count;	// Cycles left for current bit
+	unsigned m_tx_frame;	// Frame bits, LSB first
+	unsigned m_poll_count;	// Cycles to next host poll
+
+	unsigned m_div;		// Last checked divider
+
+	uart_xactor(const uart_xactor&);
+	uart_xactor& operator=(const uart_xactor&);
+};
+
+
+#endif /* _VL_UART_XACTOR_H_ */
@@ -32,27 +32,73 @@
 
 module vl_soc_top(
 	clk,
-	nrst
+	nrst,
+	/* UART (driven by host transactor) */
+	CTS,
+	RTS,
+	TxD,
+	RxD,
+	/* UART baud rate divider (for host transactor) */
+	UART_DIV,
+	/* CPU buses (for host side monitors) */
+	C_IAddr,
+	C_IRdC,
+	C_IData,
+	C_IRdy,
+	C_DAddr,
+	C_DCmd,
+	C_DRnW,
+	C_DBen,
+	C_DDataM,
+	C_DDataS,
+	C_DRdy,
+	INTR,
+	/* OCP fabric ports (for host side bus monitor) */
+	I_MAddr,
+	I_MCmd,
+	I_SCmdAccept,
+	I_SResp,
+	D_MAddr,
+	D_MCmd,
+	D_SCmdAccept,
+	D_SResp,
+	P_MCmd,
+	P_SCmdAccept,
+	P_SResp
 );
-input wire	clk;
-input wire	nrst;
+input wire		clk;
+input wire		nrst;
+input wire		CTS;
+output wire		RTS;
+output wire		TxD;
+input wire		RxD;
+output wire [15:0]	UART_DIV;
+output wire [`ADDR_WIDTH-1:0]	C_IAddr;
+output wire			C_IRdC;
+output wire [`DATA_WIDTH-1:0]	C_IData;
+output wire			C_IRdy;
+output wire [`ADDR_WIDTH-1:0]	C_DAddr;
+output wire			C_DCmd;
+output wire			C_DRnW;
+output wire [`BEN_WIDTH-1:0]	C_DBen;
+output wire [`DATA_WIDTH-1:0]	C_DDataM;
+output wire [`DATA_WIDTH-1:0]	C_DDataS;
+output wire			C_DRdy;
+output wire			INTR;
+output wire [`ADDR_WIDTH-1:0]	I_MAddr;
+output wire [2:0]		I_MCmd;
+output wire			I_SCmdAccept;
+output wire [1:0]		I_SResp;
+output wire [`ADDR_WIDTH-1:0]	D_MAddr;
+output wire [2:0]		D_MCmd;
+output wire			D_SCmdAccept;
+output wire [1:0]		D_SResp;
+output wire [14:0]		P_MCmd;		/* {P4, P3, P2, P1, P0} */
+output wire [4:0]		P_SCmdAccept;
+output wire [9:0]		P_SResp;
 
 
 wire [7:0]	LED;
-reg		CTS;
-wire		RTS;
-wire		TxD;
-reg		RxD;
-
-
-always @(posedge clk or negedge nrst)
-begin
-	if(!nrst)
-	begin
-		CTS <= 1'b0;
-		RxD <= 1'b1;
-	end;
-end
 
 
 /* Instantiate system top */
@@ -67,44 +113,99 @@ ultisoc_soc_top sys(
 );
 
 
-/* UART receiver */
+/* Current UART divider value. Used by host side to follow baud rate. */
+assign UART_DIV = sys.upuart.ctrl_count;
+
+
+/* CPU buses */
+assign C_IAddr = sys.C_IAddr;
+assign C_IRdC = sys.C_IRdC;
+assign C_IData = sys.C_IData;
+assign C_IRdy = sys.C_IRdy;
+assign C_DAddr = sys.C_DAddr;
+assign C_DCmd = sys.C_DCmd;
+assign C_DRnW = sys.C_DRnW;
+assign C_DBen = sys.C_DBen;
+assign C_DDataM = sys.C_DDataM;
+assign C_DDataS = sys.C_DDataS;
+assign C_DRdy = sys.C_DRdy;
+assign INTR = sys.intr;
+
+
+/* OCP fabric ports */
+assign I_MAddr = sys.I_MAddr;
+assign I_MCmd = sys.I_MCmd;
+assign I_SCmdAccept = sys.I_SCmdAccept;
+assign I_SResp = sys.I_SResp;
+assign D_MAddr = sys.D_MAddr;
+assign D_MCmd = sys.D_MCmd;
+assign D_SCmdAccept = sys.D_SCmdAccept;
+assign D_SResp = sys.D_SResp;
+assign P_MCmd = { sys.P_MCmd[4], sys.P_MCmd[3], sys.P_MCmd[2],
+	sys.P_MCmd[1], sys.P_MCmd[0] };
+assign P_SCmdAccept = { sys.P_SCmdAccept[4], sys.P_SCmdAccept[3],
+	sys.P_SCmdAccept[2], sys.P_SCmdAccept[1], sys.P_SCmdAccept[0] };
+assign P_SResp = { sys.P_SResp[4], sys.P_SResp[3], sys.P_SResp[2],
+	sys.P_SResp[1], sys.P_SResp[0] };
 
-wire rx_brreset;
-wire rx_baud_rate;
-wire [7:0] rx_data;
-wire rx_data_rdy;
 
-/* RX baud rate generator */
-upuart_brgen rx_brgen (
-	.clk(clk),
-	.nrst(nrst),
-	.count_val(32'd27),	/* Clock divider for 115200bps */
-	.ovrsamp(1'b1),
-	.enable(1'b1),
-	.reset(rx_brreset),
-	.baud_rate(rx_baud_rate)
-);
+/*
+ * Host access to memory arrays (ELF loader)
+ */
 
-/* Receiver */
-upuart_rx rx(
-	.clk(clk),
-	.nrst(nrst),
-	.data_out(rx_data),
-	.data_wr(rx_data_rdy),
-	.uclk(rx_baud_rate),
-	.brreset(rx_brreset),
-	.rxd(TxD)
-);
+localparam MEM_WORDS = 131072;	/* ROM and RAM size in words (see memory_top) */
+localparam MEM_SEL_BIT = 24;	/* ROM / RAM select bit */
+
+export "DPI-C" function vl_mem_write;
 
-always @(posedge clk)
-begin
-	if(rx_data_rdy)
+/* Write memory word. Returns 0 on success or -1 if address is not in memory. */
+function int vl_mem_write(input int addr, input int data);
+	reg [`ADDR_WIDTH-1:0] a;
 	begin
-		if(rx_data != 8'hFF)
-			$write("%c", rx_data);
+		a = addr;
+		/* verilator lint_off WIDTH */
+		if(a[`ADDR_WIDTH-1:MEM_SEL_BIT+1] != 0 || a[MEM_SEL_BIT-1:2] >= MEM_WORDS)
+			vl_mem_write = -1;
 		else
-			$finish; /* Stop simulation if 0xFF received */
+		begin
+			if(a[MEM_SEL_BIT])
+				sys.mem.ram.mem[a[MEM_SEL_BIT-1:2]] = data;
+			else
+				sys.mem.rom.mem[a[MEM_SEL_BIT-1:2]] = data;
+			vl_mem_write = 0;
+		end
+		/* verilator lint_on WIDTH */
 	end
-end
+endfunction
+
+
+/*
+ * Host access to performance counters (fast-forward)
+ */
+
+localparam PERF_NCNT = 12;	/* Number of counters (see soc_control) */
+
+export "DPI-C" function vl_perf_read;
+export "DPI-C" function vl_perf_add;
+
+/* Read counter n */
+function longint vl_perf_read(input int n);
+	begin
+		/* verilator lint_off WIDTH */
+		vl_perf_read = (n < PERF_NCNT ? sys.soc_ctl.perf_cnt[n] : 0);
+		/* verilator lint_on WIDTH */
+	end
+endfunction
+
+/* Advance counter n by v. Frozen counters are not changed. */
+function void vl_perf_add(input int n, input longint v);
+	begin
+		/* verilator lint_off WIDTH */
+		if(n < PERF_NCNT && !sys.soc_ctl.perf_freeze)
+			sys.soc_ctl.perf_cnt[n] = sys.soc_ctl.perf_cnt[n] + v;
+		/* verilator lint_on WIDTH */
+	end
+endfunction
+
 
 endmodule /* vl_soc_top */
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Waveform capture.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include "wave_trace.h"
+
+#if VM_TRACE
+
+#if defined(SIM_TRACE_FST)
+# include <verilated_fst_c.h>
+#else
+# include <verilated_vcd_c.h>
+#endif
+#include "Vvl_soc_top.h"
+
+
+// Exception vectors: bus error (1) to system call (6). Vector 0 is reset
+// and vector 7 is hardware interrupt; both are part of normal operation.
+static const vluint32_t exc_first = 1;
+static const vluint32_t exc_last = 6;
+static const vluint32_t exc_vec_size = 8;	// Two instructions per vector
+
+#if defined(SIM_TRACE_FST)
+static const char def_ext[] = ".fst";
+#else
+static const char def_ext[] = ".vcd";
+#endif
+
+
+bool wave_trigger::parse(const char *spec)
+{
+	const char *num = spec;
+	char *end;
+
+	if(!strncmp(spec, "pc:", 3)) {
+		kind = PC;
+		num = spec + 3;
+	} else if(!strcmp(spec, "exc")) {
+		kind = EXCEPTION;
+		value = 0;
+		return true;
+	} else if(!strncmp(spec, "exc:", 4)) {
+		kind = EXCEPTION;
+		num = spec + 4;
+	} else {
+		kind = CYCLE;
+	}
+
+	value = strtoull(num, &end, 0);
+	return *num && !*end;
+}
+
+
+bool wave_trigger::fired(vluint64_t cycle, const cpu_probe &p) const
+{
+	switch(kind) {
+	case CYCLE:
+		return cycle >= value;
+	case PC:
+		return p.ifetch && p.iaddr == (vluint32_t)value;
+	case EXCEPTION:
+		if(p.ifetch && p.iaddr >= (vluint32_t)value) {
+			vluint32_t off = p.iaddr - (vluint32_t)value;
+			return !(off % exc_vec_size) && off / exc_vec_size >= exc_first &&
+				off / exc_vec_size <= exc_last;
+		}
+		return false;
+	default:
+		return false;
+	}
+}
+
+
+wave_trace::wave_trace(const char *file, const wave_trigger &start,
+		const wave_trigger &stop, vluint64_t window)
+	: m_tfp(new wave_file), m_start(start), m_stop(stop), m_window(window),
+	m_state(ARMED), m_seg(0), m_seg_start(0), m_first(0), m_last(0)
+{
+	std::string f(file ? file : "vlt_dump");
+	size_t dot = f.rfind('.');
+	if(dot != std::string::npos && f.find('/', dot) == std::string::npos) {
+		m_base = f.substr(0, dot);
+		m_ext = f.substr(dot);
+	} else {
+		m_base = f;
+		m_ext = def_ext;
+	}
+}
+
+
+wave_trace::~wave_trace()
+{
+	close();
+	delete m_tfp;
+}
+
+
+void wave_trace::attach(Vvl_soc_top &top)
+{
+	Verilated::traceEverOn(true);	// Enable traces
+	top.trace(m_tfp, 99);		// Trace 99 levels of hierarchy
+}
+
+
+std::string wave_trace::segment_name(unsigned seg) const
+{
+	std::ostringstream s;
+	s << m_base << "." << seg << m_ext;
+	return s.str();
+}
+
+
+std::string wave_trace::name() const
+{
+	return m_window ? m_base + ".<n>" + m_ext : m_base + m_ext;
+}
+
+
+void wave_trace::open_next(vluint64_t cycle)
+{
+	if(!m_window) {
+		m_tfp->open((m_base + m_ext).c_str());
+		m_first = cycle;
+		return;
+	}
+
+	// Rotate segments keeping the previous one
+	if(m_tfp->isOpen()) {
+		m_tfp->close();
+		if(m_seg > 0)
+			remove(segment_name(m_seg - 1).c_str());
+		++m_seg;
+	}
+	m_tfp->open(segment_name(m_seg).c_str());
+	m_first = (m_seg > 0 ? m_seg_start : cycle);
+	m_seg_start = cycle;
+}
+
+
+void wave_trace::start(vluint64_t cycle)
+{
+	m_state = ACTIVE;
+	open_next(cycle);
+	if(m_start.kind != wave_trigger::NONE)
+		std::cout << "Waveform capture started at cycle " << cycle
+			<< std::endl;
+}
+
+
+void wave_trace::cycle(vluint64_t cycle, const cpu_probe &p)
+{
+	if(m_state == ARMED && m_start.fired(cycle, p)) {
+		start(cycle);
+	} else if(m_state == ACTIVE && m_stop.fired(cycle, p)) {
+		// Stop after this cycle is dumped
+		m_state = DONE;
+		std::cout << "Waveform capture stopped at cycle " << cycle
+			<< std::endl;
+	} else if(m_state == ACTIVE && m_window && cycle - m_seg_start >= m_window) {
+		open_next(cycle);
+	}
+}
+
+
+void wave_trace::dump(vluint64_t time)
+{
+	// No start trigger, dump from the beginning
+	if(m_state == ARMED && m_start.kind == wave_trigger::NONE)
+		start(time / 2);
+
+	if(m_state == ACTIVE) {
+		m_tfp->dump(time);
+		m_last = time / 2;
+	} else if(m_state == DONE && m_tfp->isOpen()) {
+		m_tfp->dump(time);	// Stop cycle
+		m_tfp->close();
+		m_last = time / 2;
+	}
+}
+
+
+void wave_trace::close()
+{
+	if(m_tfp->isOpen())
+		m_tfp->close();
+	m_state = DONE;
+}
+
+#endif /* VM_TRACE */
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Waveform capture.
+ *
+ * Dumping starts and stops on triggers: cycle number, fetch of given PC or
+ * fetch from exception vector. In flight recorder mode dump is split into
+ * segment files of given number of cycles and only two most recent segments
+ * are kept, so the last cycles before stop are always available.
+ */
+
+#ifndef _VL_WAVE_TRACE_H_
+#define _VL_WAVE_TRACE_H_
+
+#include <verilated.h>
+#include <string>
+#include "cpu_probe.h"
+
+#if VM_TRACE
+
+#if defined(SIM_TRACE_FST)
+class VerilatedFstC;
+typedef VerilatedFstC wave_file;
+#else
+class VerilatedVcdC;
+typedef VerilatedVcdC wave_file;
+#endif
+
+class Vvl_soc_top;
+
+
+// Trace trigger
+struct wave_trigger {
+	enum kind_type {
+		NONE,		// Never fires
+		CYCLE,		// Cycle reached
+		PC,		// Instruction fetched from address
+		EXCEPTION	// Instruction fetched from exception vector
+	};
+
+	kind_type kind;
+	vluint64_t value;	// Cycle, PC or vectors table base
+
+	wave_trigger() : kind(NONE), value(0) {}
+
+	// Parse trigger: <cycle>, pc:<addr> or exc[:<ivtb>].
+	// Returns false on malformed spec.
+	bool parse(const char *spec);
+
+	// Returns true if trigger fires on this cycle
+	bool fired(vluint64_t cycle, const cpu_probe &p) const;
+
+	// Returns true if CPU buses should be sampled
+	bool needs_probe() const { return kind == PC || kind == EXCEPTION; }
+};
+
+
+// Waveform dump
+class wave_trace {
+public:
+	// Dump file name (default extension is added if empty), start and stop
+	// triggers and flight recorder window in cycles (0 - dump everything).
+	wave_trace(const char *file, const wave_trigger &start,
+		const wave_trigger &stop, vluint64_t window);
+	~wave_trace();
+
+	// Register model signals. Called once before simulation.
+	void attach(Vvl_soc_top &top);
+
+	// Evaluate triggers. Called once per cycle on rising edge.
+	void cycle(vluint64_t cycle, const cpu_probe &p);
+
+	// Dump model state if capture is active
+	void dump(vluint64_t time);
+
+	// Stop capture and keep dumped files
+	void close();
+
+	// Returns true if CPU buses should be sampled
+	bool needs_probe() const
+	{
+		return m_start.needs_probe() || m_stop.needs_probe();
+	}
+
+	// Dump file name or segment file name pattern
+	std::string name() const;
+
+	// Captured cycles range
+	vluint64_t first_cycle() const { return m_first; }
+	vluint64_t last_cycle() const { return m_last; }
+
+private:
+	// Segment file name
+	std::string segment_name(unsigned seg) const;
+
+	// Start capture
+	void start(vluint64_t cycle);
+
+	// Open next dump file
+	void open_next(vluint64_t cycle);
+
+	wave_file *m_tfp;
+	std::string m_base;		// File name without extension
+	std::string m_ext;		// File name extension
+	wave_trigger m_start;
+	wave_trigger m_stop;
+	vluint64_t m_window;		// Segment length in cycles
+	enum { ARMED, ACTIVE, DONE } m_state;
+	unsigned m_seg;			// Current segment number
+	vluint64_t m_seg_start;		// Current segment first cycle
+	vluint64_t m_first;		// First kept cycle
+	vluint64_t m_last;		// Last dumped cycle
+
+	wave_trace(const wave_trace&);
+	wave_trace& operator=(const wave_trace&);
+};
+
+#endif /* VM_TRACE */
+
+
+#endif /* _VL_WAVE_TRACE_H_ */
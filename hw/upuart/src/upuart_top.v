@@ -39,6 +39,9 @@ module upuart_top #(
 	nrst,
 	/* Interrupt output */
 	o_intr,
+	/* Byte strobes (for performance counters) */
+	o_tx_byte,
+	o_rx_byte,
 	/* UART */
 	rxd,	/* Receive data (RxD ) */
 	txd,	/* Transmit data (TxD) */
@@ -63,6 +66,9 @@ input wire			clk;
 input wire			nrst;
 /* Interrupt output */
 output wire			o_intr;
+/* Byte strobes */
+output wire			o_tx_byte;	/* Byte taken from TX FIFO */
+output wire			o_rx_byte;	/* Byte put into RX FIFO */
 /* UART */
 input wire			rxd;
 output wire			txd;
@@ -121,6 +127,12 @@ wire			rx_fifo_wr;
 wire			rx_brreset;
 wire			rx_baud_rate;
 
+/* Serial transmitter / receiver FIFO access */
+wire			ser_tx_valid;
+wire			ser_tx_rd;
+wire [FIFO_WIDTH-1:0]	ser_rx_data;
+wire			ser_rx_wr;
+
 
 /* OCP bus interface adapter */
 upuart_ocp_if #(
@@ -213,8 +225,8 @@ upuart_fifo #(
 upuart_rx rx(
 	.clk(clk),
 	.nrst(nrst),
-	.data_out(rx_fifo_data_i),
-	.data_wr(rx_fifo_wr),
+	.data_out(ser_rx_data),
+	.data_wr(ser_rx_wr),
 	.uclk(rx_baud_rate),
 	.brreset(rx_brreset),
 	.rxd(rxd)
@@ -226,8 +238,8 @@ upuart_tx tx(
 	.clk(clk),
 	.nrst(nrst),
 	.data_in(tx_fifo_data_o),
-	.data_valid(~tx_fifo_empty),
-	.data_rd(tx_fifo_rd),
+	.data_valid(ser_tx_valid),
+	.data_rd(ser_tx_rd),
 	.uclk(tx_baud_rate),
 	.uclk_rx(rx_baud_rate),
 	.brenable(tx_brenable),
@@ -236,6 +248,84 @@ upuart_tx tx(
 );
 
 
+assign o_tx_byte = tx_fifo_rd;
+assign o_rx_byte = rx_fifo_wr;
+
+
+`ifndef UPUART_DPI
+
+/* FIFOs are connected to serial transmitter and receiver */
+assign ser_tx_valid = ~tx_fifo_empty;
+assign tx_fifo_rd = ser_tx_rd;
+assign rx_fifo_data_i = ser_rx_data;
+assign rx_fifo_wr = ser_rx_wr;
+
+`else
+
+/*
+ * Simulation only: byte-level fast path. If enabled by the host side,
+ * TX FIFO is drained and RX FIFO is filled directly over DPI bypassing
+ * serial transmitter and receiver. Registers behavior is not changed.
+ */
+
+/* Returns non-zero if fast path is enabled */
+import "DPI-C" function int upuart_dpi_enabled();
+/* Returns non-zero if host is ready to accept next byte */
+import "DPI-C" function int upuart_dpi_tx_ready(input int divider);
+/* Send byte to host */
+import "DPI-C" function void upuart_dpi_tx(input int data);
+/* Receive byte from host. Returns -1 if no data. */
+import "DPI-C" function int upuart_dpi_rx(input int divider);
+
+reg			dpi_en;		/* Fast path enabled */
+reg			dpi_tx_rd;	/* TX FIFO read */
+reg			dpi_rx_wr;	/* RX FIFO write */
+reg [FIFO_WIDTH-1:0]	dpi_rx_data;	/* RX FIFO data */
+integer			dpi_rx_ch;
+
+initial dpi_en = (upuart_dpi_enabled() != 0);
+
+assign ser_tx_valid = ~tx_fifo_empty & ~dpi_en;
+assign tx_fifo_rd = dpi_en ? dpi_tx_rd : ser_tx_rd;
+assign rx_fifo_data_i = dpi_en ? dpi_rx_data : ser_rx_data;
+assign rx_fifo_wr = dpi_en ? dpi_rx_wr : ser_rx_wr;
+
+always @(posedge clk or negedge nrst)
+begin
+	if(!nrst)
+	begin
+		dpi_tx_rd <= 1'b0;
+		dpi_rx_wr <= 1'b0;
+		dpi_rx_data <= {(FIFO_WIDTH){1'b0}};
+	end
+	else if(dpi_en)
+	begin
+		dpi_tx_rd <= 1'b0;
+		dpi_rx_wr <= 1'b0;
+
+		/* Previous read/write must be completed to see valid FIFO state */
+		if(!tx_fifo_empty && !dpi_tx_rd &&
+			upuart_dpi_tx_ready({ {(32-COUNT_WIDTH){1'b0}}, ctrl_count }) != 0)
+		begin
+			upuart_dpi_tx({ {(32-FIFO_WIDTH){1'b0}}, tx_fifo_data_o });
+			dpi_tx_rd <= 1'b1;
+		end
+
+		if(!rx_fifo_full && !dpi_rx_wr)
+		begin
+			dpi_rx_ch = upuart_dpi_rx({ {(32-COUNT_WIDTH){1'b0}}, ctrl_count });
+			if(dpi_rx_ch >= 0)
+			begin
+				dpi_rx_data <= dpi_rx_ch[FIFO_WIDTH-1:0];
+				dpi_rx_wr <= 1'b1;
+			end
+		end
+	end
+end
+
+`endif
+
+
 /* Control unit */
 upuart_ctrl #(
 	.DATA_WIDTH(DATA_WIDTH),
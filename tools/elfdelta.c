@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Incremental ELF loader.
+ *
+ * Compares CRC16 of memory blocks reported by the boot ROM "memcrc" command
+ * with PT_LOAD segments of the ELF file and sends only differing blocks
+ * using the boot ROM "ymodem" command. Memory past the file image of a
+ * segment (.bss) is cleared with "memset" and checked the same way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <elf.h>
+#include <crc16_ccitt.h>
+#include "serial.h"
+#include "ymodem.h"
+
+
+/* Boot ROM console prompt */
+#define PROMPT		"$ "
+
+
+/* Run of differing blocks */
+struct run {
+	unsigned long addr;	/* Load address */
+	size_t off;		/* File offset */
+	size_t size;		/* Size in bytes */
+};
+
+
+/* Send command and collect its output up to the next prompt.
+ * Returns output length or -1 on timeout.
+ */
+static int command(int fd, const char *cmd, char *out, size_t max)
+{
+	size_t n = 0, plen = strlen(PROMPT);
+	int ch;
+
+	serial_write(fd, cmd, strlen(cmd));
+	serial_putc(fd, '\r');
+
+	while((ch = serial_getc(fd, 5000)) >= 0) {
+		if(n < max - 1)
+			out[n++] = ch;
+		out[n] = '\0';
+		if(n >= plen && !strcmp(&out[n - plen], PROMPT))
+			return n;
+	}
+
+	return -1;
+}
+
+
+/* Get block CRCs of memory range. Returns number of CRCs or -1 on error. */
+static long get_crcs(int fd, unsigned long addr, size_t size, size_t blk_sz,
+	crc16_t *crcs, size_t max)
+{
+	size_t out_sz = (size / blk_sz + 1) * 8 + 4096;
+	char *out = (char*)malloc(out_sz);
+	char cmd[64], *p;
+	size_t n = 0;
+
+	if(!out)
+		return -1;
+
+	snprintf(cmd, sizeof(cmd), "memcrc 0x%lx %lu %lu", addr, (unsigned long)size,
+		(unsigned long)blk_sz);
+	if(command(fd, cmd, out, out_sz) < 0) {
+		free(out);
+		return -1;
+	}
+
+	/* Parse "<address>: <crc> <crc> ..." lines, other lines are echo */
+	for(p = out; p && *p; p = strchr(p, '\n'), p = p ? p + 1 : p) {
+		unsigned long a;
+		unsigned v;
+		int k;
+		char *q;
+
+		while(*p == '\r')
+			++p;
+
+		if(sscanf(p, "%8lx:%n", &a, &k) != 1 || k != 9)
+			continue;
+
+		for(q = p + k; n < max && sscanf(q, " %4x%n", &v, &k) == 1 && *q == ' '; q += k)
+			crcs[n++] = v;
+	}
+
+	free(out);
+
+	return n;
+}
+
+
+/* Collect runs of differing blocks of one segment. Runs separated by up to
+ * gap equal blocks are merged since every transfer costs a few seconds.
+ */
+static size_t diff_segment(const unsigned char *data, const Elf32_Phdr_t *ph,
+	const crc16_t *crcs, size_t blk_sz, size_t gap, struct run *runs)
+{
+	size_t nblk = (ph->p_filesz + blk_sz - 1) / blk_sz;
+	size_t i, last = 0, nruns = 0;
+
+	for(i = 0; i < nblk; ++i) {
+		size_t off = i * blk_sz;
+		size_t n = (ph->p_filesz - off < blk_sz ? ph->p_filesz - off : blk_sz);
+
+		if(crc16_ccitt((const char*)&data[ph->p_offset + off], n) == crcs[i])
+			continue;
+
+		if(nruns && i - last <= gap + 1) {
+			/* Extend previous run */
+			runs[nruns - 1].size = off + n - (runs[nruns - 1].addr - ph->p_paddr);
+		} else {
+			runs[nruns].addr = ph->p_paddr + off;
+			runs[nruns].off = ph->p_offset + off;
+			runs[nruns].size = n;
+			++nruns;
+		}
+		last = i;
+	}
+
+	return nruns;
+}
+
+
+/* Load one run of blocks. Returns 0 on success. */
+static int send_run(int fd, const char *name, const unsigned char *data,
+	const struct run *r)
+{
+	char cmd[64];
+
+	printf("0x%08lx: %lu bytes\n", r->addr, (unsigned long)r->size);
+
+	snprintf(cmd, sizeof(cmd), "ymodem 0x%lx\r", r->addr);
+	serial_flush_input(fd, 100);
+	serial_write(fd, cmd, strlen(cmd));
+
+	return ymg_send(fd, name, &data[r->off], r->size, 0) == YM_OK ? 0 : -1;
+}
+
+
+/* Check and update one segment. Returns number of sent bytes or -1 on error. */
+static long load_segment(int fd, const char *name, const unsigned char *data,
+	const Elf32_Phdr_t *ph, size_t blk_sz, size_t gap, int verify)
+{
+	size_t nblk = (ph->p_filesz + blk_sz - 1) / blk_sz;
+	crc16_t *crcs = (crc16_t*)malloc(nblk * sizeof(crc16_t));
+	struct run *runs = (struct run*)malloc(nblk * sizeof(struct run));
+	size_t nruns, i;
+	long sent = 0;
+
+	if(!crcs || !runs)
+		goto error;
+
+	serial_flush_input(fd, 100);
+	if(get_crcs(fd, ph->p_paddr, ph->p_filesz, blk_sz, crcs, nblk) != (long)nblk) {
+		fprintf(stderr, "Failed to get CRCs of 0x%08x.\n", ph->p_paddr);
+		goto error;
+	}
+
+	nruns = diff_segment(data, ph, crcs, blk_sz, gap, runs);
+
+	if(verify) {
+		if(nruns) {
+			fprintf(stderr, "Segment 0x%08x differs after update.\n", ph->p_paddr);
+			goto error;
+		}
+	} else {
+		for(i = 0; i < nruns; ++i) {
+			if(send_run(fd, name, data, &runs[i]) < 0)
+				goto error;
+			sent += runs[i].size;
+		}
+	}
+
+	free(crcs);
+	free(runs);
+
+	return sent;
+
+error:
+	free(crcs);
+	free(runs);
+
+	return -1;
+}
+
+
+/* Clear and check zero-initialized tail of segment. Returns 0 on success. */
+static int zero_segment(int fd, const Elf32_Phdr_t *ph, size_t blk_sz, int verify)
+{
+	unsigned long addr = ph->p_paddr + ph->p_filesz;
+	size_t size = ph->p_memsz - ph->p_filesz;
+	size_t nblk = (size + blk_sz - 1) / blk_sz;
+	crc16_t *crcs = (crc16_t*)malloc(nblk * sizeof(crc16_t));
+	char *zero = (char*)calloc(1, blk_sz);
+	char cmd[64], out[256];
+	size_t i;
+
+	if(!crcs || !zero)
+		goto error;
+
+	serial_flush_input(fd, 100);
+
+	if(!verify) {
+		printf("0x%08lx: %lu bytes zeroed\n", addr, (unsigned long)size);
+		snprintf(cmd, sizeof(cmd), "memset 0x%lx 0 %lu", addr, (unsigned long)size);
+		if(command(fd, cmd, out, sizeof(out)) < 0 || !strstr(out, "memset: [")) {
+			fprintf(stderr, "Failed to clear 0x%08lx.\n", addr);
+			goto error;
+		}
+	} else {
+		if(get_crcs(fd, addr, size, blk_sz, crcs, nblk) != (long)nblk) {
+			fprintf(stderr, "Failed to get CRCs of 0x%08lx.\n", addr);
+			goto error;
+		}
+		for(i = 0; i < nblk; ++i) {
+			size_t n = (size - i * blk_sz < blk_sz ? size - i * blk_sz : blk_sz);
+			if(crc16_ccitt(zero, n) != crcs[i]) {
+				fprintf(stderr, "Segment 0x%08x is not zeroed after update.\n",
+					ph->p_paddr);
+				goto error;
+			}
+		}
+	}
+
+	free(crcs);
+	free(zero);
+
+	return 0;
+
+error:
+	free(crcs);
+	free(zero);
+
+	return -1;
+}
+
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-b <baud>] [-s <blk_size>] [-g <blocks>] [-r] <port> <file>\n"
+		"  -b <baud>     - serial port baud rate (default 115200);\n"
+		"  -s <blk_size> - compared block size (default 1024);\n"
+		"  -g <blocks>   - merge transfers separated by up to this number of\n"
+		"                  equal blocks (default 16);\n"
+		"  -r            - jump to entry point after loading;\n"
+		"  <port>        - serial device or tcp:[<host>:]<port> for the model.\n", prog);
+}
+
+
+int main(int argc, char **argv)
+{
+	long baud = 115200, blk_sz = 1024, gap = 16, sent = 0, total = 0, r;
+	int run = 0, pass, i, fd;
+	const Elf32_Ehdr_t *eh;
+	unsigned char *data;
+	size_t size, ph;
+
+	for(i = 1; i < argc && argv[i][0] == '-'; ++i) {
+		if(!strcmp(argv[i], "-b") && i + 1 < argc)
+			baud = atol(argv[++i]);
+		else if(!strcmp(argv[i], "-s") && i + 1 < argc)
+			blk_sz = atol(argv[++i]);
+		else if(!strcmp(argv[i], "-g") && i + 1 < argc)
+			gap = atol(argv[++i]);
+		else if(!strcmp(argv[i], "-r"))
+			run = 1;
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(argc - i != 2 || blk_sz <= 0 || gap < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if(!(data = load_file(argv[i + 1], &size)))
+		return 1;
+
+	/* Check ELF */
+	eh = (const Elf32_Ehdr_t*)data;
+	if(size < sizeof(*eh) || memcmp(eh->e_ident, ELF_MAGIC, 4) ||
+		eh->e_ident[EI_CLASS] != ELFCLASS32 || eh->e_ident[EI_DATA] != ELFDATA2LSB ||
+		eh->e_machine != EM_MIPS || eh->e_type != ET_EXEC ||
+		eh->e_phentsize != sizeof(Elf32_Phdr_t) ||
+		eh->e_phoff + (size_t)eh->e_phnum * sizeof(Elf32_Phdr_t) > size) {
+		fprintf(stderr, "%s: not a MIPS-I executable\n", argv[i + 1]);
+		free(data);
+		return 1;
+	}
+
+	if((fd = serial_open(argv[i], baud)) < 0) {
+		free(data);
+		return 1;
+	}
+
+	/* Send differing blocks, then check all segments again */
+	for(pass = 0; pass < 2; ++pass) {
+		for(ph = 0; ph < eh->e_phnum; ++ph) {
+			const Elf32_Phdr_t *p = (const Elf32_Phdr_t*)&data[eh->e_phoff] + ph;
+
+			if(p->p_type != PT_LOAD || !p->p_memsz)
+				continue;
+
+			if(p->p_offset + p->p_filesz > size) {
+				fprintf(stderr, "%s: truncated file\n", argv[i + 1]);
+				goto failed;
+			}
+
+			if(p->p_filesz) {
+				r = load_segment(fd, argv[i + 1], data, p, blk_sz, gap, pass);
+				if(r < 0)
+					goto failed;
+
+				sent += r;
+				total += (pass ? 0 : p->p_filesz);
+			}
+
+			/* Zero-initialized data (.bss) is not stored in the file */
+			if(p->p_memsz > p->p_filesz &&
+				zero_segment(fd, p, blk_sz, pass) < 0)
+				goto failed;
+		}
+	}
+
+	fprintf(stderr, "Sent %ld of %ld bytes.\n", sent, total);
+
+	if(run) {
+		char cmd[32];
+		snprintf(cmd, sizeof(cmd), "jmp 0x%x\r", eh->e_entry);
+		serial_write(fd, cmd, strlen(cmd));
+		serial_drain(fd);
+	}
+
+	serial_close(fd);
+	free(data);
+
+	return 0;
+
+failed:
+	serial_close(fd);
+	free(data);
+
+	return 1;
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * LZ compressor for the boot ROM "xelfz" and "yelfz" commands.
+ *
+ * Produces LZ4 sequences with match offsets limited to the decoder window
+ * (see boot/include/lz_stream.h). Output is verified with the boot ROM
+ * decoder before it is written.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lz_stream.h>
+
+
+#define HASH_LOG	16	/* Hash table size log2 */
+#define MAX_CHAIN	256	/* Maximum match candidates to check */
+#define DEF_WLOG	12	/* Default window log2 (CONFIG_LZ_WINDOW_SZ) */
+
+
+/* Compressor state */
+struct lz_enc {
+	const unsigned char *src;
+	size_t size;
+	size_t win;		/* Maximum match offset */
+	long *head;		/* Last position for hash */
+	long *prev;		/* Previous position with the same hash */
+	unsigned char *dst;
+	size_t dpos;
+};
+
+
+static unsigned hash4(const unsigned char *p)
+{
+	unsigned v = p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24);
+	return (v * 2654435761u) >> (32 - HASH_LOG);
+}
+
+
+/* Add position to hash chains */
+static void insert(struct lz_enc *e, size_t pos)
+{
+	unsigned h;
+
+	if(pos + LZS_MIN_MATCH > e->size)
+		return;
+
+	h = hash4(&e->src[pos]);
+	e->prev[pos] = e->head[h];
+	e->head[h] = pos;
+}
+
+
+/* Find longest match for position. Returns match length, 0 if none. */
+static size_t find_match(struct lz_enc *e, size_t pos, size_t *offset)
+{
+	size_t best = 0, n;
+	long cand;
+	int depth = MAX_CHAIN;
+
+	if(pos + LZS_MIN_MATCH > e->size)
+		return 0;
+
+	cand = e->head[hash4(&e->src[pos])];
+	while(cand >= 0 && pos - cand <= e->win && depth--) {
+		for(n = 0; pos + n < e->size && e->src[cand + n] == e->src[pos + n]; ++n)
+			;
+		if(n > best) {
+			best = n;
+			*offset = pos - cand;
+		}
+		cand = e->prev[cand];
+	}
+
+	return best >= LZS_MIN_MATCH ? best : 0;
+}
+
+
+/* Write length extension bytes */
+static void put_len(struct lz_enc *e, size_t len)
+{
+	while(len >= 0xFF) {
+		e->dst[e->dpos++] = 0xFF;
+		len -= 0xFF;
+	}
+	e->dst[e->dpos++] = len;
+}
+
+
+/* Write sequence: literals followed by optional match */
+static void put_seq(struct lz_enc *e, size_t lit, size_t lit_len, size_t offset, size_t mlen)
+{
+	size_t ml = mlen ? mlen - LZS_MIN_MATCH : 0;
+
+	e->dst[e->dpos++] = ((lit_len < 0xF ? lit_len : 0xF) << 4) | (ml < 0xF ? ml : 0xF);
+	if(lit_len >= 0xF)
+		put_len(e, lit_len - 0xF);
+
+	memcpy(&e->dst[e->dpos], &e->src[lit], lit_len);
+	e->dpos += lit_len;
+
+	if(mlen) {
+		e->dst[e->dpos++] = offset;
+		e->dst[e->dpos++] = offset >> 8;
+		if(ml >= 0xF)
+			put_len(e, ml - 0xF);
+	}
+}
+
+
+/* Compress data. Returns compressed stream size or 0 on error. */
+static size_t compress(struct lz_enc *e, unsigned wlog)
+{
+	size_t pos = 0, anchor = 0;
+	size_t len, offset = 0;
+	size_t len1, off1 = 0;
+	unsigned i;
+
+	e->win = ((size_t)1 << wlog) - 1;
+	if(e->win > 0xFFFF)
+		e->win = 0xFFFF;
+
+	e->head = (long*)malloc(sizeof(long) << HASH_LOG);
+	e->prev = (long*)malloc(sizeof(long) * (e->size + 1));
+	e->dst = (unsigned char*)malloc(LZS_HDR_SZ + e->size + e->size / 128 + 16);
+	if(!e->head || !e->prev || !e->dst)
+		return 0;
+
+	for(i = 0; i < (1u << HASH_LOG); ++i)
+		e->head[i] = -1;
+
+	/* Header */
+	memcpy(e->dst, LZS_MAGIC, 4);
+	e->dst[4] = wlog;
+	e->dst[5] = e->dst[6] = e->dst[7] = 0;
+	for(i = 0; i < 4; ++i)
+		e->dst[8 + i] = e->size >> (8 * i);
+	e->dpos = LZS_HDR_SZ;
+
+	/* Greedy parsing with one step lazy evaluation */
+	while(pos < e->size) {
+		len = find_match(e, pos, &offset);
+		insert(e, pos);
+
+		if(!len) {
+			++pos;
+			continue;
+		}
+
+		/* Longer match at the next position wins */
+		len1 = find_match(e, pos + 1, &off1);
+		if(len1 > len) {
+			insert(e, ++pos);
+			len = len1;
+			offset = off1;
+		}
+
+		put_seq(e, anchor, pos - anchor, offset, len);
+		for(i = 1; i < len; ++i)
+			insert(e, pos + i);
+		pos += len;
+		anchor = pos;
+	}
+
+	/* Last literals */
+	if(anchor < e->size)
+		put_seq(e, anchor, e->size - anchor, 0, 0);
+
+	return e->dpos;
+}
+
+
+/* Decoder output check */
+struct verify {
+	const unsigned char *data;
+	size_t pos;
+	size_t size;
+};
+
+static int verify_out(void *udata, void *buf, size_t sz)
+{
+	struct verify *v = (struct verify*)udata;
+
+	if(v->pos + sz > v->size || memcmp(v->data + v->pos, buf, sz))
+		return 1;
+	v->pos += sz;
+
+	return 0;
+}
+
+
+/* Decode stream with the boot ROM decoder and compare with source */
+static int verify(const unsigned char *src, size_t size, const unsigned char *lz,
+	size_t lz_size, unsigned wlog)
+{
+	struct lz_stream ls;
+	struct verify v;
+	char *win = (char*)malloc((size_t)1 << wlog);
+	size_t i;
+	int r = 0;
+
+	if(!win)
+		return -1;
+
+	v.data = src;
+	v.pos = 0;
+	v.size = size;
+	lz_stream_init(&ls, win, (size_t)1 << wlog, verify_out, &v);
+
+	/* Feed in XModem sized portions */
+	for(i = 0; i < lz_size && !r; i += 1024)
+		r = lz_stream_feed(&ls, lz + i, lz_size - i < 1024 ? lz_size - i : 1024);
+
+	free(win);
+
+	return (r || !lz_stream_done(&ls) || v.pos != size) ? -1 : 0;
+}
+
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-w <log2>] <input> <output>\n"
+		"  -w <log2>  - window size log2, 8 to 16 (default %d, must not exceed\n"
+		"               boot ROM CONFIG_LZ_WINDOW_SZ).\n", prog, DEF_WLOG);
+}
+
+
+int main(int argc, char **argv)
+{
+	unsigned wlog = DEF_WLOG;
+	struct lz_enc e;
+	unsigned char *data;
+	size_t lz_size;
+	long sz;
+	FILE *f;
+	int i;
+
+	for(i = 1; i < argc && argv[i][0] == '-'; ++i) {
+		if(!strcmp(argv[i], "-w") && i + 1 < argc)
+			wlog = atoi(argv[++i]);
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(argc - i != 2 || wlog < 8 || wlog > 16) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	/* Read input */
+	if(!(f = fopen(argv[i], "rb"))) {
+		perror(argv[i]);
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	sz = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	data = (unsigned char*)malloc(sz > 0 ? sz : 1);
+	if(!data || (sz > 0 && fread(data, 1, sz, f) != (size_t)sz)) {
+		fprintf(stderr, "%s: read error\n", argv[i]);
+		fclose(f);
+		return 1;
+	}
+	fclose(f);
+
+	memset(&e, 0, sizeof(e));
+	e.src = data;
+	e.size = sz;
+
+	if(!(lz_size = compress(&e, wlog))) {
+		fprintf(stderr, "Out of memory.\n");
+		return 1;
+	}
+
+	if(verify(data, e.size, e.dst, lz_size, wlog) < 0) {
+		fprintf(stderr, "Verification failed.\n");
+		return 1;
+	}
+
+	/* Write output */
+	if(!(f = fopen(argv[i + 1], "wb"))) {
+		perror(argv[i + 1]);
+		return 1;
+	}
+	if(fwrite(e.dst, 1, lz_size, f) != lz_size || fclose(f)) {
+		fprintf(stderr, "%s: write error\n", argv[i + 1]);
+		return 1;
+	}
+
+	fprintf(stderr, "%lu -> %lu bytes (%.1f%%), window %u bytes.\n",
+		(unsigned long)e.size, (unsigned long)lz_size,
+		e.size ? lz_size * 100.0 / e.size : 0.0, 1u << wlog);
+
+	free(e.head);
+	free(e.prev);
+	free(e.dst);
+	free(data);
+
+	return 0;
+}
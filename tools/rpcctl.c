@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Boot ROM binary RPC client.
+ *
+ * Operations given on the command line are executed in order. Read and
+ * write data is split into requests. Requests are sent without waiting
+ * for responses while they fit the ROM's UART receive FIFO, lost or
+ * corrupted requests are repeated.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <rpc.h>
+#include <crc16_ccitt.h>
+#include "serial.h"
+#include "ymodem.h"
+
+
+#define FRAME_SZ(len)	(RPC_HDR_SZ + (len) + 2)	/* Frame size for payload length */
+#define WINDOW		256				/* UART receive FIFO size in ROM */
+#define MAX_RETRIES	10				/* Attempts per request */
+
+
+/* Request */
+struct req {
+	unsigned char cmd;
+	unsigned char payload[RPC_MAX_LEN];
+	size_t len;
+	unsigned char *rbuf;	/* Response data destination */
+	size_t rlen;		/* Expected response data length */
+	unsigned tmo_ms;	/* Response timeout */
+	int barrier;		/* Slow request, do not overlap with others */
+};
+
+
+/* Current sequence number */
+static unsigned char seq_no;
+
+
+static void put32(unsigned char *p, unsigned long v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+
+/* Send request frame */
+static int send_frame(int fd, unsigned cmd, unsigned seq, const unsigned char *data, size_t len)
+{
+	unsigned char buf[FRAME_SZ(RPC_MAX_LEN)];
+	crc16_t crc;
+
+	buf[0] = RPC_SYNC_REQ;
+	buf[1] = cmd;
+	buf[2] = seq;
+	buf[3] = len;
+	buf[4] = len >> 8;
+	memcpy(&buf[RPC_HDR_SZ], data, len);
+
+	crc = crc16_ccitt((const char*)&buf[1], RPC_HDR_SZ - 1 + len);
+	buf[RPC_HDR_SZ + len] = crc >> 8;
+	buf[RPC_HDR_SZ + len + 1] = crc;
+
+	return serial_write(fd, buf, FRAME_SZ(len));
+}
+
+
+/* Receive response frame. Returns 0 on success or -1 on timeout or error. */
+static int recv_frame(int fd, int timeout_ms, unsigned *status, unsigned *seq,
+	unsigned char *data, size_t *len)
+{
+	long long end = serial_time_ms() + timeout_ms;
+	unsigned char hdr[RPC_HDR_SZ - 1];
+	crc16_t crc;
+	size_t i;
+	int ch;
+
+	/* Frame start */
+	do {
+		long long left = end - serial_time_ms();
+		if(left <= 0 || (ch = serial_getc(fd, (int)left)) < 0)
+			return -1;
+	} while(ch != RPC_SYNC_RSP);
+
+	for(i = 0; i < sizeof(hdr); ++i) {
+		if((ch = serial_getc(fd, 200)) < 0)
+			return -1;
+		hdr[i] = ch;
+	}
+
+	*status = hdr[0];
+	*seq = hdr[1];
+	*len = hdr[2] | (hdr[3] << 8);
+	if(*len > RPC_MAX_DATA)
+		return -1;
+
+	for(i = 0; i < *len; ++i) {
+		if((ch = serial_getc(fd, 200)) < 0)
+			return -1;
+		data[i] = ch;
+	}
+
+	if((ch = serial_getc(fd, 200)) < 0)
+		return -1;
+	crc = ch << 8;
+	if((ch = serial_getc(fd, 200)) < 0)
+		return -1;
+	crc |= ch;
+
+	if(crc16_ccitt_update((const char*)data, *len,
+		crc16_ccitt((const char*)hdr, sizeof(hdr))) != crc)
+		return -1;
+
+	return 0;
+}
+
+
+/* Execute requests. Returns 0 on success. */
+static int run_reqs(int fd, struct req *r, size_t n)
+{
+	unsigned char data[RPC_MAX_DATA];
+	unsigned char seq0 = seq_no;
+	size_t base = 0, next = 0, inflight = 0, len;
+	unsigned status, seq;
+	int retries = 0;
+
+	while(base < n) {
+		/* Fill the window, slow requests go alone. Requests behind the
+		 * one being served wait in the ROM's UART receive FIFO while it
+		 * sends responses, so they must fit there.
+		 */
+		while(next < n && (next == base || (!r[next].barrier && !r[next - 1].barrier &&
+			inflight - FRAME_SZ(r[base].len) + FRAME_SZ(r[next].len) <= WINDOW))) {
+			if(send_frame(fd, r[next].cmd, (unsigned char)(seq0 + next),
+				r[next].payload, r[next].len) < 0)
+				return -1;
+			inflight += FRAME_SZ(r[next].len);
+			++next;
+		}
+
+		if(recv_frame(fd, r[base].tmo_ms, &status, &seq, data, &len) == 0 &&
+			seq == (unsigned char)(seq0 + base)) {
+			if(status == RPC_OK && len == r[base].rlen) {
+				if(r[base].rbuf)
+					memcpy(r[base].rbuf, data, len);
+				inflight -= FRAME_SZ(r[base].len);
+				++base;
+				retries = 0;
+				continue;
+			} else if(status == RPC_ERR_CMD || status == RPC_ERR_ARG) {
+				fprintf(stderr, "Request rejected (status %u).\n", status);
+				return -1;
+			}
+		}
+
+		/* Repeat from the first unanswered request */
+		if(++retries > MAX_RETRIES) {
+			fprintf(stderr, "No response.\n");
+			return -1;
+		}
+		serial_flush_input(fd, 300);
+		next = base;
+		inflight = 0;
+	}
+
+	seq_no = seq0 + n;
+
+	return 0;
+}
+
+
+/* Allocate requests */
+static struct req *new_reqs(size_t n)
+{
+	struct req *r = (struct req*)calloc(n ? n : 1, sizeof(struct req));
+	size_t i;
+
+	if(!r) {
+		fprintf(stderr, "Out of memory.\n");
+		return NULL;
+	}
+
+	for(i = 0; i < n; ++i)
+		r[i].tmo_ms = 2000;
+
+	return r;
+}
+
+
+/* Switch boot ROM to RPC mode. Returns 0 on success. */
+static int rpc_start(int fd)
+{
+	unsigned char data[RPC_MAX_DATA];
+	unsigned status, seq;
+	size_t len;
+	int i;
+
+	for(i = 0; i < 3; ++i) {
+		serial_flush_input(fd, 100);
+		serial_write(fd, RPC_MAGIC, sizeof(RPC_MAGIC) - 1);
+
+		if(recv_frame(fd, 1000, &status, &seq, data, &len) == 0 &&
+			status == RPC_OK && len == 4) {
+			if(data[0] != RPC_VERSION) {
+				fprintf(stderr, "Unsupported protocol version %u.\n", data[0]);
+				return -1;
+			}
+			seq_no = seq + 1;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "Boot ROM does not respond.\n");
+
+	return -1;
+}
+
+
+/* Single request. Payload is address, length and byte value, plen bytes
+ * of it are sent.
+ */
+static int simple_req(int fd, unsigned cmd, unsigned long addr, unsigned long len,
+	unsigned value, size_t plen, unsigned char *rbuf, size_t rlen, unsigned tmo_ms)
+{
+	struct req *r = new_reqs(1);
+	int res;
+
+	if(!r)
+		return -1;
+
+	r->cmd = cmd;
+	r->len = plen;
+	put32(r->payload, addr);
+	put32(&r->payload[4], len);
+	r->payload[8] = value;
+	r->rbuf = rbuf;
+	r->rlen = rlen;
+	r->tmo_ms = tmo_ms;
+	r->barrier = 1;
+
+	res = run_reqs(fd, r, 1);
+	free(r);
+
+	return res;
+}
+
+
+/* Read memory to file */
+static int op_read(int fd, unsigned long addr, unsigned long size, const char *name)
+{
+	size_t n = (size + RPC_MAX_DATA - 1) / RPC_MAX_DATA, i;
+	unsigned char *data = (unsigned char*)malloc(size ? size : 1);
+	struct req *r = new_reqs(n);
+	FILE *f;
+	int res = -1;
+
+	if(!data || !r)
+		goto done;
+
+	for(i = 0; i < n; ++i) {
+		size_t off = i * RPC_MAX_DATA;
+		size_t sz = (size - off < RPC_MAX_DATA ? size - off : RPC_MAX_DATA);
+
+		r[i].cmd = RPC_CMD_READ;
+		r[i].len = 8;
+		put32(r[i].payload, addr + off);
+		put32(&r[i].payload[4], sz);
+		r[i].rbuf = &data[off];
+		r[i].rlen = sz;
+	}
+
+	if(run_reqs(fd, r, n) < 0)
+		goto done;
+
+	if(!(f = fopen(name, "wb"))) {
+		perror(name);
+		goto done;
+	}
+	if(fwrite(data, 1, size, f) != size || fclose(f)) {
+		fprintf(stderr, "%s: write error\n", name);
+		goto done;
+	}
+
+	res = 0;
+
+done:
+	free(data);
+	free(r);
+
+	return res;
+}
+
+
+/* Write file to memory */
+static int op_write(int fd, unsigned long addr, const char *name)
+{
+	size_t size, n, i;
+	unsigned char *data = load_file(name, &size);
+	struct req *r = NULL;
+	int res = -1;
+
+	if(!data)
+		return -1;
+
+	n = (size + RPC_MAX_DATA - 1) / RPC_MAX_DATA;
+	if(!(r = new_reqs(n)))
+		goto done;
+
+	for(i = 0; i < n; ++i) {
+		size_t off = i * RPC_MAX_DATA;
+		size_t sz = (size - off < RPC_MAX_DATA ? size - off : RPC_MAX_DATA);
+
+		r[i].cmd = RPC_CMD_WRITE;
+		r[i].len = 4 + sz;
+		put32(r[i].payload, addr + off);
+		memcpy(&r[i].payload[4], &data[off], sz);
+	}
+
+	res = run_reqs(fd, r, n);
+
+done:
+	free(data);
+	free(r);
+
+	return res;
+}
+
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-b <baud>] <port> <op> [<op> ...]\n"
+		"Operations:\n"
+		"  read <addr> <len> <file>  - save memory to file;\n"
+		"  write <addr> <file>       - load file to memory;\n"
+		"  fill <addr> <len> <value> - fill memory with byte value;\n"
+		"  crc <addr> <len>          - print CRC16 of memory;\n"
+		"  jump <addr>               - jump to address (last operation).\n"
+		"  <port>                    - serial device or tcp:[<host>:]<port>.\n", prog);
+}
+
+
+int main(int argc, char **argv)
+{
+	long baud = 115200;
+	int i, fd, res = 0, jumped = 0;
+
+	for(i = 1; i < argc && argv[i][0] == '-'; ++i) {
+		if(!strcmp(argv[i], "-b") && i + 1 < argc)
+			baud = atol(argv[++i]);
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(argc - i < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if((fd = serial_open(argv[i], baud)) < 0)
+		return 1;
+
+	if(rpc_start(fd) < 0) {
+		serial_close(fd);
+		return 1;
+	}
+
+	for(++i; i < argc && !res && !jumped; ) {
+		const char *op = argv[i];
+		int left = argc - i - 1;
+		unsigned long a = left > 0 ? strtoul(argv[i + 1], NULL, 0) : 0;
+		unsigned long b = left > 1 ? strtoul(argv[i + 2], NULL, 0) : 0;
+
+		if(!strcmp(op, "read") && left >= 3) {
+			res = op_read(fd, a, b, argv[i + 3]);
+			i += 4;
+		} else if(!strcmp(op, "write") && left >= 2) {
+			res = op_write(fd, a, argv[i + 2]);
+			i += 3;
+		} else if(!strcmp(op, "fill") && left >= 3) {
+			unsigned v = strtoul(argv[i + 3], NULL, 0);
+			res = simple_req(fd, RPC_CMD_FILL, a, b, v, 9, NULL, 0, 2000 + b / 1000);
+			i += 4;
+		} else if(!strcmp(op, "crc") && left >= 2) {
+			unsigned char crc[2];
+			res = simple_req(fd, RPC_CMD_CRC, a, b, 0, 8, crc, 2, 2000 + b / 1000);
+			if(!res)
+				printf("0x%08lx-0x%08lx: %02x%02x\n", a, a + b - 1, crc[1], crc[0]);
+			i += 3;
+		} else if(!strcmp(op, "jump") && left >= 1) {
+			res = simple_req(fd, RPC_CMD_JUMP, a, 0, 0, 4, NULL, 0, 2000);
+			jumped = 1;
+			i += 2;
+		} else {
+			usage(argv[0]);
+			res = -1;
+		}
+	}
+
+	/* Back to console */
+	if(!jumped)
+		simple_req(fd, RPC_CMD_EXIT, 0, 0, 0, 0, NULL, 0, 2000);
+
+	serial_close(fd);
+
+	return res ? 1 : 0;
+}
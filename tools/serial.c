@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Host serial link to the boot ROM
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "serial.h"
+
+
+/* Baud rate negotiation characters (see boot/src/baud.c) */
+#define SYN	0x16	/* Rate switch / sync reply */
+#define ACK	0x06	/* Host confirmation */
+#define SYNC_CH	0x55	/* Host sync pattern */
+
+
+#ifdef __linux__
+/* Set non-standard baud rate (serial_linux.c) */
+int serial_set_baud_other(int fd, long baud);
+#endif
+
+
+/* Saved device settings */
+static struct termios saved_tio;
+static int saved_fd = -1;
+
+
+/* Supported baud rates */
+static const struct {
+	long baud;
+	speed_t speed;
+} baud_rates[] = {
+	{ 9600, B9600 },
+	{ 19200, B19200 },
+	{ 38400, B38400 },
+	{ 57600, B57600 },
+	{ 115200, B115200 },
+	{ 230400, B230400 },
+#ifdef B460800
+	{ 460800, B460800 },
+#endif
+#ifdef B921600
+	{ 921600, B921600 },
+#endif
+#ifdef B1000000
+	{ 1000000, B1000000 },
+#endif
+#ifdef B1500000
+	{ 1500000, B1500000 },
+#endif
+#ifdef B2000000
+	{ 2000000, B2000000 },
+#endif
+#ifdef B3000000
+	{ 3000000, B3000000 },
+#endif
+};
+
+
+/* Connect to model TCP endpoint */
+static int open_tcp(const char *addr)
+{
+	char host[256] = "127.0.0.1";
+	const char *port = strrchr(addr, ':');
+	struct addrinfo hints, *ai, *p;
+	int fd = -1, one = 1, r;
+
+	if(port) {
+		size_t n = port - addr;
+		if(n >= sizeof(host))
+			n = sizeof(host) - 1;
+		memcpy(host, addr, n);
+		host[n] = 0;
+		++port;
+	} else
+		port = addr;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if((r = getaddrinfo(host, port, &hints, &ai)) != 0) {
+		fprintf(stderr, "%s: %s\n", addr, gai_strerror(r));
+		return -1;
+	}
+
+	for(p = ai; p; p = p->ai_next) {
+		fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+		if(fd < 0)
+			continue;
+		if(!connect(fd, p->ai_addr, p->ai_addrlen))
+			break;
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(ai);
+
+	if(fd < 0) {
+		fprintf(stderr, "%s: connection failed\n", addr);
+		return -1;
+	}
+
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	return fd;
+}
+
+
+int serial_open(const char *spec, long baud)
+{
+	struct termios tio;
+	int fd;
+
+	if(!strncmp(spec, "tcp:", 4))
+		return open_tcp(spec + 4);
+
+	fd = open(spec, O_RDWR | O_NOCTTY);
+	if(fd < 0) {
+		perror(spec);
+		return -1;
+	}
+
+	if(tcgetattr(fd, &tio) < 0) {
+		perror(spec);
+		close(fd);
+		return -1;
+	}
+
+	saved_tio = tio;
+	saved_fd = fd;
+
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+
+	if(tcsetattr(fd, TCSANOW, &tio) < 0 || serial_set_baud(fd, baud) < 0) {
+		fprintf(stderr, "%s: cannot configure device\n", spec);
+		serial_close(fd);
+		return -1;
+	}
+
+	tcflush(fd, TCIOFLUSH);
+
+	return fd;
+}
+
+
+int serial_set_baud(int fd, long baud)
+{
+	struct termios tio;
+	size_t i;
+
+	if(fd != saved_fd)	/* Socket */
+		return 0;
+
+	for(i = 0; i < sizeof(baud_rates) / sizeof(baud_rates[0]); ++i) {
+		if(baud_rates[i].baud == baud)
+			break;
+	}
+
+	if(i == sizeof(baud_rates) / sizeof(baud_rates[0])) {
+#ifdef __linux__
+		/* Boot ROM rates are not standard, set arbitrary rate */
+		if(!serial_set_baud_other(fd, baud))
+			return 0;
+#endif
+		fprintf(stderr, "Unsupported baud rate: %ld\n", baud);
+		return -1;
+	}
+
+	if(tcgetattr(fd, &tio) < 0)
+		return -1;
+
+	cfsetispeed(&tio, baud_rates[i].speed);
+	cfsetospeed(&tio, baud_rates[i].speed);
+
+	return tcsetattr(fd, TCSADRAIN, &tio);
+}
+
+
+int serial_negotiate_baud(int fd, long baud, long old_baud)
+{
+	long long end;
+	int ch, n = 0;
+
+	/* Wait for switch announce, other output is ignored */
+	end = serial_time_ms() + 3000;
+	while(n < 2 && serial_time_ms() < end) {
+		ch = serial_getc(fd, 100);
+		if(ch >= 0)
+			n = (ch == SYN ? n + 1 : 0);
+	}
+
+	if(n < 2 || serial_set_baud(fd, baud) < 0)
+		return -1;
+
+	/* Send sync pattern until boot ROM replies */
+	n = 0;
+	end = serial_time_ms() + 2000;
+	while(n < 2 && serial_time_ms() < end) {
+		serial_putc(fd, SYNC_CH);
+		while(n < 2 && (ch = serial_getc(fd, 10)) >= 0)
+			n = (ch == SYN ? n + 1 : 0);
+	}
+
+	if(n < 2) {
+		serial_set_baud(fd, old_baud);
+		return -1;
+	}
+
+	serial_putc(fd, ACK);
+
+	return 0;
+}
+
+
+void serial_close(int fd)
+{
+	if(fd < 0)
+		return;
+
+	if(fd == saved_fd) {
+		tcsetattr(fd, TCSADRAIN, &saved_tio);
+		saved_fd = -1;
+	}
+
+	close(fd);
+}
+
+
+int serial_getc(int fd, int timeout_ms)
+{
+	struct pollfd pfd;
+	unsigned char b;
+	int r;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+
+	do {
+		r = poll(&pfd, 1, timeout_ms);
+	} while(r < 0 && errno == EINTR);
+
+	if(r <= 0)
+		return -1;
+
+	do {
+		r = read(fd, &b, 1);
+	} while(r < 0 && errno == EINTR);
+
+	return r == 1 ? b : -1;
+}
+
+
+int serial_write(int fd, const void *buf, size_t n)
+{
+	const unsigned char *p = (const unsigned char*)buf;
+
+	while(n) {
+		ssize_t r = write(fd, p, n);
+		if(r < 0 && errno == EINTR)
+			continue;
+		else if(r <= 0)
+			return -1;
+		p += r;
+		n -= r;
+	}
+
+	return 0;
+}
+
+
+void serial_drain(int fd)
+{
+	if(fd == saved_fd)
+		tcdrain(fd);
+}
+
+
+void serial_flush_input(int fd, int timeout_ms)
+{
+	while(serial_getc(fd, timeout_ms) >= 0)
+		;
+}
+
+
+long long serial_time_ms(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
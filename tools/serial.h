@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Host serial link to the boot ROM: serial device or model TCP socket.
+ */
+
+#ifndef _TOOLS_SERIAL_H_
+#define _TOOLS_SERIAL_H_
+
+#include <stddef.h>
+
+
+/* Open serial link. Spec is a device path or "tcp:[<host>:]<port>" for the
+ * Verilated model UART endpoint. Baud rate is ignored for sockets.
+ * Returns file descriptor or -1 on error (reported to stderr).
+ */
+int serial_open(const char *spec, long baud);
+
+
+/* Change baud rate of open link. Returns 0 on success. */
+int serial_set_baud(int fd, long baud);
+
+
+/* Switch boot ROM and link to new baud rate. Boot ROM command that starts
+ * negotiation must be sent before. Returns 0 on success or -1 if link stays
+ * at old baud rate.
+ */
+int serial_negotiate_baud(int fd, long baud, long old_baud);
+
+
+/* Close link and restore device settings */
+void serial_close(int fd);
+
+
+/* Receive byte within timeout in milliseconds. Returns -1 on timeout. */
+int serial_getc(int fd, int timeout_ms);
+
+
+/* Send buffer. Returns 0 on success. */
+int serial_write(int fd, const void *buf, size_t n);
+
+
+/* Send byte. Returns 0 on success. */
+static inline int serial_putc(int fd, int ch)
+{
+	unsigned char b = ch;
+	return serial_write(fd, &b, 1);
+}
+
+
+/* Wait until all output is transmitted */
+void serial_drain(int fd);
+
+
+/* Discard received data until the line is idle for timeout_ms */
+void serial_flush_input(int fd, int timeout_ms);
+
+
+/* Milliseconds since an arbitrary point */
+long long serial_time_ms(void);
+
+
+#endif /* _TOOLS_SERIAL_H_ */
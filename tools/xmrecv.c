@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * XModem-1K receiver for the boot ROM "xsend" command.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <crc16_ccitt.h>
+#include "serial.h"
+#include "ymodem.h"
+
+
+/* Protocol characters */
+#define SOH	0x01	/* Start of Header */
+#define STX	0x02	/* Start of Header (1K) */
+#define EOT	0x04	/* End Of Transmission */
+#define ACK	0x06	/* Acknowledge */
+#define NAK	0x15	/* Not Acknowledge */
+#define CAN	0x18	/* Cancel */
+#define CRQ	0x43	/* Transmission Request (CRC) */
+
+#define MAX_ERRORS	10	/* Consecutive errors before giving up */
+
+
+/* Receive block body after header start. Returns 0 if block is valid. */
+static int recv_block(int fd, unsigned char *blk, size_t blk_sz)
+{
+	size_t i, n = 2 + blk_sz + 2;	/* Number, complement, data, CRC */
+	crc16_t crc;
+	int ch;
+
+	for(i = 0; i < n; ++i) {
+		if((ch = serial_getc(fd, 1000)) < 0)
+			return -1;
+		blk[i] = ch;
+	}
+
+	if(blk[0] != (unsigned char)~blk[1])
+		return -1;
+
+	crc = crc16_ccitt((const char*)&blk[2], blk_sz);
+
+	return (blk[2 + blk_sz] == (crc >> 8) && blk[3 + blk_sz] == (crc & 0xFF)) ? 0 : -1;
+}
+
+
+/* Receive data using XModem-1K. Data beyond size is dropped.
+ * Returns received size or -1 on error.
+ */
+static long xm_recv(int fd, unsigned char *data, size_t size)
+{
+	unsigned char blk[2 + 1024 + 2];
+	unsigned char expected = 1;
+	size_t pos = 0;
+	int errors = 0, started = 0, can = 0;
+	int ch;
+
+	serial_putc(fd, CRQ);
+
+	while(1) {
+		ch = serial_getc(fd, started ? 10000 : 1000);
+
+		if(ch < 0) {
+			if(++errors > (started ? MAX_ERRORS : 3 * MAX_ERRORS))
+				break;
+			serial_putc(fd, started ? NAK : CRQ);
+			continue;
+		} else if(ch == EOT) {
+			serial_putc(fd, ACK);
+			return pos;
+		} else if(ch == CAN) {
+			if(can) {
+				fprintf(stderr, "\nTransfer canceled by sender.\n");
+				return -1;
+			}
+			can = 1;
+			continue;
+		}
+
+		can = 0;
+
+		/* Other characters are console output before transfer */
+		if(ch != SOH && ch != STX)
+			continue;
+
+		started = 1;
+
+		if(recv_block(fd, blk, ch == STX ? 1024 : 128) < 0) {
+			if(++errors > MAX_ERRORS)
+				break;
+			serial_flush_input(fd, 100);
+			serial_putc(fd, NAK);
+			continue;
+		}
+
+		errors = 0;
+
+		if(blk[0] == (unsigned char)(expected - 1)) {
+			/* Acknowledge was lost, sender repeats the block */
+			serial_putc(fd, ACK);
+			continue;
+		} else if(blk[0] != expected) {
+			fprintf(stderr, "\nSequence error.\n");
+			break;
+		}
+
+		/* Copy without padding */
+		if(pos < size) {
+			size_t n = (ch == STX ? 1024 : 128);
+			n = (size - pos < n ? size - pos : n);
+			memcpy(&data[pos], &blk[2], n);
+			pos += n;
+		}
+
+		++expected;
+		serial_putc(fd, ACK);
+
+		fprintf(stderr, "\r%lu / %lu bytes", (unsigned long)pos, (unsigned long)size);
+	}
+
+	serial_putc(fd, CAN);
+	serial_putc(fd, CAN);
+
+	return -1;
+}
+
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-b <baud>] [-f <baud>] <port> <addr> <len> <file>\n"
+		"  -b <baud>     - serial port baud rate (default 115200);\n"
+		"  -f <baud>     - negotiate faster baud rate for transfer;\n"
+		"  <port>        - serial device or tcp:[<host>:]<port> for the model;\n"
+		"  <addr> <len>  - memory range to read with boot ROM xsend command.\n", prog);
+}
+
+
+int main(int argc, char **argv)
+{
+	long baud = 115200, fast = 0;
+	unsigned long addr, size;
+	unsigned char *data;
+	char line[256];
+	long long t;
+	long n;
+	FILE *f;
+	int i, fd;
+
+	for(i = 1; i < argc && argv[i][0] == '-'; ++i) {
+		if(!strcmp(argv[i], "-b") && i + 1 < argc)
+			baud = atol(argv[++i]);
+		else if(!strcmp(argv[i], "-f") && i + 1 < argc)
+			fast = atol(argv[++i]);
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(argc - i != 4) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	addr = strtoul(argv[i + 1], NULL, 0);
+	size = strtoul(argv[i + 2], NULL, 0);
+
+	if(!(data = (unsigned char*)malloc(size ? size : 1))) {
+		fprintf(stderr, "Out of memory.\n");
+		return 1;
+	}
+
+	if((fd = serial_open(argv[i], baud)) < 0) {
+		free(data);
+		return 1;
+	}
+
+	/* Start sender */
+	if(fast)
+		snprintf(line, sizeof(line), "xsend 0x%lx %lu %ld\r", addr, size, fast);
+	else
+		snprintf(line, sizeof(line), "xsend 0x%lx %lu\r", addr, size);
+
+	serial_flush_input(fd, 100);
+	serial_write(fd, line, strlen(line));
+
+	/* Switch to transfer baud rate */
+	if(fast && serial_negotiate_baud(fd, fast, baud) < 0) {
+		fprintf(stderr, "Baud rate negotiation failed.\n");
+		serial_close(fd);
+		free(data);
+		return 1;
+	}
+
+	t = serial_time_ms();
+	n = xm_recv(fd, data, size);
+	t = serial_time_ms() - t;
+
+	ym_show_output(fd, fast ? baud : 0);
+
+	if(n >= 0 && (unsigned long)n == size) {
+		fprintf(stderr, "\nReceived %lu bytes in %.2f s (%.0f bytes/s).\n", size,
+			t / 1000.0, t ? size * 1000.0 / t : 0.0);
+		if(!(f = fopen(argv[i + 3], "wb")) || fwrite(data, 1, size, f) != size ||
+			fclose(f)) {
+			perror(argv[i + 3]);
+			n = -1;
+		}
+	} else if(n >= 0) {
+		fprintf(stderr, "\nShort transfer: %ld of %lu bytes.\n", n, size);
+		n = -1;
+	}
+
+	serial_close(fd);
+	free(data);
+
+	return n < 0 ? 1 : 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * YModem-G sender.
+ *
+ * Data blocks are streamed without waiting for acknowledges. Any error
+ * on the receiver side cancels the transfer, there are no retransmissions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <crc16_ccitt.h>
+#include "serial.h"
+#include "ymodem.h"
+
+
+/* Protocol characters */
+#define SOH	0x01	/* Start of Header */
+#define STX	0x02	/* Start of Header (1K) */
+#define EOT	0x04	/* End Of Transmission */
+#define ACK	0x06	/* Acknowledge */
+#define NAK	0x15	/* Not Acknowledge */
+#define CAN	0x18	/* Cancel */
+#define CRG	0x47	/* Transmission Request (YModem-G) */
+#define CPMEOF	0x1A	/* Padding */
+
+
+/* Send block. Data shorter than block size is padded. */
+static int send_block(int fd, unsigned char no, const unsigned char *data, size_t n,
+	size_t blk_sz, unsigned char pad)
+{
+	unsigned char blk[3 + 1024 + 2];
+	crc16_t crc;
+
+	blk[0] = (blk_sz == 1024 ? STX : SOH);
+	blk[1] = no;
+	blk[2] = ~no;
+	memcpy(&blk[3], data, n);
+	memset(&blk[3 + n], pad, blk_sz - n);
+
+	crc = crc16_ccitt((const char*)&blk[3], blk_sz);
+	blk[3 + blk_sz] = crc >> 8;
+	blk[4 + blk_sz] = crc;
+
+	return serial_write(fd, blk, blk_sz + 5);
+}
+
+
+/* Wait for expected character, other characters are ignored.
+ * Returns 0 on success, CAN if canceled, -1 on timeout.
+ */
+static int wait_for(int fd, int ch, int timeout_ms)
+{
+	long long end = serial_time_ms() + timeout_ms;
+	int can = 0;
+
+	while(1) {
+		long long left = end - serial_time_ms();
+		int r;
+
+		if(left <= 0)
+			return -1;
+
+		r = serial_getc(fd, (int)left);
+		if(r == ch)
+			return 0;
+		else if(r == CAN && can)
+			return CAN;
+
+		can = (r == CAN);
+	}
+}
+
+
+/* Print receiver output until the line is idle. Receiver flushes input for 1 s
+ * after transfer before reporting status. Switches back to initial baud
+ * rate first if it was changed for transfer.
+ */
+void ym_show_output(int fd, long baud)
+{
+	int ch;
+
+	if(baud) {
+		serial_drain(fd);
+		serial_set_baud(fd, baud);
+	}
+
+	while((ch = serial_getc(fd, 1500)) >= 0) {
+		if(ch != CAN)
+			putchar(ch);
+	}
+	fflush(stdout);
+}
+
+
+/* Load file to memory */
+unsigned char *load_file(const char *name, size_t *size)
+{
+	unsigned char *data;
+	long sz;
+	FILE *f;
+
+	f = fopen(name, "rb");
+	if(!f) {
+		perror(name);
+		return NULL;
+	}
+
+	fseek(f, 0, SEEK_END);
+	sz = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	data = (unsigned char*)malloc(sz > 0 ? sz : 1);
+	if(!data || (sz > 0 && fread(data, 1, sz, f) != (size_t)sz)) {
+		fprintf(stderr, "%s: read error\n", name);
+		free(data);
+		fclose(f);
+		return NULL;
+	}
+
+	fclose(f);
+	*size = sz;
+
+	return data;
+}
+
+
+/* Send file using YModem-G. Returns exit code. */
+int ymg_send(int fd, const char *name, const unsigned char *data, size_t size,
+	long restore)
+{
+	unsigned char hdr[128];
+	const char *base = strrchr(name, '/');
+	size_t pos = 0, n;
+	unsigned char blk = 1;
+	long long t;
+	int r, i;
+
+	/* Wait for streaming request */
+	fprintf(stderr, "Waiting for receiver...\n");
+	if((r = wait_for(fd, CRG, 60000)) != 0)
+		goto failed;
+
+	/* File header: name, NUL, decimal size */
+	base = base ? base + 1 : name;
+	memset(hdr, 0, sizeof(hdr));
+	snprintf((char*)hdr, sizeof(hdr) - 16, "%s", base);
+	n = strlen((char*)hdr) + 1;
+	snprintf((char*)&hdr[n], sizeof(hdr) - n, "%lu", (unsigned long)size);
+
+	t = serial_time_ms();
+
+	if(send_block(fd, 0, hdr, sizeof(hdr), sizeof(hdr), 0) < 0 ||
+		(r = wait_for(fd, CRG, 10000)) != 0)
+		goto failed;
+
+	/* Stream data */
+	while(pos < size) {
+		size_t blk_sz = (size - pos > 128 ? 1024 : 128);
+
+		n = (size - pos < blk_sz ? size - pos : blk_sz);
+		if(send_block(fd, blk++, data + pos, n, blk_sz, CPMEOF) < 0) {
+			r = -1;
+			goto failed;
+		}
+		pos += n;
+
+		/* Check for cancellation */
+		if(serial_getc(fd, 0) == CAN) {
+			r = CAN;
+			goto failed;
+		}
+
+		fprintf(stderr, "\r%lu / %lu bytes", (unsigned long)pos, (unsigned long)size);
+	}
+	fprintf(stderr, "\n");
+
+	/* End of file */
+	for(i = 0; i < 5; ++i) {
+		serial_putc(fd, EOT);
+		if((r = wait_for(fd, ACK, 10000)) != -1)
+			break;
+	}
+	if(r != 0)
+		goto failed;
+
+	t = serial_time_ms() - t;
+
+	/* End of batch */
+	memset(hdr, 0, sizeof(hdr));
+	if((r = wait_for(fd, CRG, 10000)) != 0 ||
+		send_block(fd, 0, hdr, sizeof(hdr), sizeof(hdr), 0) < 0 ||
+		(r = wait_for(fd, ACK, 10000)) != 0)
+		goto failed;
+
+	fprintf(stderr, "Sent %lu bytes in %.2f s (%.0f bytes/s).\n", (unsigned long)size,
+		t / 1000.0, t ? size * 1000.0 / t : 0.0);
+	ym_show_output(fd, restore);
+
+	return YM_OK;
+
+failed:
+	if(r == CAN) {
+		/* Receiver stops on errors and after "yelf" loaded all segments */
+		fprintf(stderr, "\nTransfer stopped by receiver after %lu of %lu bytes.\n",
+			(unsigned long)pos, (unsigned long)size);
+		ym_show_output(fd, restore);
+		return YM_STOPPED;
+	}
+
+	fprintf(stderr, "\nReceiver timeout.\n");
+	serial_putc(fd, CAN);
+	serial_putc(fd, CAN);
+	ym_show_output(fd, restore);
+
+	return YM_FAIL;
+}
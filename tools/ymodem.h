@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * YModem-G sender.
+ */
+
+#ifndef _TOOLS_YMODEM_H_
+#define _TOOLS_YMODEM_H_
+
+#include <stddef.h>
+
+
+/* Transfer status. Values are used as tool exit codes. */
+#define YM_OK		0	/* Transfer completed */
+#define YM_FAIL		1	/* Transfer failed */
+#define YM_STOPPED	2	/* Receiver stopped transfer (e.g. "yelf" loaded all segments) */
+
+
+/* Load file to memory. Returns allocated buffer or NULL on error. */
+unsigned char *load_file(const char *name, size_t *size);
+
+
+/* Print receiver output until the line is idle. Switches back to initial
+ * baud rate first if it is not zero.
+ */
+void ym_show_output(int fd, long baud);
+
+
+/* Send data as file using YModem-G. Receiver output is printed after
+ * transfer. Restore is the baud rate to switch back to (0 - unchanged).
+ * Returns transfer status.
+ */
+int ymg_send(int fd, const char *name, const unsigned char *data, size_t size,
+	long restore);
+
+
+#endif /* _TOOLS_YMODEM_H_ */
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2018-2019 The UltiSoC Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * YModem-G sender for the boot ROM "ymodem" and "yelf" commands.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "serial.h"
+#include "ymodem.h"
+
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-b <baud>] [-c <command> [-f <baud>]] <port> <file>\n"
+		"  -b <baud>     - serial port baud rate (default 115200);\n"
+		"  -c <command>  - boot ROM command to start receiver (e.g. yelf);\n"
+		"  -f <baud>     - negotiate faster baud rate for transfer;\n"
+		"  <port>        - serial device or tcp:[<host>:]<port> for the model.\n"
+		"Exit codes: 0 - done, 1 - failed, 2 - stopped by receiver.\n", prog);
+}
+
+
+int main(int argc, char **argv)
+{
+	const char *cmd = NULL;
+	long baud = 115200, fast = 0;
+	char line[256];
+	unsigned char *data;
+	size_t size;
+	int i, fd, r;
+
+	for(i = 1; i < argc && argv[i][0] == '-'; ++i) {
+		if(!strcmp(argv[i], "-b") && i + 1 < argc)
+			baud = atol(argv[++i]);
+		else if(!strcmp(argv[i], "-c") && i + 1 < argc)
+			cmd = argv[++i];
+		else if(!strcmp(argv[i], "-f") && i + 1 < argc)
+			fast = atol(argv[++i]);
+		else {
+			usage(argv[0]);
+			return YM_FAIL;
+		}
+	}
+
+	if(argc - i != 2 || (fast && !cmd)) {
+		usage(argv[0]);
+		return YM_FAIL;
+	}
+
+	if(!(data = load_file(argv[i + 1], &size)))
+		return YM_FAIL;
+
+	if((fd = serial_open(argv[i], baud)) < 0) {
+		free(data);
+		return YM_FAIL;
+	}
+
+	/* Start receiver */
+	if(cmd) {
+		if(fast)
+			snprintf(line, sizeof(line), "%s %ld\r", cmd, fast);
+		else
+			snprintf(line, sizeof(line), "%s\r", cmd);
+
+		serial_flush_input(fd, 100);
+		serial_write(fd, line, strlen(line));
+	}
+
+	/* Switch to transfer baud rate */
+	if(fast && serial_negotiate_baud(fd, fast, baud) < 0) {
+		fprintf(stderr, "Baud rate negotiation failed.\n");
+		serial_close(fd);
+		free(data);
+		return YM_FAIL;
+	}
+
+	r = ymg_send(fd, argv[i + 1], data, size, fast ? baud : 0);
+
+	serial_close(fd);
+	free(data);
+
+	return r;
+}